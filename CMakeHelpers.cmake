@@ -34,3 +34,16 @@ macro(helper_FIND_GTEST_LIBS)
     # Download and make gtest/gmock available
     FetchContent_MakeAvailable(googletest)
 endmacro()
+
+# Helper macro to find google benchmark library
+macro(helper_FIND_BENCHMARK_LIBS)
+    include(FetchContent)
+    set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+    set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "" FORCE)
+    FetchContent_Declare(
+      benchmark
+      URL https://github.com/google/benchmark/archive/refs/tags/v1.8.3.zip
+    )
+    # Download and make google benchmark available
+    FetchContent_MakeAvailable(benchmark)
+endmacro()
@@ -0,0 +1,187 @@
+#include "xapi/IConnection.hpp"
+#include "xapi/XStationClient.hpp"
+#include <benchmark/benchmark.h>
+#include <boost/json.hpp>
+#include <string>
+
+using namespace xapi;
+
+namespace
+{
+
+const std::string symbol = "EURUSD";
+const std::vector<std::string> symbols = {"EURUSD", "US100", "DE30", "GOLD"};
+const std::vector<int> orders = {7489839, 7489841, 7489843};
+const std::string streamSession = "8469308861804289383";
+
+/**
+ * @brief Connection rendering every command it is given and answering immediately, to measure
+ * the commands built by the client and stream methods.
+ */
+class CapturingConnection final : public internals::IConnection
+{
+  public:
+    // With dom set, commands are rendered through a JSON DOM, as before the direct serializer.
+    explicit CapturingConnection(bool dom = false)
+        : m_dom(dom), m_tag(0), m_frame(),
+          m_loginResponse{{"status", true}, {"streamSessionId", streamSession}}
+    {
+    }
+
+    boost::asio::awaitable<void> connect(const boost::url &) override
+    {
+        co_return;
+    }
+
+    boost::asio::awaitable<void> disconnect() override
+    {
+        co_return;
+    }
+
+    boost::asio::awaitable<void> makeRequest(const internals::Command &command) override
+    {
+        render(command);
+        co_return;
+    }
+
+    boost::asio::awaitable<boost::json::object> waitResponse() override
+    {
+        co_return boost::json::object();
+    }
+
+    boost::asio::awaitable<std::string_view> waitFrame() override
+    {
+        co_return std::string_view(m_frame);
+    }
+
+    // Renders the command into a reused buffer with a tag, as Connection::request() does.
+    boost::asio::awaitable<boost::json::object> request(const internals::Command &command) override
+    {
+        render(command);
+        co_return command.name() == "login" ? m_loginResponse : boost::json::object();
+    }
+
+    const std::string &frame() const noexcept
+    {
+        return m_frame;
+    }
+
+  private:
+    void render(const internals::Command &command)
+    {
+        if (m_dom)
+        {
+            boost::json::object json = command.toJson();
+            json["customTag"] = std::to_string(++m_tag);
+            m_frame = boost::json::serialize(json);
+            return;
+        }
+        m_frame.clear();
+        command.writeTo(m_frame, ++m_tag);
+    }
+
+    bool m_dom;
+    std::uint64_t m_tag;
+    std::string m_frame;
+    boost::json::object m_loginResponse;
+};
+
+// Calls a client method in a loop on the client strand, so that the requests do not hop.
+template <typename Call> void BM_Client(::benchmark::State &state, Call call, bool dom)
+{
+    boost::asio::io_context context;
+    auto connection = std::make_unique<CapturingConnection>(dom);
+    CapturingConnection &captured = *connection;
+    XStationClient client(context, std::move(connection));
+    client.setSafeMode(false);
+
+    std::exception_ptr error;
+    boost::asio::co_spawn(
+        client.executor(),
+        [&state, &client, &captured, &call]() -> boost::asio::awaitable<void> {
+            for (auto _ : state)
+            {
+                co_await call(client);
+                ::benchmark::DoNotOptimize(captured.frame().data());
+            }
+        },
+        [&error](std::exception_ptr e) { error = e; });
+    context.run();
+    if (error)
+    {
+        state.SkipWithError("Request failed");
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * captured.frame().size()));
+}
+
+// Calls a stream method in a loop, the stream sends the commands without waiting for a response.
+template <typename Call> void BM_Stream(::benchmark::State &state, Call call, bool dom)
+{
+    boost::asio::io_context context;
+    auto connection = std::make_unique<CapturingConnection>(dom);
+    CapturingConnection &captured = *connection;
+    XStationClientStream stream(std::move(connection));
+    stream.setStreamSessionId(streamSession);
+
+    std::exception_ptr error;
+    boost::asio::co_spawn(
+        context,
+        [&state, &stream, &captured, &call]() -> boost::asio::awaitable<void> {
+            for (auto _ : state)
+            {
+                co_await call(stream);
+                ::benchmark::DoNotOptimize(captured.frame().data());
+            }
+        },
+        [&error](std::exception_ptr e) { error = e; });
+    context.run();
+    if (error)
+    {
+        state.SkipWithError("Request failed");
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * captured.frame().size()));
+}
+
+const auto login = [](XStationClient &client) { return client.login(); };
+const auto getVersion = [](XStationClient &client) { return client.getVersion(); };
+const auto getChartLastRequest = [](XStationClient &client) {
+    return client.getChartLastRequest(symbol, 1262944112000, PeriodCode::PERIOD_M1);
+};
+const auto getChartRangeRequest = [](XStationClient &client) {
+    return client.getChartRangeRequest(symbol, 1262944112000, 1262944412000, PeriodCode::PERIOD_M1, 0);
+};
+const auto getCommissionDef = [](XStationClient &client) { return client.getCommissionDef(symbol, 1.0f); };
+const auto getProfitCalculation = [](XStationClient &client) {
+    return client.getProfitCalculation(symbol, 0, 1.2233f, 1.3f, 1.0f);
+};
+const auto getTickPrices = [](XStationClient &client) { return client.getTickPrices(symbols, 1262944112000, 0); };
+const auto getTradeRecords = [](XStationClient &client) { return client.getTradeRecords(orders); };
+const auto tradeTransaction = [](XStationClient &client) {
+    return client.tradeTransaction(symbol, TradeCmd::BUY, TradeType::OPEN, 1.12f, 5.0f, 0.0f, 0.0f, 82188055,
+                                   1462006335000, 0, "Some text");
+};
+
+const auto streamGetTickPrices = [](XStationClientStream &stream) { return stream.getTickPrices(symbol, 0, 2); };
+const auto streamGetCandles = [](XStationClientStream &stream) { return stream.getCandles(symbol); };
+const auto streamStopTickPrices = [](XStationClientStream &stream) { return stream.stopTickPrices(symbol); };
+
+// Builds the command in the client or stream method and renders it into a reused buffer.
+BENCHMARK_CAPTURE(BM_Client, login, login, false);
+BENCHMARK_CAPTURE(BM_Client, getVersion, getVersion, false);
+BENCHMARK_CAPTURE(BM_Client, getChartLastRequest, getChartLastRequest, false);
+BENCHMARK_CAPTURE(BM_Client, getChartRangeRequest, getChartRangeRequest, false);
+BENCHMARK_CAPTURE(BM_Client, getCommissionDef, getCommissionDef, false);
+BENCHMARK_CAPTURE(BM_Client, getProfitCalculation, getProfitCalculation, false);
+BENCHMARK_CAPTURE(BM_Client, getTickPrices, getTickPrices, false);
+BENCHMARK_CAPTURE(BM_Client, getTradeRecords, getTradeRecords, false);
+BENCHMARK_CAPTURE(BM_Client, tradeTransaction, tradeTransaction, false);
+BENCHMARK_CAPTURE(BM_Stream, streamGetTickPrices, streamGetTickPrices, false);
+BENCHMARK_CAPTURE(BM_Stream, streamGetCandles, streamGetCandles, false);
+BENCHMARK_CAPTURE(BM_Stream, streamStopTickPrices, streamStopTickPrices, false);
+
+// Baseline: the same methods rendering through a JSON DOM, as before the direct serializer.
+BENCHMARK_CAPTURE(BM_Client, getChartRangeRequestDom, getChartRangeRequest, true);
+BENCHMARK_CAPTURE(BM_Client, tradeTransactionDom, tradeTransaction, true);
+BENCHMARK_CAPTURE(BM_Stream, streamGetTickPricesDom, streamGetTickPrices, true);
+
+} // namespace
@@ -0,0 +1,180 @@
+#include "xapi/IConnection.hpp"
+#include "xapi/RateLimiter.hpp"
+#include "xapi/XStationClientStream.hpp"
+#include <benchmark/benchmark.h>
+#include <string>
+
+using namespace xapi;
+
+namespace
+{
+
+/**
+ * @brief Connection completing every operation immediately, to measure the coroutine layers alone.
+ */
+class ImmediateConnection final : public internals::IConnection
+{
+  public:
+    // waitFrame() returns the frame until the first request replaces it.
+    explicit ImmediateConnection(std::string frame = {}) : m_buffer(std::move(frame))
+    {
+    }
+
+    boost::asio::awaitable<void> connect(const boost::url &) override
+    {
+        co_return;
+    }
+
+    boost::asio::awaitable<void> disconnect() override
+    {
+        co_return;
+    }
+
+    boost::asio::awaitable<void> makeRequest(const internals::Command &command) override
+    {
+        m_buffer.clear();
+        command.writeTo(m_buffer);
+        co_return;
+    }
+
+    boost::asio::awaitable<boost::json::object> waitResponse() override
+    {
+        co_return boost::json::object();
+    }
+
+    boost::asio::awaitable<std::string_view> waitFrame() override
+    {
+        co_return std::string_view(m_buffer);
+    }
+
+  private:
+    std::string m_buffer;
+};
+
+void BM_RateLimiterReserve(::benchmark::State &state)
+{
+    internals::RateLimiter rateLimiter(1000, 1e9);
+    for (auto _ : state)
+    {
+        ::benchmark::DoNotOptimize(rateLimiter.reserve(internals::RateLimiter::Clock::now()));
+    }
+}
+BENCHMARK(BM_RateLimiterReserve);
+
+// Token available: acquire() completes without suspending on the timer.
+void BM_RateLimiterAcquire(::benchmark::State &state)
+{
+    boost::asio::io_context context;
+    internals::RateLimiter rateLimiter(1000, 1e9);
+    for (auto _ : state)
+    {
+        boost::asio::co_spawn(context, rateLimiter.acquire(), boost::asio::detached);
+        context.run();
+        context.restart();
+    }
+}
+BENCHMARK(BM_RateLimiterAcquire);
+
+// Baseline for the request benchmarks: spawning and running an empty coroutine.
+void BM_CoSpawnEmpty(::benchmark::State &state)
+{
+    boost::asio::io_context context;
+    for (auto _ : state)
+    {
+        boost::asio::co_spawn(context, []() -> boost::asio::awaitable<void> { co_return; }, boost::asio::detached);
+        context.run();
+        context.restart();
+    }
+}
+BENCHMARK(BM_CoSpawnEmpty);
+
+// One request() through the IConnection coroutine chain: request -> makeRequest + waitResponse.
+void BM_RequestCoroutine(::benchmark::State &state)
+{
+    boost::asio::io_context context;
+    ImmediateConnection connection;
+    const internals::Command command("getVersion");
+    for (auto _ : state)
+    {
+        boost::asio::co_spawn(context, connection.request(command), boost::asio::detached);
+        context.run();
+        context.restart();
+    }
+}
+BENCHMARK(BM_RequestCoroutine);
+
+// Runs the benchmark loop inside a single coroutine, so that only the awaited coroutines are measured.
+template <typename Loop> void runInCoroutine(::benchmark::State &state, Loop loop)
+{
+    boost::asio::io_context context;
+    std::exception_ptr error;
+    boost::asio::co_spawn(context, loop(), [&error](std::exception_ptr e) { error = e; });
+    context.run();
+    if (error)
+    {
+        state.SkipWithError("Coroutine failed");
+    }
+    // Frames beyond the cache of the thread are allocated with malloc, compare builds with
+    // -DXAPI_FRAME_CACHE_SIZE=2 (the Asio default) and the project default.
+    state.SetLabel("frame cache " + std::to_string(BOOST_ASIO_RECYCLING_ALLOCATOR_CACHE_SIZE));
+}
+
+boost::asio::awaitable<int> nestedCoroutine(int depth)
+{
+    if (depth <= 1)
+    {
+        co_return 1;
+    }
+    co_return 1 + co_await nestedCoroutine(depth - 1);
+}
+
+// Chains of nested coroutines as deep as the request and listen paths, frames per second.
+void BM_CoroutineFrames(::benchmark::State &state)
+{
+    const auto depth = static_cast<int>(state.range(0));
+    runInCoroutine(state, [&state, depth]() -> boost::asio::awaitable<void> {
+        for (auto _ : state)
+        {
+            ::benchmark::DoNotOptimize(co_await nestedCoroutine(depth));
+        }
+    });
+    state.counters["frames"] =
+        ::benchmark::Counter(static_cast<double>(state.iterations()) * depth, ::benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_CoroutineFrames)->Arg(1)->Arg(2)->Arg(4)->Arg(6)->Arg(8);
+
+// request() in a loop: request -> makeRequest + waitResponse, three frames per request.
+void BM_RequestLoop(::benchmark::State &state)
+{
+    ImmediateConnection connection;
+    const internals::Command command("getVersion");
+    runInCoroutine(state, [&state, &connection, &command]() -> boost::asio::awaitable<void> {
+        for (auto _ : state)
+        {
+            ::benchmark::DoNotOptimize(co_await connection.request(command));
+        }
+    });
+    state.counters["frames"] =
+        ::benchmark::Counter(static_cast<double>(state.iterations()) * 3, ::benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_RequestLoop);
+
+// listenTyped() in a loop: listenTyped -> readWithReconnect -> waitFrame, three frames per message.
+void BM_ListenLoop(::benchmark::State &state)
+{
+    XStationClientStream stream(std::make_unique<ImmediateConnection>(
+        R"({"command":"tickPrices","data":{"ask":1.08007,"bid":1.08,"level":0,"symbol":"EURUSD",)"
+        R"("timestamp":1700000000000}})"));
+    StreamRecord record;
+    runInCoroutine(state, [&state, &stream, &record]() -> boost::asio::awaitable<void> {
+        for (auto _ : state)
+        {
+            co_await stream.listenTyped(record);
+        }
+    });
+    state.counters["frames"] =
+        ::benchmark::Counter(static_cast<double>(state.iterations()) * 3, ::benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ListenLoop);
+
+} // namespace
@@ -0,0 +1,132 @@
+#include "mockserver/MockServer.hpp"
+#include "xapi/XStationClient.hpp"
+#include <benchmark/benchmark.h>
+#include <optional>
+
+using namespace xapi;
+
+namespace
+{
+
+/**
+ * @brief Client logged in to a mock server on the loopback interface, both on one io_context.
+ */
+class Loopback
+{
+  public:
+    explicit Loopback(mock::StreamScript script = {})
+        : m_context(), m_server(m_context), m_client(m_context, "accountId", "password")
+    {
+        m_server.setStreamScript(std::move(script));
+        m_server.start();
+        m_client.setServerUrl(m_server.url());
+        // Measure the client stack, not the server request limit.
+        m_client.setRateLimit(1000000, 1e9);
+    }
+
+    ~Loopback()
+    {
+        m_context.stop();
+    }
+
+    XStationClient &client()
+    {
+        return m_client;
+    }
+
+    // Runs the io_context until the awaitable, or the coroutine returned by the function, completes.
+    template <typename Awaitable> void run(Awaitable awaitable)
+    {
+        run(m_context.get_executor(), std::move(awaitable));
+    }
+
+    // Same, with the coroutine spawned on the executor, so that it does not hop to a connection strand.
+    template <typename Executor, typename Awaitable> void run(const Executor &executor, Awaitable awaitable)
+    {
+        bool done = false;
+        std::exception_ptr error;
+        boost::asio::co_spawn(executor, std::move(awaitable), [&](std::exception_ptr e, auto...) {
+            error = e;
+            done = true;
+        });
+        while (!done)
+        {
+            m_context.run_one();
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+  private:
+    boost::asio::io_context m_context;
+    mock::MockServer m_server;
+    XStationClient m_client;
+};
+
+void BM_Loopback_RequestRoundTrip(::benchmark::State &state)
+{
+    Loopback loopback;
+    loopback.run(loopback.client().login());
+    for (auto _ : state)
+    {
+        loopback.run(loopback.client().executor(), loopback.client().getVersion());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+}
+BENCHMARK(BM_Loopback_RequestRoundTrip)->UseRealTime();
+
+void BM_Loopback_PipelinedRequests(::benchmark::State &state)
+{
+    const auto inFlight = static_cast<std::size_t>(state.range(0));
+    Loopback loopback;
+    loopback.run(loopback.client().login());
+    for (auto _ : state)
+    {
+        loopback.run(loopback.client().executor(), [&]() -> boost::asio::awaitable<void> {
+            auto executor = co_await boost::asio::this_coro::executor;
+            std::size_t completed = 0;
+            boost::asio::steady_timer done(executor, boost::asio::steady_timer::time_point::max());
+            for (std::size_t i = 0; i < inFlight; ++i)
+            {
+                boost::asio::co_spawn(
+                    executor,
+                    [&]() -> boost::asio::awaitable<void> {
+                        co_await loopback.client().getVersion();
+                        if (++completed == inFlight)
+                        {
+                            done.cancel();
+                        }
+                    },
+                    boost::asio::detached);
+            }
+            boost::system::error_code ec;
+            co_await done.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        });
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * inFlight));
+}
+BENCHMARK(BM_Loopback_PipelinedRequests)->Arg(8)->Arg(64)->UseRealTime();
+
+void BM_Loopback_StreamTicks(::benchmark::State &state)
+{
+    mock::StreamScript script;
+    script.repeat = 0;
+    Loopback loopback(script);
+
+    std::optional<XStationClientStream> stream;
+    loopback.run([&]() -> boost::asio::awaitable<void> {
+        stream.emplace(co_await loopback.client().loginWithStream());
+        co_await stream->getTickPrices("EURUSD");
+    });
+
+    for (auto _ : state)
+    {
+        loopback.run(stream->executor(), stream->listenTyped());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+}
+BENCHMARK(BM_Loopback_StreamTicks)->UseRealTime();
+
+} // namespace
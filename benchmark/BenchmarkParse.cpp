@@ -0,0 +1,67 @@
+#include "Payloads.hpp"
+#include "xapi/StreamRecordParser.hpp"
+#include <benchmark/benchmark.h>
+#include <boost/json.hpp>
+
+using namespace xapi;
+
+namespace
+{
+
+// Same reuse pattern as Connection::waitResponse(): one stream_parser for all messages.
+void parseDom(::benchmark::State &state, std::string_view payload)
+{
+    boost::json::stream_parser parser;
+    for (auto _ : state)
+    {
+        parser.reset();
+        parser.write(payload.data(), payload.size());
+        parser.finish();
+        ::benchmark::DoNotOptimize(parser.release());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * payload.size()));
+}
+
+void parseTyped(::benchmark::State &state, std::string_view payload)
+{
+    internals::StreamRecordParser parser;
+    StreamRecord record;
+    for (auto _ : state)
+    {
+        ::benchmark::DoNotOptimize(parser.parse(payload, record));
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * payload.size()));
+}
+
+void BM_ParseDom_TickPrices(::benchmark::State &state)
+{
+    parseDom(state, xapi::benchmark::tickPricesPayload);
+}
+BENCHMARK(BM_ParseDom_TickPrices);
+
+void BM_ParseDom_Candle(::benchmark::State &state)
+{
+    parseDom(state, xapi::benchmark::candlePayload);
+}
+BENCHMARK(BM_ParseDom_Candle);
+
+void BM_ParseDom_AllSymbols(::benchmark::State &state)
+{
+    const std::string payload = xapi::benchmark::allSymbolsPayload(static_cast<std::size_t>(state.range(0)));
+    parseDom(state, payload);
+}
+BENCHMARK(BM_ParseDom_AllSymbols)->Arg(100)->Arg(2000);
+
+void BM_ParseTyped_TickPrices(::benchmark::State &state)
+{
+    parseTyped(state, xapi::benchmark::tickPricesPayload);
+}
+BENCHMARK(BM_ParseTyped_TickPrices);
+
+void BM_ParseTyped_Candle(::benchmark::State &state)
+{
+    parseTyped(state, xapi::benchmark::candlePayload);
+}
+BENCHMARK(BM_ParseTyped_Candle);
+
+} // namespace
@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "mockserver/MockServer.hpp"
+#include "xapi/Exceptions.hpp"
+#include "xapi/XStationClient.hpp"
+
+namespace
+{
+
+// Replaced by the mock server with the send time of the frame.
+constexpr std::string_view sendTimePlaceholder = "\"@SEND_TIME@\"";
+
+struct Options
+{
+    // Frames per second sent by the server, 0 sends as fast as the client reads.
+    double rate = 0.0;
+    std::size_t messages = 200000;
+    std::size_t warmup = 10000;
+    std::size_t ticks = 8;
+    std::size_t candles = 1;
+    std::size_t keepAlives = 1;
+    // Read with listen() instead of listenTyped().
+    bool json = false;
+    // Use DirectXStationClient, which calls the connection without virtual dispatch.
+    bool direct = false;
+    // Fail if the p99 latency is higher, in microseconds, 0 for no limit.
+    double maxP99 = 0.0;
+    // Fail if fewer messages per second are delivered, 0 for no limit.
+    double minRate = 0.0;
+};
+
+struct Report
+{
+    std::vector<std::int64_t> latencies;
+    std::chrono::steady_clock::duration elapsed{};
+    std::chrono::nanoseconds cpu{};
+    std::size_t sent = 0;
+};
+
+void printUsage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --rate N          frames per second sent by the server, 0 for as fast as possible (default 0)\n"
+              << "  --messages N      measured messages (default 200000)\n"
+              << "  --warmup N        messages read before measuring (default 10000)\n"
+              << "  --mix T,C,K       tickPrices, candle and keepAlive frames per round (default 8,1,1)\n"
+              << "  --json            read with listen() instead of listenTyped()\n"
+              << "  --direct          use DirectXStationClient instead of XStationClient\n"
+              << "  --max-p99-us N    exit with failure if the p99 latency is above N microseconds\n"
+              << "  --min-rate N      exit with failure if fewer than N messages per second are delivered\n";
+}
+
+// Accepts the whole text only, unlike std::stoul and std::stod, and does not throw.
+template <typename Number> bool parseNumber(std::string_view text, Number &value)
+{
+    const char *end = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    return !text.empty() && ec == std::errc() && ptr == end;
+}
+
+bool parseMix(std::string_view mix, Options &options)
+{
+    std::vector<std::size_t> counts;
+    std::size_t start = 0;
+    while (start <= mix.size())
+    {
+        const std::size_t end = std::min(mix.find(',', start), mix.size());
+        std::size_t count = 0;
+        if (!parseNumber(mix.substr(start, end - start), count))
+        {
+            return false;
+        }
+        counts.push_back(count);
+        start = end + 1;
+    }
+    if (counts.size() != 3 || counts[0] + counts[1] + counts[2] == 0)
+    {
+        return false;
+    }
+    options.ticks = counts[0];
+    options.candles = counts[1];
+    options.keepAlives = counts[2];
+    return true;
+}
+
+std::string withPlaceholder(std::string_view before, std::string_view after)
+{
+    return std::string(before) + std::string(sendTimePlaceholder) + std::string(after);
+}
+
+xapi::mock::StreamScript makeScript(const Options &options)
+{
+    xapi::mock::StreamScript script;
+    const std::string tick = withPlaceholder(
+        R"({"command":"tickPrices","data":{"ask":1.08007,"askVolume":1000000,"bid":1.08,"bidVolume":1000000,)"
+        R"("high":1.081,"level":0,"low":1.079,"quoteId":1,"spreadRaw":0.00007,"spreadTable":0.7,)"
+        R"("symbol":"EURUSD","timestamp":)",
+        "}}");
+    const std::string candle = withPlaceholder(R"({"command":"candle","data":{"close":1.0801,"ctm":)",
+                                               R"(,"ctmString":"","high":1.0805,"low":1.0795,"open":1.08,)"
+                                               R"("quoteId":1,"symbol":"EURUSD","vol":12.0}})");
+    const std::string keepAlive = withPlaceholder(R"({"command":"keepAlive","data":{"timestamp":)", "}}");
+
+    script.frames.insert(script.frames.end(), options.ticks, tick);
+    script.frames.insert(script.frames.end(), options.candles, candle);
+    script.frames.insert(script.frames.end(), options.keepAlives, keepAlive);
+    script.repeat = 0;
+    script.sendTimePlaceholder = std::string(sendTimePlaceholder);
+    if (options.rate > 0.0)
+    {
+        script.frameInterval = std::chrono::nanoseconds(static_cast<std::int64_t>(1e9 / options.rate));
+    }
+    return script;
+}
+
+std::int64_t steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+std::chrono::nanoseconds threadCpuTime()
+{
+    timespec time{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+// Send time stamped by the server, the time fields of the records hold it in nanoseconds.
+std::optional<std::int64_t> sendTime(const xapi::StreamRecord &record)
+{
+    if (const auto *tick = std::get_if<xapi::TickRecord>(&record))
+    {
+        return tick->timestamp;
+    }
+    if (const auto *candle = std::get_if<xapi::CandleRecord>(&record))
+    {
+        return candle->ctm;
+    }
+    if (const auto *keepAlive = std::get_if<xapi::KeepAliveRecord>(&record))
+    {
+        return keepAlive->timestamp;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::int64_t> sendTime(const boost::json::object &message)
+{
+    const auto *data = message.if_contains("data");
+    if (data == nullptr || !data->is_object())
+    {
+        return std::nullopt;
+    }
+    for (const char *field : {"timestamp", "ctm"})
+    {
+        if (const auto *value = data->get_object().if_contains(field); value != nullptr && value->is_int64())
+        {
+            return value->get_int64();
+        }
+    }
+    return std::nullopt;
+}
+
+template <typename Client>
+boost::asio::awaitable<void> measure(Client &client, const Options &options, Report &report)
+{
+    auto stream = co_await client.loginWithStream();
+    // The mock server starts streaming on the first subscription.
+    co_await stream.getTickPrices("EURUSD");
+
+    report.latencies.reserve(options.messages);
+    // Read on the stream strand, so that the reads do not hop to it and back.
+    co_await boost::asio::co_spawn(
+        stream.executor(),
+        [&]() -> boost::asio::awaitable<void> {
+            std::chrono::steady_clock::time_point start;
+            std::chrono::nanoseconds cpuStart{};
+
+            for (std::size_t i = 0; i < options.warmup + options.messages; ++i)
+            {
+                if (i == options.warmup)
+                {
+                    start = std::chrono::steady_clock::now();
+                    cpuStart = threadCpuTime();
+                }
+
+                std::optional<std::int64_t> sentAt;
+                if (options.json)
+                {
+                    sentAt = sendTime(co_await stream.listen());
+                }
+                else
+                {
+                    sentAt = sendTime(co_await stream.listenTyped());
+                }
+
+                if (i >= options.warmup && sentAt)
+                {
+                    report.latencies.push_back(steadyNanoseconds() - *sentAt);
+                }
+            }
+
+            report.elapsed = std::chrono::steady_clock::now() - start;
+            report.cpu = threadCpuTime() - cpuStart;
+        },
+        boost::asio::use_awaitable);
+    co_await stream.close();
+    co_await client.logout();
+}
+
+double percentile(const std::vector<std::int64_t> &sorted, double fraction)
+{
+    const auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return static_cast<double>(sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1]) / 1000.0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool valid = true;
+
+        if (argument == "--json")
+        {
+            options.json = true;
+        }
+        else if (argument == "--direct")
+        {
+            options.direct = true;
+        }
+        else if (argument == "--rate" && hasValue)
+        {
+            valid = parseNumber(argv[++i], options.rate);
+        }
+        else if (argument == "--messages" && hasValue)
+        {
+            valid = parseNumber(argv[++i], options.messages);
+        }
+        else if (argument == "--warmup" && hasValue)
+        {
+            valid = parseNumber(argv[++i], options.warmup);
+        }
+        else if (argument == "--mix" && hasValue)
+        {
+            valid = parseMix(argv[++i], options);
+        }
+        else if (argument == "--max-p99-us" && hasValue)
+        {
+            valid = parseNumber(argv[++i], options.maxP99);
+        }
+        else if (argument == "--min-rate" && hasValue)
+        {
+            valid = parseNumber(argv[++i], options.minRate);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return argument == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        if (!valid)
+        {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.messages == 0)
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Report report;
+    try
+    {
+        // The server runs on its own thread, so its work is not counted as client CPU time.
+        boost::asio::io_context serverContext;
+        xapi::mock::MockServer server(serverContext);
+        server.setStreamScript(makeScript(options));
+        server.start();
+        auto serverWork = boost::asio::make_work_guard(serverContext);
+        std::thread serverThread([&serverContext]() { serverContext.run(); });
+
+        boost::asio::io_context clientContext;
+        std::exception_ptr error;
+        const auto run = [&](auto &client) {
+            client.setServerUrl(server.url());
+            client.setRateLimit(1000000, 1e9);
+            // Stopped on completion, a failed run leaves the keep-alive task of the client running
+            boost::asio::co_spawn(client.executor(), measure(client, options, report),
+                                  [&error, &clientContext](std::exception_ptr e) {
+                                      error = e;
+                                      clientContext.stop();
+                                  });
+            clientContext.run();
+        };
+        if (options.direct)
+        {
+            xapi::DirectXStationClient client(clientContext, "accountId", "password");
+            run(client);
+        }
+        else
+        {
+            xapi::XStationClient client(clientContext, "accountId", "password");
+            run(client);
+        }
+
+        serverWork.reset();
+        serverContext.stop();
+        serverThread.join();
+        report.sent = server.streamedFrames();
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (report.latencies.empty())
+    {
+        std::cerr << "No message carried a send time" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::sort(report.latencies.begin(), report.latencies.end());
+    const double seconds = std::chrono::duration<double>(report.elapsed).count();
+    const double delivered = static_cast<double>(options.messages) / seconds;
+    const double cpuPerMessage =
+        std::chrono::duration<double, std::micro>(report.cpu).count() / static_cast<double>(options.messages);
+
+    std::cout << std::fixed << std::setprecision(2) << "messages            " << options.messages << "\n"
+              << "client              " << (options.direct ? "DirectXStationClient" : "XStationClient") << "\n"
+              << "mix                 " << options.ticks << " tick, " << options.candles << " candle, "
+              << options.keepAlives << " keepAlive\n"
+              << "offered rate        " << (options.rate > 0.0 ? std::to_string(options.rate) : "unpaced")
+              << " msg/s\n"
+              << "delivered rate      " << delivered << " msg/s" << (options.rate > 0.0 ? "" : " (max sustained)")
+              << "\n"
+              << "latency p50         " << percentile(report.latencies, 0.50) << " us\n"
+              << "latency p99         " << percentile(report.latencies, 0.99) << " us\n"
+              << "latency p99.9       " << percentile(report.latencies, 0.999) << " us\n"
+              << "latency max         " << percentile(report.latencies, 1.0) << " us\n"
+              << "client cpu/message  " << cpuPerMessage << " us\n"
+              << "frames sent         " << report.sent << std::endl;
+
+    bool passed = true;
+    if (options.maxP99 > 0.0 && percentile(report.latencies, 0.99) > options.maxP99)
+    {
+        std::cerr << "p99 latency above " << options.maxP99 << " us" << std::endl;
+        passed = false;
+    }
+    if (options.minRate > 0.0 && delivered < options.minRate)
+    {
+        std::cerr << "delivered rate below " << options.minRate << " msg/s" << std::endl;
+        passed = false;
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+/**
+ * @file Payloads.hpp
+ * @brief Representative xAPI messages used by the benchmarks.
+ */
+
+#include <string>
+#include <string_view>
+
+namespace xapi
+{
+namespace benchmark
+{
+
+inline constexpr std::string_view tickPricesPayload =
+    R"({"command":"tickPrices","data":{"ask":4000.0,"askVolume":15000,"bid":4000.5,"bidVolume":16000,)"
+    R"("high":4000.0,"level":0,"low":3500.0,"quoteId":0,"spreadRaw":0.000003,"spreadTable":0.00042,)"
+    R"("symbol":"KOMB.CZ","timestamp":1272529161605}})";
+
+inline constexpr std::string_view candlePayload =
+    R"({"command":"candle","data":{"close":4.1,"ctm":1378369375000,"ctmString":"Sep 05, 2013 10:22:55 AM",)"
+    R"("high":4.1,"low":4.1,"open":4.1,"quoteId":2,"symbol":"EURUSD","vol":0.0}})";
+
+inline constexpr std::string_view symbolRecordPayload =
+    R"({"ask":4000.0,"bid":4000.0,"categoryName":"Forex","contractSize":100000,"currency":"USD",)"
+    R"("currencyPair":true,"currencyProfit":"SEK","description":"USD/PLN","expiration":null,)"
+    R"("groupName":"Minor","high":4000.0,"initialMargin":0,"instantMaxVolume":0,"leverage":1.5,)"
+    R"("longOnly":false,"lotMax":10.0,"lotMin":0.1,"lotStep":0.1,"low":3500.0,"marginHedged":0,)"
+    R"("marginHedgedStrong":false,"marginMaintenance":null,"marginMode":101,"percentage":100.0,)"
+    R"("precision":2,"profitMode":5,"quoteId":1,"shortSelling":true,"spreadRaw":0.000003,)"
+    R"("spreadTable":0.00042,"starting":null,"stepRuleId":1,"stopsLevel":0,"swap_rollover3days":0,)"
+    R"("swapEnable":true,"swapLong":-2.55929,"swapShort":0.131,"swapType":0,"symbol":"USDPLN",)"
+    R"("tickSize":1.0,"tickValue":1.0,"time":1272446136891,"timeString":"Thu May 23 12:23:44 EDT 2013",)"
+    R"("trailingEnabled":true,"type":21})";
+
+/**
+ * @brief Builds a getAllSymbols response with the given number of symbol records.
+ * @param symbols The number of records.
+ * @return The response message.
+ */
+inline std::string allSymbolsPayload(std::size_t symbols)
+{
+    std::string payload = R"({"status":true,"returnData":[)";
+    for (std::size_t i = 0; i < symbols; ++i)
+    {
+        if (i != 0)
+        {
+            payload += ',';
+        }
+        payload += symbolRecordPayload;
+    }
+    payload += "]}";
+    return payload;
+}
+
+} // namespace benchmark
+} // namespace xapi
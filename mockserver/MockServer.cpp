@@ -0,0 +1,423 @@
+#include "MockServer.hpp"
+#include "SelfSignedCertificate.hpp"
+#include <boost/beast.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+#include <algorithm>
+
+namespace xapi
+{
+namespace mock
+{
+
+namespace
+{
+
+using TcpStream = boost::beast::tcp_stream;
+using PlainWebSocket = boost::beast::websocket::stream<TcpStream>;
+using TlsWebSocket = boost::beast::websocket::stream<boost::asio::ssl::stream<TcpStream>>;
+
+std::int64_t nowMilliseconds()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+boost::json::object symbolRecord(std::string_view symbol)
+{
+    return {{"ask", 1.08012},        {"bid", 1.08005},      {"categoryName", "FX"},  {"contractSize", 100000},
+            {"currency", "EUR"},     {"currencyProfit", "USD"}, {"description", "Euro to American Dollar"},
+            {"digits", 5},           {"groupName", "Major"}, {"high", 1.0823},       {"low", 1.0791},
+            {"lotMax", 100.0},       {"lotMin", 0.01},       {"lotStep", 0.01},      {"precision", 5},
+            {"spreadRaw", 0.00007},  {"spreadTable", 0.7},   {"symbol", symbol},     {"tickSize", 0.00001},
+            {"tickValue", 1.0},      {"time", nowMilliseconds()}, {"type", 1}};
+}
+
+std::map<std::string, boost::json::value, std::less<>> defaultResponses()
+{
+    std::map<std::string, boost::json::value, std::less<>> responses;
+    responses["getAllSymbols"] = boost::json::array{symbolRecord("EURUSD")};
+    responses["getCalendar"] = boost::json::array();
+    responses["getChartLastRequest"] = {{"digits", 5}, {"rateInfos", boost::json::array()}};
+    responses["getChartRangeRequest"] = {{"digits", 5}, {"rateInfos", boost::json::array()}};
+    responses["getCommissionDef"] = {{"commission", 0.0}, {"rateOfExchange", 1.0}};
+    responses["getCurrentUserData"] = {{"companyUnit", 8},      {"currency", "USD"},
+                                       {"group", "demoUSD"},    {"ibAccount", false},
+                                       {"leverage", 1},         {"leverageMultiplier", 0.25},
+                                       {"spreadType", "FLOAT"}, {"trailingStop", false}};
+    responses["getIbsHistory"] = boost::json::array();
+    responses["getMarginLevel"] = {{"balance", 10000.0},     {"credit", 0.0},  {"currency", "USD"},
+                                   {"equity", 10000.0},      {"margin", 0.0},  {"margin_free", 10000.0},
+                                   {"margin_level", 0.0}};
+    responses["getMarginTrade"] = {{"margin", 0.0}};
+    responses["getNews"] = boost::json::array();
+    responses["getProfitCalculation"] = {{"profit", 0.0}};
+    responses["getStepRules"] = boost::json::array();
+    responses["getSymbol"] = symbolRecord("EURUSD");
+    responses["getTickPrices"] = {{"quotations", boost::json::array()}};
+    responses["getTradeRecords"] = boost::json::array();
+    responses["getTrades"] = boost::json::array();
+    responses["getTradesHistory"] = boost::json::array();
+    responses["getTradingHours"] = boost::json::array();
+    responses["getVersion"] = {{"version", "2.5.0"}};
+    responses["tradeTransaction"] = {{"order", 1}};
+    responses["tradeTransactionStatus"] = {{"ask", 1.08012}, {"bid", 1.08005}, {"customComment", ""},
+                                           {"message", nullptr}, {"order", 1},   {"requestStatus", 3}};
+    return responses;
+}
+
+std::string_view commandName(const boost::json::object &command)
+{
+    const auto *name = command.if_contains("command");
+    return name != nullptr && name->is_string() ? std::string_view(name->get_string()) : std::string_view();
+}
+
+std::string_view symbolArgument(const boost::json::object &command)
+{
+    const auto *symbol = command.if_contains("symbol");
+    return symbol != nullptr && symbol->is_string() ? std::string_view(symbol->get_string()) : std::string_view();
+}
+
+} // namespace
+
+MockServer::MockServer(boost::asio::io_context &ioContext, MockServerOptions options)
+    : m_ioContext(ioContext), m_options(std::move(options)), m_sslContext(boost::asio::ssl::context::tls_server),
+      m_acceptor(ioContext), m_responses(defaultResponses()), m_streamScript(std::make_shared<StreamScript>()),
+      m_requestCount(0), m_streamedFrames(0)
+{
+    if (!m_options.tls)
+    {
+        return;
+    }
+
+    if (m_options.certificateFile.empty())
+    {
+        useSelfSignedCertificate(m_sslContext);
+    }
+    else
+    {
+        m_sslContext.use_certificate_chain_file(m_options.certificateFile);
+        m_sslContext.use_private_key_file(m_options.privateKeyFile, boost::asio::ssl::context::pem);
+    }
+}
+
+MockServer::~MockServer()
+{
+    stop();
+}
+
+void MockServer::start()
+{
+    const boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::make_address(m_options.address), m_options.port);
+    m_acceptor.open(endpoint.protocol());
+    m_acceptor.set_option(boost::asio::socket_base::reuse_address(true));
+    m_acceptor.bind(endpoint);
+    m_acceptor.listen();
+
+    boost::asio::co_spawn(m_ioContext, acceptConnections(), boost::asio::detached);
+}
+
+void MockServer::stop()
+{
+    boost::system::error_code ec;
+    m_acceptor.close(ec);
+}
+
+unsigned short MockServer::port() const
+{
+    return m_acceptor.local_endpoint().port();
+}
+
+std::string MockServer::url() const
+{
+    return (m_options.tls ? "wss://" : "ws://") + m_options.address + ":" + std::to_string(port());
+}
+
+void MockServer::setResponse(const std::string &command, boost::json::value returnData)
+{
+    m_responses[command] = std::move(returnData);
+}
+
+void MockServer::setStreamScript(StreamScript script)
+{
+    m_streamScript = std::make_shared<const StreamScript>(std::move(script));
+}
+
+std::size_t MockServer::requestCount() const noexcept
+{
+    return m_requestCount.load(std::memory_order_relaxed);
+}
+
+std::size_t MockServer::streamedFrames() const noexcept
+{
+    return m_streamedFrames.load(std::memory_order_relaxed);
+}
+
+boost::asio::awaitable<void> MockServer::acceptConnections()
+{
+    while (m_acceptor.is_open())
+    {
+        boost::system::error_code ec;
+        auto socket = co_await m_acceptor.async_accept(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        if (ec)
+        {
+            if (ec == boost::asio::error::operation_aborted)
+            {
+                co_return;
+            }
+            continue;
+        }
+
+        socket.set_option(boost::asio::ip::tcp::no_delay(true));
+        boost::asio::co_spawn(m_ioContext, serveConnection(std::move(socket)), boost::asio::detached);
+    }
+}
+
+boost::asio::awaitable<void> MockServer::serveConnection(boost::asio::ip::tcp::socket socket)
+{
+    try
+    {
+        if (m_options.tls)
+        {
+            auto websocket = std::make_shared<TlsWebSocket>(TcpStream(std::move(socket)), m_sslContext);
+            co_await websocket->next_layer().async_handshake(boost::asio::ssl::stream_base::server,
+                                                             boost::asio::use_awaitable);
+            co_await serveWebSocket(websocket);
+        }
+        else
+        {
+            auto websocket = std::make_shared<PlainWebSocket>(std::move(socket));
+            co_await serveWebSocket(websocket);
+        }
+    }
+    catch (const std::exception &)
+    {
+        // The client closed the connection or sent something that is not xAPI, drop it.
+    }
+}
+
+template <typename WebSocket> boost::asio::awaitable<void> MockServer::serveWebSocket(std::shared_ptr<WebSocket> websocket)
+{
+    boost::beast::flat_buffer buffer;
+    boost::beast::http::request<boost::beast::http::string_body> request;
+    co_await boost::beast::http::async_read(websocket->next_layer(), buffer, request, boost::asio::use_awaitable);
+
+    websocket->set_option(boost::beast::websocket::stream_base::timeout::suggested(boost::beast::role_type::server));
+    co_await websocket->async_accept(request, boost::asio::use_awaitable);
+    websocket->text(true);
+
+    if (request.target().ends_with("Stream"))
+    {
+        co_await serveStream(websocket);
+    }
+    else
+    {
+        co_await serveRequests(websocket);
+    }
+}
+
+template <typename WebSocket> boost::asio::awaitable<void> MockServer::serveRequests(std::shared_ptr<WebSocket> websocket)
+{
+    boost::beast::flat_buffer buffer;
+    std::string reply;
+    std::vector<std::string> held;
+    while (true)
+    {
+        buffer.clear();
+        co_await websocket->async_read(buffer, boost::asio::use_awaitable);
+        m_requestCount.fetch_add(1, std::memory_order_relaxed);
+
+        const boost::json::object command = boost::json::parse(boost::beast::buffers_to_string(buffer.data())).as_object();
+        const std::string_view name = commandName(command);
+        if (m_options.reversedResponseBatch > 1 && name != "login" && name != "logout")
+        {
+            held.push_back(boost::json::serialize(respond(command)));
+            if (held.size() < m_options.reversedResponseBatch)
+            {
+                continue;
+            }
+
+            reply = boost::json::serialize(boost::json::object{{"status", true}, {"customTag", "0"}});
+            co_await websocket->async_write(boost::asio::buffer(reply), boost::asio::use_awaitable);
+            for (auto it = held.rbegin(); it != held.rend(); ++it)
+            {
+                co_await websocket->async_write(boost::asio::buffer(*it), boost::asio::use_awaitable);
+            }
+            held.clear();
+            continue;
+        }
+
+        reply = boost::json::serialize(respond(command));
+        co_await websocket->async_write(boost::asio::buffer(reply), boost::asio::use_awaitable);
+
+        if (name == "logout")
+        {
+            co_await websocket->async_close(boost::beast::websocket::close_code::normal, boost::asio::use_awaitable);
+            co_return;
+        }
+    }
+}
+
+template <typename WebSocket> boost::asio::awaitable<void> MockServer::serveStream(std::shared_ptr<WebSocket> websocket)
+{
+    auto state = std::make_shared<StreamState>();
+    boost::beast::flat_buffer buffer;
+    try
+    {
+        while (true)
+        {
+            buffer.clear();
+            co_await websocket->async_read(buffer, boost::asio::use_awaitable);
+            m_requestCount.fetch_add(1, std::memory_order_relaxed);
+
+            const boost::json::object command =
+                boost::json::parse(boost::beast::buffers_to_string(buffer.data())).as_object();
+            const std::string_view name = commandName(command);
+            const std::string_view symbol = symbolArgument(command);
+
+            if (name == "getTickPrices")
+            {
+                state->tickSymbols.emplace_back(symbol);
+            }
+            else if (name == "stopTickPrices")
+            {
+                std::erase(state->tickSymbols, symbol);
+            }
+
+            if (name.starts_with("get") && !state->streaming)
+            {
+                state->streaming = true;
+                boost::asio::co_spawn(m_ioContext, streamFrames(websocket, state), boost::asio::detached);
+            }
+        }
+    }
+    catch (...)
+    {
+        state->closed = true;
+        throw;
+    }
+}
+
+template <typename WebSocket>
+boost::asio::awaitable<void> MockServer::streamFrames(std::shared_ptr<WebSocket> websocket,
+                                                      std::shared_ptr<StreamState> state)
+{
+    const std::shared_ptr<const StreamScript> script = m_streamScript;
+    boost::asio::steady_timer timer(m_ioContext);
+    std::string frame;
+    std::size_t sequence = 0;
+    auto nextFrameAt = std::chrono::steady_clock::now();
+
+    try
+    {
+        for (std::size_t round = 0; !state->closed && (script->repeat == 0 || round < script->repeat); ++round)
+        {
+            // Subscriptions may change while writing, so the count is checked on every frame.
+            for (std::size_t i = 0;
+                 !state->closed && i < (script->frames.empty() ? state->tickSymbols.size() : script->frames.size()); ++i)
+            {
+                if (script->frameInterval.count() > 0)
+                {
+                    nextFrameAt += script->frameInterval;
+                    if (nextFrameAt > std::chrono::steady_clock::now())
+                    {
+                        timer.expires_at(nextFrameAt);
+                        co_await timer.async_wait(boost::asio::use_awaitable);
+                    }
+                }
+
+                frame = script->frames.empty() ? renderTick(state->tickSymbols[i], sequence++) : script->frames[i];
+                if (!script->sendTimePlaceholder.empty())
+                {
+                    stampSendTime(frame, script->sendTimePlaceholder);
+                }
+                co_await websocket->async_write(boost::asio::buffer(frame), boost::asio::use_awaitable);
+                m_streamedFrames.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (script->interval.count() > 0)
+            {
+                timer.expires_after(script->interval);
+                co_await timer.async_wait(boost::asio::use_awaitable);
+            }
+        }
+    }
+    catch (const std::exception &)
+    {
+        // The client closed the connection.
+    }
+}
+
+boost::json::object MockServer::respond(const boost::json::object &command) const
+{
+    boost::json::object response;
+    const std::string_view name = commandName(command);
+
+    if (name == "login")
+    {
+        const auto *arguments = command.if_contains("arguments");
+        const auto *password = arguments != nullptr && arguments->is_object() ? arguments->get_object().if_contains("password")
+                                                                               : nullptr;
+        if (password == nullptr || (password->is_string() && password->get_string() == m_options.invalidPassword))
+        {
+            response["status"] = false;
+            response["errorCode"] = "BE005";
+            response["errorDescr"] = "userPasswordCheck: Invalid login or password";
+        }
+        else
+        {
+            response["status"] = true;
+            response["streamSessionId"] = m_options.streamSessionId;
+        }
+    }
+    else if (name == "logout" || name == "ping")
+    {
+        response["status"] = true;
+    }
+    else if (name == "getServerTime")
+    {
+        response["status"] = true;
+        response["returnData"] = {{"time", nowMilliseconds()}, {"timeString", ""}};
+    }
+    else if (const auto it = m_responses.find(name); it != m_responses.end())
+    {
+        response["status"] = true;
+        response["returnData"] = it->second;
+    }
+    else
+    {
+        response["status"] = false;
+        response["errorCode"] = "EX007";
+        response["errorDescr"] = "Unknown command";
+    }
+
+    if (const auto *customTag = command.if_contains("customTag"))
+    {
+        response["customTag"] = *customTag;
+    }
+    return response;
+}
+
+void MockServer::stampSendTime(std::string &frame, std::string_view placeholder)
+{
+    const std::string sendTime = std::to_string(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+    for (std::size_t position = frame.find(placeholder); position != std::string::npos;
+         position = frame.find(placeholder, position + sendTime.size()))
+    {
+        frame.replace(position, placeholder.size(), sendTime);
+    }
+}
+
+std::string MockServer::renderTick(std::string_view symbol, std::size_t sequence)
+{
+    const double bid = 1.08 + static_cast<double>(sequence % 1000) * 0.00001;
+    const boost::json::object data = {{"ask", bid + 0.00007},  {"askVolume", 1000000}, {"bid", bid},
+                                      {"bidVolume", 1000000},  {"high", bid + 0.001},  {"level", 0},
+                                      {"low", bid - 0.001},    {"quoteId", 1},         {"spreadRaw", 0.00007},
+                                      {"spreadTable", 0.7},    {"symbol", symbol},     {"timestamp", nowMilliseconds()}};
+    return boost::json::serialize(boost::json::object{{"command", "tickPrices"}, {"data", data}});
+}
+
+} // namespace mock
+} // namespace xapi
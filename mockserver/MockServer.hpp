@@ -0,0 +1,214 @@
+#pragma once
+
+/**
+ * @file MockServer.hpp
+ * @brief Defines the MockServer class, a local xAPI server for integration tests and benchmarks.
+ *
+ * This file contains the definition of the MockServer class, which serves the xAPI request/response
+ * and streaming protocols over WebSocket, with or without TLS, on a local port.
+ */
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xapi
+{
+namespace mock
+{
+
+/**
+ * @brief Mock server configuration.
+ */
+struct MockServerOptions
+{
+    // Address to listen on.
+    std::string address = "127.0.0.1";
+
+    // Port to listen on, 0 picks a free port.
+    unsigned short port = 0;
+
+    // Serve `wss://` if true, plain `ws://` otherwise.
+    bool tls = true;
+
+    // PEM certificate chain and private key, a self-signed certificate is generated if empty.
+    std::string certificateFile;
+    std::string privateKeyFile;
+
+    // Stream session ID returned by login.
+    std::string streamSessionId = "mockStreamSessionId";
+
+    // Password for which login fails, to exercise failed logins.
+    std::string invalidPassword = "invalid";
+
+    // Responses to commands other than login and logout are held until this many are received,
+    // then sent in reverse order, preceded by a response with an unknown customTag, to exercise
+    // customTag demultiplexing. 0 or 1 answers every command in order.
+    std::size_t reversedResponseBatch = 0;
+};
+
+/**
+ * @brief Frames sent to a stream connection once it makes its first subscription.
+ */
+struct StreamScript
+{
+    // Raw messages to send, in order. If empty, a tickPrices record is generated
+    // for every symbol subscribed with getTickPrices.
+    std::vector<std::string> frames;
+
+    // How many times the frames are sent, 0 for no limit.
+    std::size_t repeat = 1;
+
+    // Delay between rounds of frames, zero sends as fast as the socket accepts.
+    std::chrono::microseconds interval{0};
+
+    // Delay between two frames, zero sends the frames of a round back to back.
+    // Frames are scheduled from the stream start, so a slow write does not lower the rate.
+    std::chrono::nanoseconds frameInterval{0};
+
+    // If not empty, every occurrence in a frame is replaced by the send time in nanoseconds
+    // of std::chrono::steady_clock, so the client can measure the delivery latency.
+    std::string sendTimePlaceholder;
+};
+
+/**
+ * @class MockServer
+ * @brief Local xAPI server answering commands with canned responses and streaming scripted data.
+ *
+ * Connections to a path ending with `Stream` (for example `/demoStream`) are stream connections,
+ * all others are request/response connections. Responses echo the customTag of the command.
+ */
+class MockServer final
+{
+  public:
+    MockServer() = delete;
+
+    MockServer(const MockServer &) = delete;
+    MockServer &operator=(const MockServer &) = delete;
+
+    MockServer(MockServer &&) = delete;
+    MockServer &operator=(MockServer &&) = delete;
+
+    /**
+     * @brief Constructs a new MockServer object.
+     * @param ioContext The IO context serving the connections.
+     * @param options The server configuration.
+     * @throw boost::system::system_error if the certificate cannot be loaded or generated.
+     */
+    explicit MockServer(boost::asio::io_context &ioContext, MockServerOptions options = {});
+
+    ~MockServer();
+
+    /**
+     * @brief Binds the listening socket and starts accepting connections.
+     * @throw boost::system::system_error if binding fails.
+     */
+    void start();
+
+    /**
+     * @brief Stops accepting connections, open connections are served until the clients close them.
+     */
+    void stop();
+
+    /**
+     * @brief Gets the port the server listens on.
+     * @return The port, valid after start().
+     */
+    unsigned short port() const;
+
+    /**
+     * @brief Gets the server URL to pass to XStationClient::setServerUrl().
+     * @return The URL without path, for example `wss://127.0.0.1:40123`.
+     */
+    std::string url() const;
+
+    /**
+     * @brief Sets the returnData sent in response to a command.
+     * @param command The command name.
+     * @param returnData The returnData of the response.
+     */
+    void setResponse(const std::string &command, boost::json::value returnData);
+
+    /**
+     * @brief Sets the frames streamed to stream connections opened from now on.
+     * @param script The stream script.
+     */
+    void setStreamScript(StreamScript script);
+
+    /**
+     * @brief Gets the number of commands received, on all connections.
+     * @return The number of commands.
+     */
+    std::size_t requestCount() const noexcept;
+
+    /**
+     * @brief Gets the number of frames streamed, on all connections.
+     * @return The number of frames.
+     */
+    std::size_t streamedFrames() const noexcept;
+
+  private:
+    /**
+     * @brief Subscriptions of a stream connection.
+     */
+    struct StreamState
+    {
+        std::vector<std::string> tickSymbols;
+        bool streaming = false;
+        bool closed = false;
+    };
+
+    boost::asio::io_context &m_ioContext;
+
+    const MockServerOptions m_options;
+
+    // Server SSL context with the certificate.
+    boost::asio::ssl::context m_sslContext;
+
+    boost::asio::ip::tcp::acceptor m_acceptor;
+
+    // returnData by command name.
+    std::map<std::string, boost::json::value, std::less<>> m_responses;
+
+    std::shared_ptr<const StreamScript> m_streamScript;
+
+    std::atomic<std::size_t> m_requestCount;
+    std::atomic<std::size_t> m_streamedFrames;
+
+    boost::asio::awaitable<void> acceptConnections();
+
+    boost::asio::awaitable<void> serveConnection(boost::asio::ip::tcp::socket socket);
+
+    // Accepts the WebSocket handshake and serves the connection according to its path.
+    template <typename WebSocket> boost::asio::awaitable<void> serveWebSocket(std::shared_ptr<WebSocket> websocket);
+
+    template <typename WebSocket> boost::asio::awaitable<void> serveRequests(std::shared_ptr<WebSocket> websocket);
+
+    template <typename WebSocket> boost::asio::awaitable<void> serveStream(std::shared_ptr<WebSocket> websocket);
+
+    template <typename WebSocket>
+    boost::asio::awaitable<void> streamFrames(std::shared_ptr<WebSocket> websocket, std::shared_ptr<StreamState> state);
+
+    /**
+     * @brief Builds the response to a command.
+     * @param command The command received.
+     * @return The response, with the customTag of the command.
+     */
+    boost::json::object respond(const boost::json::object &command) const;
+
+    // Replaces the placeholder in a frame by the current steady_clock time in nanoseconds.
+    static void stampSendTime(std::string &frame, std::string_view placeholder);
+
+    // Renders a generated tickPrices record.
+    static std::string renderTick(std::string_view symbol, std::size_t sequence);
+};
+
+} // namespace mock
+} // namespace xapi
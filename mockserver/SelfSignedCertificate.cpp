@@ -0,0 +1,63 @@
+#include "SelfSignedCertificate.hpp"
+#include <memory>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+namespace xapi
+{
+namespace mock
+{
+
+namespace
+{
+
+[[noreturn]] void throwSslError(const char *what)
+{
+    const boost::system::error_code ec(static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category());
+    throw boost::system::system_error(ec, what);
+}
+
+} // namespace
+
+void useSelfSignedCertificate(boost::asio::ssl::context &context, const std::string &commonName)
+{
+    const std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(EVP_EC_gen("P-256"), &EVP_PKEY_free);
+    if (!key)
+    {
+        throwSslError("EVP_EC_gen");
+    }
+
+    const std::unique_ptr<X509, decltype(&X509_free)> certificate(X509_new(), &X509_free);
+    if (!certificate)
+    {
+        throwSslError("X509_new");
+    }
+
+    X509_set_version(certificate.get(), 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(certificate.get()), 1);
+    X509_gmtime_adj(X509_getm_notBefore(certificate.get()), -60);
+    X509_gmtime_adj(X509_getm_notAfter(certificate.get()), 60L * 60 * 24 * 365);
+    X509_set_pubkey(certificate.get(), key.get());
+
+    X509_NAME *name = X509_get_subject_name(certificate.get());
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>(commonName.c_str()), -1,
+                               -1, 0);
+    X509_set_issuer_name(certificate.get(), name);
+
+    if (X509_sign(certificate.get(), key.get(), EVP_sha256()) == 0)
+    {
+        throwSslError("X509_sign");
+    }
+
+    if (SSL_CTX_use_certificate(context.native_handle(), certificate.get()) != 1)
+    {
+        throwSslError("SSL_CTX_use_certificate");
+    }
+    if (SSL_CTX_use_PrivateKey(context.native_handle(), key.get()) != 1)
+    {
+        throwSslError("SSL_CTX_use_PrivateKey");
+    }
+}
+
+} // namespace mock
+} // namespace xapi
@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * @file SelfSignedCertificate.hpp
+ * @brief Declares the function generating a self-signed certificate for the mock server.
+ */
+
+#include <boost/asio/ssl.hpp>
+#include <string>
+
+namespace xapi
+{
+namespace mock
+{
+
+/**
+ * @brief Generates a self-signed certificate with a fresh P-256 key and installs both into the SSL context.
+ * @param context The server SSL context.
+ * @param commonName The certificate subject common name.
+ * @throw boost::system::system_error if generating or installing the certificate fails.
+ */
+void useSelfSignedCertificate(boost::asio::ssl::context &context, const std::string &commonName = "localhost");
+
+} // namespace mock
+} // namespace xapi
@@ -0,0 +1,109 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <boost/asio.hpp>
+#include "MockServer.hpp"
+
+namespace
+{
+
+void printUsage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --address ADDRESS   address to listen on (default 127.0.0.1)\n"
+              << "  --port PORT         port to listen on (default 0, any free port)\n"
+              << "  --plain             serve ws:// instead of wss://\n"
+              << "  --cert FILE         PEM certificate chain (default: generated self-signed)\n"
+              << "  --key FILE          PEM private key\n"
+              << "  --script FILE       stream messages, one JSON message per line\n"
+              << "  --repeat N          times the stream messages are sent, 0 for no limit (default 1)\n"
+              << "  --interval-us N     delay between rounds of stream messages (default 0)\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    xapi::mock::MockServerOptions options;
+    xapi::mock::StreamScript script;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--plain")
+        {
+            options.tls = false;
+        }
+        else if (argument == "--address" && hasValue)
+        {
+            options.address = argv[++i];
+        }
+        else if (argument == "--port" && hasValue)
+        {
+            options.port = static_cast<unsigned short>(std::stoi(argv[++i]));
+        }
+        else if (argument == "--cert" && hasValue)
+        {
+            options.certificateFile = argv[++i];
+        }
+        else if (argument == "--key" && hasValue)
+        {
+            options.privateKeyFile = argv[++i];
+        }
+        else if (argument == "--script" && hasValue)
+        {
+            std::ifstream file(argv[++i]);
+            if (!file)
+            {
+                std::cerr << "Cannot open " << argv[i] << std::endl;
+                return EXIT_FAILURE;
+            }
+            for (std::string line; std::getline(file, line);)
+            {
+                if (!line.empty())
+                {
+                    script.frames.push_back(line);
+                }
+            }
+        }
+        else if (argument == "--repeat" && hasValue)
+        {
+            script.repeat = std::stoul(argv[++i]);
+        }
+        else if (argument == "--interval-us" && hasValue)
+        {
+            script.interval = std::chrono::microseconds(std::stol(argv[++i]));
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return argument == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    try
+    {
+        boost::asio::io_context context;
+        xapi::mock::MockServer server(context, options);
+        server.setStreamScript(script);
+        server.start();
+
+        boost::asio::signal_set signals(context, SIGINT, SIGTERM);
+        signals.async_wait([&context](const boost::system::error_code &, int) { context.stop(); });
+
+        std::cout << "xAPI mock server listening on " << server.url() << std::endl;
+        context.run();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,404 @@
+// Built as its own executable, the global operator new is replaced to count allocations.
+
+#include "xapi/CandleAggregator.hpp"
+#include "xapi/Exceptions.hpp"
+#include "xapi/MarketDataPump.hpp"
+#include "xapi/QuoteCache.hpp"
+#include "xapi/StreamDispatcher.hpp"
+#include "xapi/StreamRecordParser.hpp"
+#include "xapi/TickConflator.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+// Only allocations of the test thread are counted, and only inside countAllocations().
+thread_local bool counting = false;
+thread_local std::size_t allocations = 0;
+
+void *allocate(std::size_t size)
+{
+    if (counting)
+    {
+        ++allocations;
+    }
+    if (void *pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+// Not through aligned_alloc(), which is replaced below as well.
+void *allocateAligned(std::size_t size, std::size_t alignment) noexcept
+{
+    if (counting)
+    {
+        ++allocations;
+    }
+    void *pointer = nullptr;
+    if (::posix_memalign(&pointer, std::max(alignment, sizeof(void *)), size == 0 ? 1 : size) != 0)
+    {
+        return nullptr;
+    }
+    return pointer;
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    if (void *pointer = allocateAligned(size, static_cast<std::size_t>(alignment)))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+// Asio takes coroutine frames from aligned_alloc() when its recycling cache misses.
+extern "C" void *aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void *operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocateAligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+using namespace xapi;
+
+namespace
+{
+
+constexpr int warmupMessages = 100;
+constexpr int measuredMessages = 10000;
+
+const std::vector<std::string_view> frames{
+    R"({"command":"tickPrices","data":{"ask":1.08007,"askVolume":1000000,"bid":1.08,"bidVolume":1000000,)"
+    R"("high":1.081,"level":0,"low":1.079,"quoteId":1,"spreadRaw":0.00007,"spreadTable":0.7,)"
+    R"("symbol":"EURUSD","timestamp":1700000000000}})",
+    R"({"command":"tickPrices","data":{"ask":15001.0,"bid":15000.5,"level":1,"symbol":"US100",)"
+    R"("timestamp":1700000000100}})",
+    R"({"command":"candle","data":{"close":1.0801,"ctm":1700000000000,"ctmString":"Nov 14, 2023 10:13:20 PM",)"
+    R"("high":1.0805,"low":1.0795,"open":1.08,"quoteId":1,"symbol":"EURUSD","vol":12.0}})",
+    R"({"command":"keepAlive","data":{"timestamp":1700000000200}})"};
+
+// Number of allocations made by the test thread while calling the function.
+template <typename Function> std::size_t countAllocations(Function &&function)
+{
+    const std::size_t before = allocations;
+    counting = true;
+    function();
+    counting = false;
+    return allocations - before;
+}
+
+// Calls the function for the warmup messages, then counts allocations over the measured messages.
+template <typename Function> std::size_t steadyStateAllocations(Function &&function)
+{
+    for (int i = 0; i < warmupMessages; ++i)
+    {
+        function(frames[i % frames.size()]);
+    }
+    return countAllocations([&function]() {
+        for (int i = 0; i < measuredMessages; ++i)
+        {
+            function(frames[i % frames.size()]);
+        }
+    });
+}
+
+// Returns the frames in turn, counts allocations over the measured messages, then reports a closed connection.
+class FrameConnection final : public internals::IConnection
+{
+  public:
+    boost::asio::awaitable<void> connect(const boost::url &) override
+    {
+        co_return;
+    }
+
+    boost::asio::awaitable<void> disconnect() override
+    {
+        co_return;
+    }
+
+    boost::asio::awaitable<void> makeRequest(const internals::Command &) override
+    {
+        co_return;
+    }
+
+    boost::asio::awaitable<boost::json::object> waitResponse() override
+    {
+        co_return boost::json::object();
+    }
+
+    boost::asio::awaitable<std::string_view> waitFrame() override
+    {
+        if (m_served == warmupMessages)
+        {
+            counting = true;
+        }
+        if (m_served == warmupMessages + measuredMessages)
+        {
+            counting = false;
+            throw exception::ConnectionClosed("No more frames");
+        }
+        co_return frames[m_served++ % frames.size()];
+    }
+
+  private:
+    int m_served = 0;
+};
+
+// Runs the coroutine until the connection runs out of frames, returns the allocations counted meanwhile.
+template <typename Function> std::size_t coroutineAllocations(Function &&function)
+{
+    boost::asio::io_context context;
+    std::exception_ptr error;
+    const std::size_t before = allocations;
+    boost::asio::co_spawn(context, std::forward<Function>(function), [&error](std::exception_ptr e) { error = e; });
+    context.run();
+    counting = false;
+
+    EXPECT_TRUE(error);
+    if (error)
+    {
+        EXPECT_THROW(std::rethrow_exception(error), exception::ConnectionClosed);
+    }
+    return allocations - before;
+}
+
+TickRecord makeTick(int i)
+{
+    TickRecord tick;
+    tick.symbol = SymbolName(i % 2 == 0 ? "EURUSD" : "US100");
+    tick.bid = 1.0 + i * 0.0001;
+    tick.ask = tick.bid + 0.0001;
+    tick.timestamp = 1700000000000 + i * 1000;
+    return tick;
+}
+
+} // namespace
+
+TEST(AllocationTest, counts_allocations)
+{
+    // Checks that the replaced operator new is used, so the tests below cannot pass by accident
+    EXPECT_EQ(countAllocations([]() { auto value = std::make_unique<std::vector<int>>(16); }), 2u);
+    EXPECT_EQ(countAllocations([]() {
+                  void *volatile pointer = std::aligned_alloc(64, 64);
+                  std::free(pointer);
+              }),
+              1u);
+}
+
+TEST(AllocationTest, record_parser)
+{
+    internals::StreamRecordParser parser;
+    StreamRecord record;
+    EXPECT_EQ(steadyStateAllocations([&](std::string_view frame) { parser.parse(frame, record); }), 0u);
+}
+
+TEST(AllocationTest, dispatcher_typed_handlers)
+{
+    boost::asio::io_context context;
+    XStationClientStream stream(context, "demo", "streamSessionId");
+    StreamDispatcher dispatcher(stream);
+
+    double bid = 0.0;
+    double close = 0.0;
+    dispatcher.on<TickRecord>([&bid](const TickRecord &tick) { bid += tick.bid; });
+    dispatcher.on<CandleRecord>([&close](const CandleRecord &candle) { close += candle.close; });
+
+    EXPECT_EQ(steadyStateAllocations([&](std::string_view frame) { dispatcher.dispatch(frame); }), 0u);
+    EXPECT_GT(bid, 0.0);
+    EXPECT_GT(close, 0.0);
+}
+
+TEST(AllocationTest, dispatcher_json_handler)
+{
+    boost::asio::io_context context;
+    XStationClientStream stream(context, "demo", "streamSessionId");
+    StreamDispatcher dispatcher(stream);
+
+    std::size_t candles = 0;
+    dispatcher.on("candle", [&candles](const boost::json::object &message) {
+        candles += message.at("data").as_object().at("ctmString").as_string().size() > 0 ? 1 : 0;
+    });
+
+    EXPECT_EQ(steadyStateAllocations([&](std::string_view frame) { dispatcher.dispatch(frame); }), 0u);
+    EXPECT_EQ(candles, static_cast<std::size_t>((warmupMessages + measuredMessages) / frames.size()));
+}
+
+TEST(AllocationTest, market_data_pump)
+{
+    boost::asio::io_context context;
+    XStationClientStream stream(context, "demo", "streamSessionId");
+    SpscRing<MarketRecord> ring(16);
+    MarketDataPump<SpscRing<MarketRecord>> pump(stream, ring);
+
+    MarketRecord record;
+    EXPECT_EQ(steadyStateAllocations([&](std::string_view frame) {
+                  pump.publish(frame);
+                  while (ring.tryPop(record))
+                  {
+                  }
+              }),
+              0u);
+    EXPECT_EQ(pump.dropped(), 0u);
+}
+
+TEST(AllocationTest, stream_listen_typed)
+{
+    // Covers the read path: the coroutine frames of the stream and the connection, and the record
+    XStationClientStream stream(std::make_unique<FrameConnection>());
+    StreamRecord record;
+    int records = 0;
+    EXPECT_EQ(coroutineAllocations([&]() -> boost::asio::awaitable<void> {
+                  while (true)
+                  {
+                      co_await stream.listenTyped(record);
+                      ++records;
+                  }
+              }),
+              0u);
+    EXPECT_EQ(records, warmupMessages + measuredMessages);
+}
+
+TEST(AllocationTest, dispatcher_run)
+{
+    XStationClientStream stream(std::make_unique<FrameConnection>());
+    StreamDispatcher dispatcher(stream);
+
+    double bid = 0.0;
+    int keepAlives = 0;
+    dispatcher.on<TickRecord>([&bid](const TickRecord &tick) { bid += tick.bid; });
+    dispatcher.on<KeepAliveRecord>([&keepAlives](const KeepAliveRecord &) { ++keepAlives; });
+
+    EXPECT_EQ(coroutineAllocations([&dispatcher]() { return dispatcher.run(); }), 0u);
+    EXPECT_GT(bid, 0.0);
+    EXPECT_EQ(keepAlives, (warmupMessages + measuredMessages) / static_cast<int>(frames.size()));
+}
+
+TEST(AllocationTest, tick_consumers)
+{
+    TickConflator conflator;
+    QuoteCache cache;
+    CandleAggregator aggregator([](std::string_view, PeriodCode, const Candle &) {});
+    std::vector<TickRecord> polled;
+    polled.reserve(16);
+
+    const auto consume = [&](int i) {
+        const TickRecord tick = makeTick(i);
+        conflator.update(tick);
+        cache.update(tick);
+        aggregator.onTick(tick);
+        if (i % 10 == 0)
+        {
+            conflator.poll(polled);
+            polled.clear();
+        }
+    };
+
+    for (int i = 0; i < warmupMessages; ++i)
+    {
+        consume(i);
+    }
+    EXPECT_EQ(countAllocations([&]() {
+                  for (int i = warmupMessages; i < warmupMessages + measuredMessages; ++i)
+                  {
+                      consume(i);
+                  }
+              }),
+              0u);
+    EXPECT_EQ(aggregator.symbolCount(), 2u);
+}
+
+TEST(AllocationTest, conflator_new_symbols)
+{
+    // The index is allocated up front, so the first tick of a symbol does not allocate either
+    constexpr int symbols = 64;
+    TickConflator conflator(symbols);
+    std::vector<TickRecord> ticks;
+    for (int i = 0; i < symbols; ++i)
+    {
+        TickRecord tick = makeTick(i);
+        tick.symbol = SymbolName("SYMBOL" + std::to_string(i));
+        ticks.push_back(tick);
+    }
+    std::vector<TickRecord> polled;
+    polled.reserve(symbols);
+
+    EXPECT_EQ(countAllocations([&]() {
+                  for (const TickRecord &tick : ticks)
+                  {
+                      conflator.update(tick);
+                  }
+                  conflator.poll(polled);
+              }),
+              0u);
+    EXPECT_EQ(polled.size(), static_cast<std::size_t>(symbols));
+    EXPECT_EQ(conflator.rejected(), 0u);
+}
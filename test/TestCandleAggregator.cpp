@@ -0,0 +1,156 @@
+#include "xapi/CandleAggregator.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace xapi;
+
+namespace
+{
+
+constexpr std::int64_t minute = 60'000;
+constexpr std::int64_t day = 1440 * minute;
+
+struct ClosedBar
+{
+    std::string symbol;
+    PeriodCode period;
+    Candle bar;
+};
+
+TickRecord makeTick(std::string_view symbol, std::int64_t timestamp, double bid, int level = 0)
+{
+    TickRecord tick;
+    tick.symbol = SymbolName(symbol);
+    tick.timestamp = timestamp;
+    tick.bid = bid;
+    tick.level = level;
+    return tick;
+}
+
+CandleRecord makeCandle(std::string_view symbol, std::int64_t ctm, double open, double high, double low, double close)
+{
+    CandleRecord candle;
+    candle.symbol = SymbolName(symbol);
+    candle.ctm = ctm;
+    candle.open = open;
+    candle.high = high;
+    candle.low = low;
+    candle.close = close;
+    candle.vol = 1.0;
+    return candle;
+}
+
+} // namespace
+
+TEST(CandleAggregatorTest, period_start_alignment)
+{
+    // 2024-01-17 10:37:00 UTC, a Wednesday
+    const std::int64_t time = 1705487820000;
+
+    EXPECT_EQ(CandleAggregator::periodStart(PeriodCode::PERIOD_M5, time), time - 2 * minute);
+    EXPECT_EQ(CandleAggregator::periodStart(PeriodCode::PERIOD_H4, time), 1705478400000);
+    EXPECT_EQ(CandleAggregator::periodStart(PeriodCode::PERIOD_D1, time), 1705449600000);
+
+    // Monday 2024-01-15 and 2024-01-01
+    EXPECT_EQ(CandleAggregator::periodStart(PeriodCode::PERIOD_W1, time), 1705276800000);
+    EXPECT_EQ(CandleAggregator::periodStart(PeriodCode::PERIOD_MN1, time), 1704067200000);
+
+    // February 2024 has 29 days
+    EXPECT_EQ(CandleAggregator::periodEnd(PeriodCode::PERIOD_MN1, 1706745600000), 1706745600000 + 29 * day);
+    EXPECT_EQ(CandleAggregator::periodEnd(PeriodCode::PERIOD_W1, 1705276800000), 1705276800000 + 7 * day);
+}
+
+TEST(CandleAggregatorTest, ticks_build_bars)
+{
+    std::vector<ClosedBar> closed;
+    CandleAggregator aggregator([&closed](std::string_view symbol, PeriodCode period, const Candle &bar) {
+        closed.push_back(ClosedBar{std::string(symbol), period, bar});
+    });
+
+    aggregator.onTick(makeTick("EURUSD", 0, 1.10));
+    aggregator.onTick(makeTick("EURUSD", 20'000, 1.12));
+    aggregator.onTick(makeTick("EURUSD", 40'000, 1.09));
+    aggregator.onTick(makeTick("EURUSD", 50'000, 1.50, 1));
+    EXPECT_TRUE(closed.empty());
+
+    const auto current = aggregator.current("EURUSD", PeriodCode::PERIOD_M1);
+    ASSERT_TRUE(current.has_value());
+    EXPECT_DOUBLE_EQ(current->open, 1.10);
+    EXPECT_DOUBLE_EQ(current->high, 1.12);
+    EXPECT_DOUBLE_EQ(current->low, 1.09);
+    EXPECT_DOUBLE_EQ(current->close, 1.09);
+
+    aggregator.onTick(makeTick("EURUSD", minute + 1, 1.11));
+    ASSERT_EQ(closed.size(), 1u);
+    EXPECT_EQ(closed[0].symbol, "EURUSD");
+    EXPECT_EQ(closed[0].period, PeriodCode::PERIOD_M1);
+    EXPECT_EQ(closed[0].bar.ctm, 0);
+    EXPECT_DOUBLE_EQ(closed[0].bar.close, 1.09);
+
+    const auto m5 = aggregator.current("EURUSD", PeriodCode::PERIOD_M5);
+    ASSERT_TRUE(m5.has_value());
+    EXPECT_DOUBLE_EQ(m5->close, 1.11);
+    EXPECT_DOUBLE_EQ(m5->high, 1.12);
+}
+
+TEST(CandleAggregatorTest, candles_close_bars_at_their_end)
+{
+    std::vector<ClosedBar> closed;
+    CandleAggregator aggregator([&closed](std::string_view symbol, PeriodCode period, const Candle &bar) {
+        closed.push_back(ClosedBar{std::string(symbol), period, bar});
+    });
+
+    for (std::int64_t i = 0; i < 5; ++i)
+    {
+        aggregator.onCandle(makeCandle("US100", i * minute, 100.0 + i, 110.0 + i, 90.0 - i, 101.0 + i));
+    }
+
+    // Five M1 bars, then the M5 bar closed by its last candle
+    ASSERT_EQ(closed.size(), 6u);
+    const ClosedBar &m5 = closed.back();
+    EXPECT_EQ(m5.period, PeriodCode::PERIOD_M5);
+    EXPECT_EQ(m5.bar.ctm, 0);
+    EXPECT_DOUBLE_EQ(m5.bar.open, 100.0);
+    EXPECT_DOUBLE_EQ(m5.bar.high, 114.0);
+    EXPECT_DOUBLE_EQ(m5.bar.low, 86.0);
+    EXPECT_DOUBLE_EQ(m5.bar.close, 105.0);
+    EXPECT_DOUBLE_EQ(m5.bar.vol, 5.0);
+    EXPECT_FALSE(aggregator.current("US100", PeriodCode::PERIOD_M5).has_value());
+
+    const auto m15 = aggregator.current("US100", PeriodCode::PERIOD_M15);
+    ASSERT_TRUE(m15.has_value());
+    EXPECT_DOUBLE_EQ(m15->vol, 5.0);
+}
+
+TEST(CandleAggregatorTest, late_prices_are_ignored)
+{
+    CandleAggregator aggregator;
+    aggregator.onCandle(makeCandle("US100", 2 * minute, 100.0, 100.0, 100.0, 100.0));
+    aggregator.onCandle(makeCandle("US100", 2 * minute, 100.0, 100.0, 100.0, 100.0));
+    aggregator.onCandle(makeCandle("US100", minute, 100.0, 100.0, 100.0, 100.0));
+    aggregator.onTick(makeTick("EURUSD", 5 * minute, 1.1));
+    aggregator.onTick(makeTick("EURUSD", 4 * minute, 1.1));
+
+    EXPECT_EQ(aggregator.late(), 3u);
+    EXPECT_EQ(aggregator.symbolCount(), 2u);
+    EXPECT_DOUBLE_EQ(aggregator.current("US100", PeriodCode::PERIOD_M5)->vol, 1.0);
+}
+
+TEST(CandleAggregatorTest, close_expired_bars)
+{
+    std::vector<ClosedBar> closed;
+    CandleAggregator aggregator([&closed](std::string_view symbol, PeriodCode period, const Candle &bar) {
+        closed.push_back(ClosedBar{std::string(symbol), period, bar});
+    });
+
+    aggregator.onTick(makeTick("EURUSD", 10 * minute, 1.1));
+    EXPECT_EQ(aggregator.closeExpired(11 * minute - 1), 0u);
+    EXPECT_EQ(aggregator.closeExpired(14 * minute), 1u);
+    EXPECT_EQ(aggregator.closeExpired(15 * minute), 2u);
+    ASSERT_EQ(closed.size(), 3u);
+    EXPECT_EQ(closed[0].period, PeriodCode::PERIOD_M1);
+    EXPECT_EQ(closed[1].period, PeriodCode::PERIOD_M5);
+    EXPECT_EQ(closed[2].period, PeriodCode::PERIOD_M15);
+    EXPECT_TRUE(aggregator.current("EURUSD", PeriodCode::PERIOD_M30).has_value());
+}
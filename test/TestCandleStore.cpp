@@ -0,0 +1,133 @@
+#include "xapi/CandleStore.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <vector>
+
+using namespace xapi;
+
+namespace
+{
+
+constexpr std::int64_t minute = 60'000;
+
+std::vector<Candle> makeCandles(std::int64_t start, std::size_t count, double open = 1.1)
+{
+    std::vector<Candle> candles;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const double price = open + static_cast<double>(i % 7) * 0.0001;
+        candles.push_back(Candle{start + static_cast<std::int64_t>(i) * minute, price, price + 0.0002, price - 0.0003,
+                                 price + 0.0001, static_cast<double>(i)});
+    }
+    return candles;
+}
+
+} // namespace
+
+class CandleStoreTest : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_directory = std::filesystem::temp_directory_path() /
+                      ("xapi_candles_" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(m_directory);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(m_directory);
+    }
+
+    std::filesystem::path m_directory;
+};
+
+TEST_F(CandleStoreTest, merge_and_read)
+{
+    CandleStore store(m_directory);
+    const auto candles = makeCandles(0, 3000);
+    store.merge("EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 3000 * minute}, candles, 5);
+
+    EXPECT_EQ(store.size("EURUSD", PeriodCode::PERIOD_M1), 3000u);
+    EXPECT_EQ(store.size("EURUSD", PeriodCode::PERIOD_H1), 0u);
+
+    // Range inside the third block
+    const auto read = store.read("EURUSD", PeriodCode::PERIOD_M1, TimeRange{2100 * minute, 2110 * minute});
+    ASSERT_EQ(read.size(), 10u);
+    for (std::size_t i = 0; i < read.size(); ++i)
+    {
+        const Candle &expected = candles[2100 + i];
+        EXPECT_EQ(read[i].ctm, expected.ctm);
+        EXPECT_DOUBLE_EQ(read[i].open, expected.open);
+        EXPECT_DOUBLE_EQ(read[i].high, expected.high);
+        EXPECT_DOUBLE_EQ(read[i].low, expected.low);
+        EXPECT_DOUBLE_EQ(read[i].close, expected.close);
+        EXPECT_DOUBLE_EQ(read[i].vol, expected.vol);
+    }
+}
+
+TEST_F(CandleStoreTest, missing_ranges)
+{
+    CandleStore store(m_directory);
+    EXPECT_EQ(store.missing("US100", PeriodCode::PERIOD_M5, TimeRange{0, 100}),
+              (std::vector<TimeRange>{TimeRange{0, 100}}));
+
+    store.merge("US100", PeriodCode::PERIOD_M5, TimeRange{20, 40}, {}, 1);
+    store.merge("US100", PeriodCode::PERIOD_M5, TimeRange{60, 80}, {}, 1);
+    EXPECT_EQ(store.missing("US100", PeriodCode::PERIOD_M5, TimeRange{0, 100}),
+              (std::vector<TimeRange>{TimeRange{0, 20}, TimeRange{40, 60}, TimeRange{80, 100}}));
+    EXPECT_EQ(store.missing("US100", PeriodCode::PERIOD_M5, TimeRange{25, 70}),
+              (std::vector<TimeRange>{TimeRange{40, 60}}));
+
+    // Adjacent ranges are coalesced
+    store.merge("US100", PeriodCode::PERIOD_M5, TimeRange{40, 60}, {}, 1);
+    EXPECT_TRUE(store.missing("US100", PeriodCode::PERIOD_M5, TimeRange{20, 80}).empty());
+}
+
+TEST_F(CandleStoreTest, new_candles_replace_stored)
+{
+    CandleStore store(m_directory);
+    store.merge("EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 10 * minute}, makeCandles(0, 10, 1.1), 5);
+    store.merge("EURUSD", PeriodCode::PERIOD_M1, TimeRange{5 * minute, 15 * minute},
+                makeCandles(5 * minute, 10, 1.2), 5);
+
+    const auto read = store.read("EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 15 * minute});
+    ASSERT_EQ(read.size(), 15u);
+    EXPECT_DOUBLE_EQ(read[4].open, 1.1004);
+    EXPECT_DOUBLE_EQ(read[5].open, 1.2);
+}
+
+TEST_F(CandleStoreTest, persisted_between_stores)
+{
+    {
+        CandleStore store(m_directory);
+        store.merge("EURUSD", PeriodCode::PERIOD_D1, TimeRange{0, 100 * minute}, makeCandles(0, 100), 5);
+    }
+
+    CandleStore store(m_directory);
+    EXPECT_EQ(store.size("EURUSD", PeriodCode::PERIOD_D1), 100u);
+    EXPECT_TRUE(store.missing("EURUSD", PeriodCode::PERIOD_D1, TimeRange{0, 100 * minute}).empty());
+    EXPECT_TRUE(std::filesystem::exists(store.seriesFile("EURUSD", PeriodCode::PERIOD_D1)));
+}
+
+TEST_F(CandleStoreTest, digits_changed)
+{
+    CandleStore store(m_directory);
+    store.merge("US100", PeriodCode::PERIOD_H1, TimeRange{}, makeCandles(0, 2, 15000.5), 1);
+    store.merge("US100", PeriodCode::PERIOD_H1, TimeRange{}, makeCandles(2 * minute, 1, 15000.25), 2);
+
+    const auto read = store.read("US100", PeriodCode::PERIOD_H1, TimeRange{0, 3 * minute});
+    ASSERT_EQ(read.size(), 3u);
+    EXPECT_DOUBLE_EQ(read[0].open, 15000.5);
+    EXPECT_DOUBLE_EQ(read[2].open, 15000.25);
+}
+
+TEST_F(CandleStoreTest, invalid_candles)
+{
+    CandleStore store(m_directory);
+    const std::vector<Candle> fractional{Candle{1500, 1.0, 1.0, 1.0, 1.0, 0.0}};
+    EXPECT_THROW(store.merge("EURUSD", PeriodCode::PERIOD_M1, TimeRange{}, fractional, 5), std::invalid_argument);
+
+    const std::vector<Candle> huge{Candle{0, 1.0e20, 1.0e20, 1.0e20, 1.0e20, 0.0}};
+    EXPECT_THROW(store.merge("EURUSD", PeriodCode::PERIOD_M1, TimeRange{}, huge, 5), std::range_error);
+}
@@ -0,0 +1,109 @@
+#include "xapi/Command.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace xapi;
+
+TEST(CommandTest, writeTo_command_without_arguments)
+{
+    const internals::Command command("getVersion");
+
+    std::string buffer;
+    command.writeTo(buffer);
+    EXPECT_EQ(buffer, R"({"command":"getVersion"})");
+}
+
+TEST(CommandTest, writeTo_nested_arguments)
+{
+    const std::string symbol("EURUSD");
+    internals::Command command("getChartLastRequest");
+    command.beginObject("arguments")
+        .beginObject("info")
+            .add("period", 5)
+            .add("start", std::int64_t(1262944112000))
+            .add("symbol", symbol)
+        .endObject()
+        .endObject();
+
+    std::string buffer;
+    command.writeTo(buffer);
+    EXPECT_EQ(buffer,
+              R"({"command":"getChartLastRequest","arguments":{"info":{"period":5,"start":1262944112000,"symbol":"EURUSD"}}})");
+}
+
+TEST(CommandTest, writeTo_appends_custom_tag)
+{
+    const internals::Command command("ping");
+
+    std::string buffer;
+    command.writeTo(buffer, 42);
+    EXPECT_EQ(buffer, R"({"command":"ping","customTag":"42"})");
+}
+
+TEST(CommandTest, writeTo_prerendered_member)
+{
+    const internals::PrerenderedMember sessionMember("streamSessionId", "abc");
+    internals::Command command("getTickPrices");
+    command.add(sessionMember).add("symbol", "EURUSD").add("minArrivalTime", 0).add("maxLevel", 2);
+
+    std::string buffer;
+    command.writeTo(buffer);
+    EXPECT_EQ(buffer, R"({"command":"getTickPrices","streamSessionId":"abc","symbol":"EURUSD","minArrivalTime":0,"maxLevel":2})");
+}
+
+TEST(CommandTest, writeTo_escapes_strings)
+{
+    internals::Command command("tradeTransaction");
+    command.add("customComment", "quote \" backslash \\ newline \n tab \t control \x01");
+
+    std::string buffer;
+    command.writeTo(buffer);
+    EXPECT_EQ(buffer,
+              R"({"command":"tradeTransaction","customComment":"quote \" backslash \\ newline \n tab \t control \u0001"})");
+}
+
+TEST(CommandTest, writeTo_matches_toJson)
+{
+    const std::vector<std::string> symbols = {"EURUSD", "US100"};
+    const std::vector<int> orders = {1, 2, 3};
+    internals::Command command("getTickPrices");
+    command.beginObject("arguments")
+        .add("symbols", symbols)
+        .add("orders", orders)
+        .add("openedOnly", true)
+        .add("volume", 0.1f)
+        .add("price", 1.0)
+        .endObject();
+
+    std::string buffer;
+    command.writeTo(buffer);
+    EXPECT_EQ(boost::json::parse(buffer).as_object(), command.toJson());
+    EXPECT_NE(buffer.find(R"("price":1.0)"), std::string::npos);
+}
+
+TEST(CommandTest, toJson_builds_equivalent_object)
+{
+    const internals::PrerenderedMember sessionMember("streamSessionId", "abc");
+    internals::Command command("getCandles");
+    command.add(sessionMember).add("symbol", "US100");
+
+    const boost::json::object expected = {
+        {"command", "getCandles"},
+        {"streamSessionId", "abc"},
+        {"symbol", "US100"}
+    };
+    const boost::json::object converted = command;
+    EXPECT_EQ(command.toJson(), expected);
+    EXPECT_EQ(converted, expected);
+}
+
+TEST(CommandTest, add_throws_when_full)
+{
+    internals::Command command("test");
+    for (std::size_t i = 0; i < internals::Command::maxMembers; ++i)
+    {
+        command.add("key", 1);
+    }
+    EXPECT_THROW(command.add("key", 1), std::length_error);
+}
@@ -111,3 +111,24 @@ TEST_F(ConnectionTest, waitResponse_exception)
     EXPECT_THROW(result = runAwaitable(connection.waitResponse()), exception::ConnectionClosed);
     EXPECT_TRUE(result.empty());
 }
+
+TEST_F(ConnectionTest, request_exception)
+{
+    internals::Connection connection(getIoContext());
+
+    const internals::Command command("invalid");
+    boost::json::object result;
+    EXPECT_THROW(result = runAwaitable(connection.request(command)), exception::ConnectionClosed);
+    EXPECT_TRUE(result.empty());
+}
+
+TEST_F(ConnectionTest, waitResponse_arena_exception)
+{
+    internals::Connection connection(getIoContext());
+    EXPECT_NO_THROW(connection.setArenaParsing(true));
+
+    boost::json::object result;
+    EXPECT_THROW(result = runAwaitable(connection.waitResponse()), exception::ConnectionClosed);
+    EXPECT_TRUE(result.empty());
+    EXPECT_NO_THROW(connection.setArenaParsing(false));
+}
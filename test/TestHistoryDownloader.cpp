@@ -0,0 +1,227 @@
+#include "xapi/Exceptions.hpp"
+#include "xapi/HistoryDownloader.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace xapi
+{
+
+namespace
+{
+
+constexpr std::int64_t minute = 60'000;
+
+// Answers chart requests with one candle per minute of the range, after a short delay so the
+// sessions interleave. The first requests fail or close the connection when asked to.
+class ChartConnection final : public internals::IConnection
+{
+  public:
+    ChartConnection(std::size_t failures, bool closes) : requests(0), m_failures(failures), m_closes(closes)
+    {
+    }
+
+    boost::asio::awaitable<void> connect(const boost::url &) override
+    {
+        co_return;
+    }
+
+    boost::asio::awaitable<void> disconnect() override
+    {
+        co_return;
+    }
+
+    boost::asio::awaitable<void> makeRequest(const internals::Command &) override
+    {
+        co_return;
+    }
+
+    boost::asio::awaitable<boost::json::object> waitResponse() override
+    {
+        co_return boost::json::object();
+    }
+
+    boost::asio::awaitable<std::string_view> waitFrame() override
+    {
+        throw exception::ConnectionClosed("No stream");
+        co_return std::string_view();
+    }
+
+    boost::asio::awaitable<boost::json::object> request(const internals::Command &command) override
+    {
+        ++requests;
+        boost::asio::steady_timer delay(co_await boost::asio::this_coro::executor, std::chrono::milliseconds(1));
+        co_await delay.async_wait(boost::asio::use_awaitable);
+
+        if (m_closes)
+        {
+            throw exception::ConnectionClosed("Connection closed by the server");
+        }
+        if (m_failures > 0)
+        {
+            --m_failures;
+            co_return boost::json::object{{"status", false}, {"errorCode", "EX009"}};
+        }
+
+        const boost::json::object info = command.toJson().at("arguments").at("info").as_object();
+        boost::json::array rateInfos;
+        for (std::int64_t ctm = info.at("start").as_int64(); ctm < info.at("end").as_int64(); ctm += minute)
+        {
+            rateInfos.push_back(boost::json::object{
+                {"ctm", ctm}, {"open", 110000 + ctm / minute}, {"high", 2}, {"low", -1}, {"close", 1}, {"vol", 1.0}});
+        }
+        co_return boost::json::object{
+            {"status", true}, {"returnData", boost::json::object{{"digits", 5}, {"rateInfos", rateInfos}}}};
+    }
+
+    std::size_t requests;
+
+  private:
+    std::size_t m_failures;
+    bool m_closes;
+};
+
+} // namespace
+
+class HistoryDownloaderTest : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_directory = std::filesystem::temp_directory_path() /
+                      ("xapi_history_" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(m_directory);
+        m_store = std::make_unique<CandleStore>(m_directory);
+    }
+
+    void TearDown() override
+    {
+        m_sessions.clear();
+        m_store.reset();
+        std::filesystem::remove_all(m_directory);
+    }
+
+    ChartConnection &addSession(std::size_t failures, bool closes)
+    {
+        auto connection = std::make_unique<ChartConnection>(failures, closes);
+        ChartConnection &result = *connection;
+        m_sessions.push_back(std::make_unique<XStationClient>(m_context, "test", "test", "demo"));
+        m_sessions.back()->m_connection = std::move(connection);
+        return result;
+    }
+
+    DownloadProgress download(std::size_t maxAttempts, const std::vector<HistoryJob> &downloadJobs = jobs())
+    {
+        std::vector<XStationClient *> sessions;
+        for (const auto &session : m_sessions)
+        {
+            sessions.push_back(session.get());
+        }
+        HistoryDownloader downloader(sessions, *m_store);
+        downloader.setChunkCandles(3);
+        downloader.setRetry(maxAttempts, std::chrono::milliseconds(1));
+
+        DownloadProgress progress;
+        std::exception_ptr eptr;
+        boost::asio::co_spawn(m_context, downloader.run(downloadJobs),
+                              [&](std::exception_ptr e, DownloadProgress result) {
+                                  eptr = e;
+                                  progress = result;
+                              });
+        m_context.run();
+        if (eptr)
+        {
+            std::rethrow_exception(eptr);
+        }
+        return progress;
+    }
+
+    static std::vector<HistoryJob> jobs()
+    {
+        return {HistoryJob{"EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 10 * minute}}};
+    }
+
+    // Checks that the store holds every candle of the job exactly once.
+    void expectAllCandles()
+    {
+        const std::vector<Candle> candles = m_store->read("EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 10 * minute});
+        ASSERT_EQ(candles.size(), 10u);
+        for (std::size_t i = 0; i < candles.size(); ++i)
+        {
+            EXPECT_EQ(candles[i].ctm, static_cast<std::int64_t>(i) * minute);
+            EXPECT_DOUBLE_EQ(candles[i].open, (110000.0 + static_cast<double>(i)) / 100000.0);
+        }
+        EXPECT_TRUE(m_store->missing("EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 10 * minute}).empty());
+    }
+
+    boost::asio::io_context m_context;
+    std::filesystem::path m_directory;
+    std::unique_ptr<CandleStore> m_store;
+    std::vector<std::unique_ptr<XStationClient>> m_sessions;
+};
+
+TEST_F(HistoryDownloaderTest, failed_chunk_retried)
+{
+    addSession(0, false);
+    ChartConnection &failing = addSession(1, false);
+
+    const DownloadProgress progress = download(3);
+
+    EXPECT_EQ(progress.totalChunks, 4u);
+    EXPECT_EQ(progress.completedChunks, 4u);
+    EXPECT_EQ(progress.failedChunks, 0u);
+    EXPECT_EQ(progress.completedJobs, 1u);
+    EXPECT_EQ(progress.candles, 10u);
+    EXPECT_GE(failing.requests, 1u);
+    expectAllCandles();
+}
+
+TEST_F(HistoryDownloaderTest, closed_session_chunks_taken_over)
+{
+    ChartConnection &healthy = addSession(0, false);
+    ChartConnection &closing = addSession(0, true);
+
+    const DownloadProgress progress = download(3);
+
+    EXPECT_EQ(progress.completedChunks, 4u);
+    EXPECT_EQ(progress.failedChunks, 0u);
+    EXPECT_EQ(progress.candles, 10u);
+    EXPECT_EQ(closing.requests, 1u);
+    EXPECT_EQ(healthy.requests, 4u);
+    expectAllCandles();
+}
+
+TEST_F(HistoryDownloaderTest, chunks_failed_after_last_attempt)
+{
+    ChartConnection &failing = addSession(100, false);
+
+    const DownloadProgress progress = download(2);
+
+    EXPECT_EQ(progress.completedChunks, 0u);
+    EXPECT_EQ(progress.failedChunks, 4u);
+    EXPECT_EQ(progress.completedJobs, 1u);
+    EXPECT_EQ(progress.candles, 0u);
+    EXPECT_EQ(failing.requests, 8u);
+    EXPECT_EQ(m_store->missing("EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 10 * minute}).size(), 1u);
+}
+
+TEST_F(HistoryDownloaderTest, failed_merge_reported)
+{
+    addSession(0, false);
+
+    // Candle times off whole seconds cannot be stored, the job is reported and the next one downloaded
+    std::vector<HistoryJob> downloadJobs = {HistoryJob{"US100", PeriodCode::PERIOD_M1, TimeRange{500, 3 * minute}}};
+    downloadJobs.push_back(jobs().front());
+    const DownloadProgress progress = download(1, downloadJobs);
+
+    EXPECT_EQ(progress.totalJobs, 2u);
+    EXPECT_EQ(progress.failedJobs, 1u);
+    EXPECT_EQ(progress.completedJobs, 1u);
+    EXPECT_EQ(progress.failedChunks, 0u);
+    EXPECT_FALSE(m_store->missing("US100", PeriodCode::PERIOD_M1, TimeRange{500, 3 * minute}).empty());
+    expectAllCandles();
+}
+
+} // namespace xapi
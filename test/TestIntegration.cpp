@@ -0,0 +1,451 @@
+#include "mockserver/MockServer.hpp"
+#include "xapi/Connection.hpp"
+#include "xapi/Exceptions.hpp"
+#include "xapi/HistoryDownloader.hpp"
+#include "xapi/XStationClient.hpp"
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace xapi
+{
+
+class IntegrationTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        server = std::make_unique<mock::MockServer>(m_context);
+        server->start();
+
+        client = std::make_unique<XStationClient>(m_context, "accountId", "password");
+        client->setServerUrl(server->url());
+    }
+
+    void TearDown() override
+    {
+        client.reset();
+        server.reset();
+    }
+
+    boost::asio::io_context &getIoContext()
+    {
+        return m_context;
+    }
+
+    // Runs the test coroutine against the mock server and rethrows its exception, if any.
+    template <typename Function> void runTest(Function &&function)
+    {
+        std::exception_ptr eptr;
+        boost::asio::co_spawn(m_context, std::forward<Function>(function), [&](std::exception_ptr e) {
+            eptr = e;
+            m_context.stop();
+        });
+
+        m_context.run();
+
+        if (eptr)
+        {
+            std::rethrow_exception(eptr);
+        }
+    }
+
+    std::unique_ptr<mock::MockServer> server;
+    std::unique_ptr<XStationClient> client;
+
+  private:
+    boost::asio::io_context m_context;
+};
+
+TEST_F(IntegrationTest, login_request_logout)
+{
+    boost::json::object version;
+    EXPECT_NO_THROW(runTest([&]() -> boost::asio::awaitable<void> {
+        co_await client->login();
+        version = co_await client->getVersion();
+        co_await client->logout();
+    }));
+
+    EXPECT_EQ(version["status"], true);
+    EXPECT_EQ(version["returnData"].as_object()["version"], "2.5.0");
+    EXPECT_EQ(server->requestCount(), 3);
+
+    const MetricsSnapshot metrics = client->metrics();
+    ASSERT_TRUE(metrics.commands.contains("getVersion"));
+    EXPECT_EQ(metrics.commands.at("getVersion").roundTrip.count(), 1);
+    EXPECT_EQ(metrics.commands.at("login").queueWait.count(), 1);
+    EXPECT_EQ(metrics.messagesSent, 3);
+    EXPECT_EQ(metrics.messagesReceived, 3);
+    EXPECT_GT(metrics.bytesReceived, 0);
+}
+
+TEST_F(IntegrationTest, client_session_recorded)
+{
+    const auto journal = std::filesystem::temp_directory_path() / "xapi_client_session.journal";
+    auto recorder = std::make_shared<SessionRecorder>(journal);
+    client->setRecorder(recorder);
+
+    EXPECT_NO_THROW(runTest([&]() -> boost::asio::awaitable<void> {
+        co_await client->login();
+        co_await client->getVersion();
+        co_await client->logout();
+    }));
+
+    // Responses to login, getVersion and logout
+    EXPECT_EQ(recorder->frames(), 3u);
+    recorder.reset();
+    std::filesystem::remove(journal);
+}
+
+TEST_F(IntegrationTest, login_failed)
+{
+    XStationClient invalidClient(getIoContext(), "accountId", "invalid");
+    invalidClient.setServerUrl(server->url());
+
+    EXPECT_THROW(runTest([&]() -> boost::asio::awaitable<void> { co_await invalidClient.login(); }),
+                 exception::LoginFailed);
+}
+
+TEST_F(IntegrationTest, pipelined_requests)
+{
+    server->setResponse("getSymbol", boost::json::object{{"symbol", "US100"}});
+
+    std::vector<boost::json::object> results(8);
+    EXPECT_NO_THROW(runTest([&]() -> boost::asio::awaitable<void> {
+        co_await client->login();
+
+        auto executor = co_await boost::asio::this_coro::executor;
+        std::size_t completed = 0;
+        boost::asio::steady_timer done(executor, boost::asio::steady_timer::time_point::max());
+        for (auto &result : results)
+        {
+            boost::asio::co_spawn(
+                executor,
+                [&]() -> boost::asio::awaitable<void> {
+                    result = co_await client->getSymbol("US100");
+                    if (++completed == results.size())
+                    {
+                        done.cancel();
+                    }
+                },
+                boost::asio::detached);
+        }
+        boost::system::error_code ec;
+        co_await done.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+
+        co_await client->logout();
+    }));
+
+    for (auto &result : results)
+    {
+        EXPECT_EQ(result["returnData"].as_object()["symbol"], "US100");
+    }
+}
+
+TEST_F(IntegrationTest, responses_out_of_order)
+{
+    // Responses are sent in reverse order, after a response with an unknown customTag
+    mock::MockServerOptions options;
+    options.reversedResponseBatch = 3;
+    mock::MockServer reorderingServer(getIoContext(), options);
+    reorderingServer.setResponse("getSymbol", boost::json::object{{"symbol", "US100"}});
+    reorderingServer.setResponse("getVersion", boost::json::object{{"version", "2.5.0"}});
+    reorderingServer.setResponse("getCurrentUserData", boost::json::object{{"currency", "EUR"}});
+    reorderingServer.start();
+
+    XStationClient reorderingClient(getIoContext(), "accountId", "password");
+    reorderingClient.setServerUrl(reorderingServer.url());
+
+    boost::json::object symbol;
+    boost::json::object version;
+    boost::json::object userData;
+    EXPECT_NO_THROW(runTest([&]() -> boost::asio::awaitable<void> {
+        using namespace boost::asio::experimental::awaitable_operators;
+
+        co_await reorderingClient.login();
+        std::tie(symbol, version, userData) =
+            co_await (reorderingClient.getSymbol("US100") && reorderingClient.getVersion() &&
+                      reorderingClient.getCurrentUserData());
+        co_await reorderingClient.logout();
+    }));
+
+    EXPECT_EQ(symbol["returnData"].as_object()["symbol"], "US100");
+    EXPECT_EQ(version["returnData"].as_object()["version"], "2.5.0");
+    EXPECT_EQ(userData["returnData"].as_object()["currency"], "EUR");
+}
+
+TEST_F(IntegrationTest, disconnect_waits_for_requests_in_flight)
+{
+    // The server holds the response until a second command arrives
+    mock::MockServerOptions options;
+    options.reversedResponseBatch = 2;
+    mock::MockServer holdingServer(getIoContext(), options);
+    holdingServer.start();
+
+    auto connection = std::make_unique<internals::Connection>(getIoContext());
+    bool requestFailed = false;
+    EXPECT_NO_THROW(runTest([&]() -> boost::asio::awaitable<void> {
+        boost::url url(holdingServer.url());
+        url.set_path("/demo");
+        co_await connection->connect(url);
+
+        const auto executor = co_await boost::asio::this_coro::executor;
+        boost::asio::co_spawn(
+            executor,
+            [&]() -> boost::asio::awaitable<void> {
+                try
+                {
+                    co_await connection->request(internals::Command("getVersion"));
+                }
+                catch (const exception::ConnectionClosed &)
+                {
+                    requestFailed = true;
+                }
+            },
+            boost::asio::detached);
+
+        boost::asio::steady_timer timer(executor);
+        while (holdingServer.requestCount() == 0)
+        {
+            timer.expires_after(std::chrono::milliseconds(1));
+            co_await timer.async_wait(boost::asio::use_awaitable);
+        }
+
+        // The request and the reader have returned once disconnect() does, so the connection can go
+        co_await connection->disconnect();
+        connection.reset();
+    }));
+
+    EXPECT_TRUE(requestFailed);
+}
+
+TEST_F(IntegrationTest, requests_from_several_threads)
+{
+    // The server runs on its own thread, the client context is run by several threads.
+    boost::asio::io_context serverContext;
+    mock::MockServer threadedServer(serverContext);
+    threadedServer.setResponse("getSymbol", boost::json::object{{"symbol", "US100"}});
+    threadedServer.start();
+    auto serverWork = boost::asio::make_work_guard(serverContext);
+    std::thread serverThread([&serverContext]() { serverContext.run(); });
+
+    boost::asio::io_context clientContext;
+    XStationClient threadedClient(clientContext, "accountId", "password");
+    threadedClient.setServerUrl(threadedServer.url());
+    threadedClient.setRateLimit(1000000, 1e9);
+
+    // The keep-alive task keeps the context running, it is stopped once logged in.
+    std::exception_ptr loginError;
+    boost::asio::co_spawn(clientContext, threadedClient.login(), [&](std::exception_ptr e) {
+        loginError = e;
+        clientContext.stop();
+    });
+    clientContext.run();
+    clientContext.restart();
+    ASSERT_FALSE(loginError);
+
+    constexpr std::size_t requests = 64;
+    std::atomic<std::size_t> completed = 0;
+    std::atomic<std::size_t> succeeded = 0;
+    for (std::size_t i = 0; i < requests; ++i)
+    {
+        // Half of the requests hop to the client strand, the other half run on it
+        const auto executor = i % 2 == 0 ? boost::asio::any_io_executor(clientContext.get_executor())
+                                         : boost::asio::any_io_executor(threadedClient.executor());
+        boost::asio::co_spawn(
+            executor,
+            [&]() -> boost::asio::awaitable<void> {
+                const auto result = co_await threadedClient.getSymbol("US100");
+                if (result.at("returnData").as_object().at("symbol") == "US100")
+                {
+                    ++succeeded;
+                }
+            },
+            [&](std::exception_ptr) {
+                if (++completed == requests)
+                {
+                    boost::asio::co_spawn(clientContext, threadedClient.logout(),
+                                          [&](std::exception_ptr) { clientContext.stop(); });
+                }
+            });
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&clientContext]() { clientContext.run(); });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    serverWork.reset();
+    serverContext.stop();
+    serverThread.join();
+
+    EXPECT_EQ(succeeded, requests);
+    EXPECT_EQ(threadedServer.requestCount(), requests + 2);
+}
+
+TEST_F(IntegrationTest, stream_ticks)
+{
+    mock::StreamScript script;
+    script.repeat = 3;
+    server->setStreamScript(script);
+
+    std::vector<TickRecord> ticks;
+    EXPECT_NO_THROW(runTest([&]() -> boost::asio::awaitable<void> {
+        auto stream = co_await client->loginWithStream();
+        co_await stream.getTickPrices("EURUSD");
+        while (ticks.size() < 3)
+        {
+            const StreamRecord record = co_await stream.listenTyped();
+            if (std::holds_alternative<TickRecord>(record))
+            {
+                ticks.push_back(std::get<TickRecord>(record));
+            }
+        }
+        co_await stream.close();
+        co_await client->logout();
+    }));
+
+    ASSERT_EQ(ticks.size(), 3);
+    EXPECT_EQ(ticks[0].symbol, "EURUSD");
+    EXPECT_EQ(server->streamedFrames(), 3);
+}
+
+TEST_F(IntegrationTest, direct_client_streams_ticks)
+{
+    mock::StreamScript script;
+    script.repeat = 2;
+    server->setStreamScript(script);
+
+    DirectXStationClient direct(getIoContext(), "accountId", "password");
+    direct.setServerUrl(server->url());
+
+    boost::json::object version;
+    StreamRecord record;
+    EXPECT_NO_THROW(runTest([&]() -> boost::asio::awaitable<void> {
+        DirectXStationClientStream stream = co_await direct.loginWithStream();
+        version = co_await direct.getVersion();
+        co_await stream.getTickPrices("EURUSD");
+        do
+        {
+            co_await stream.listenTyped(record);
+        } while (!std::holds_alternative<TickRecord>(record));
+        co_await stream.close();
+        co_await direct.logout();
+    }));
+
+    EXPECT_EQ(version["status"], true);
+    ASSERT_TRUE(std::holds_alternative<TickRecord>(record));
+    EXPECT_EQ(std::get<TickRecord>(record).symbol, "EURUSD");
+}
+
+TEST_F(IntegrationTest, tls_session_resumed)
+{
+    auto tlsContext = std::make_shared<internals::TlsContext>();
+    internals::Connection first(getIoContext(), nullptr, tlsContext);
+    internals::Connection second(getIoContext(), nullptr, tlsContext);
+
+    bool resumed = false;
+    EXPECT_NO_THROW(runTest([&]() -> boost::asio::awaitable<void> {
+        boost::url url(server->url());
+        url.set_path("/demo");
+
+        co_await first.connect(url);
+        co_await second.connect(url);
+        resumed = second.isSessionResumed();
+
+        co_await second.disconnect();
+        co_await first.disconnect();
+    }));
+
+    EXPECT_FALSE(first.isSessionResumed());
+    EXPECT_TRUE(resumed);
+}
+
+TEST_F(IntegrationTest, pipelined_requests_with_arena_parsing)
+{
+    server->setResponse("getSymbol", boost::json::object{{"symbol", "US100"}});
+    server->setResponse("getVersion", boost::json::object{{"version", "2.5.0"}});
+
+    // The first response must stay valid while the reader task reads the second one
+    internals::Connection connection(getIoContext());
+    connection.setArenaParsing(true);
+    boost::json::object symbol;
+    boost::json::object version;
+    EXPECT_NO_THROW(runTest([&]() -> boost::asio::awaitable<void> {
+        using namespace boost::asio::experimental::awaitable_operators;
+
+        boost::url url(server->url());
+        url.set_path("/demo");
+        co_await connection.connect(url);
+        std::tie(symbol, version) =
+            co_await (connection.request(internals::Command("getSymbol")) &&
+                      connection.request(internals::Command("getVersion")));
+        co_await connection.disconnect();
+    }));
+
+    EXPECT_EQ(symbol["returnData"].as_object()["symbol"], "US100");
+    EXPECT_EQ(version["returnData"].as_object()["version"], "2.5.0");
+}
+
+TEST_F(IntegrationTest, history_downloaded_in_chunks)
+{
+    constexpr std::int64_t minute = 60'000;
+    boost::json::array rateInfos;
+    for (std::int64_t i = 0; i < 10; ++i)
+    {
+        rateInfos.push_back(boost::json::object{
+            {"ctm", i * minute}, {"open", 110000.0 + i}, {"high", 2.0}, {"low", -1.0}, {"close", 1.0}, {"vol", 1.0}});
+    }
+    server->setResponse("getChartRangeRequest", boost::json::object{{"digits", 5}, {"rateInfos", rateInfos}});
+
+    const auto directory = std::filesystem::temp_directory_path() / "xapi_history_download";
+    std::filesystem::remove_all(directory);
+    CandleStore store(directory);
+
+    XStationClient second(getIoContext(), "accountId", "password");
+    second.setServerUrl(server->url());
+
+    HistoryDownloader downloader({client.get(), &second}, store);
+    downloader.setChunkCandles(3);
+    std::size_t reports = 0;
+    downloader.setProgressHandler([&reports](const DownloadProgress &) { ++reports; });
+
+    const std::vector<HistoryJob> jobs{HistoryJob{"EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 10 * minute}}};
+    DownloadProgress progress;
+    EXPECT_NO_THROW(runTest([&]() -> boost::asio::awaitable<void> {
+        co_await client->login();
+        co_await second.login();
+        progress = co_await downloader.run(jobs);
+        co_await client->logout();
+        co_await second.logout();
+    }));
+
+    EXPECT_EQ(progress.totalChunks, 4u);
+    EXPECT_EQ(progress.completedChunks, 4u);
+    EXPECT_EQ(progress.failedChunks, 0u);
+    EXPECT_EQ(progress.completedJobs, 1u);
+    EXPECT_EQ(reports, 4u);
+
+    const std::vector<Candle> candles = store.read("EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 10 * minute});
+    ASSERT_EQ(candles.size(), 10u);
+    EXPECT_DOUBLE_EQ(candles[9].open, 1.10009);
+    EXPECT_TRUE(store.missing("EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 10 * minute}).empty());
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(IntegrationTest, history_downloader_needs_session)
+{
+    CandleStore store(std::filesystem::temp_directory_path() / "xapi_history_download");
+    EXPECT_THROW(HistoryDownloader(std::vector<XStationClient *>{}, store), std::invalid_argument);
+}
+
+} // namespace xapi
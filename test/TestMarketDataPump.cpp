@@ -0,0 +1,66 @@
+#include "xapi/MarketDataPump.hpp"
+#include <gtest/gtest.h>
+
+using namespace xapi;
+
+class MarketDataPumpTest : public testing::Test
+{
+  protected:
+    boost::asio::io_context m_context;
+    XStationClientStream m_stream{m_context, "demo", "testStreamSessionId"};
+    SpscRing<MarketRecord> m_ring{2};
+    MarketDataPump<SpscRing<MarketRecord>> m_pump{m_stream, m_ring};
+};
+
+TEST_F(MarketDataPumpTest, publish_ticks_and_candles)
+{
+    EXPECT_TRUE(m_pump.publish(R"({"command":"tickPrices","data":{"symbol":"EURUSD","ask":1.1,"bid":1.09}})"));
+    EXPECT_TRUE(m_pump.publish(R"({"command":"candle","data":{"symbol":"US100","close":15000.5}})"));
+    EXPECT_EQ(m_pump.published(), 2u);
+
+    MarketRecord record;
+    ASSERT_TRUE(m_ring.tryPop(record));
+    ASSERT_TRUE(std::holds_alternative<TickRecord>(record));
+    EXPECT_EQ(std::get<TickRecord>(record).symbol, "EURUSD");
+    EXPECT_DOUBLE_EQ(std::get<TickRecord>(record).ask, 1.1);
+
+    ASSERT_TRUE(m_ring.tryPop(record));
+    ASSERT_TRUE(std::holds_alternative<CandleRecord>(record));
+    EXPECT_DOUBLE_EQ(std::get<CandleRecord>(record).close, 15000.5);
+}
+
+TEST_F(MarketDataPumpTest, skip_other_records)
+{
+    // Not parsed, so invalid JSON does not throw
+    EXPECT_FALSE(m_pump.publish(R"({"command":"keepAlive","data":{)"));
+    EXPECT_FALSE(m_pump.publish(R"({"command":"balance","data":{"balance":1000.0}})"));
+    EXPECT_EQ(m_pump.skipped(), 2u);
+    EXPECT_TRUE(m_ring.empty());
+}
+
+TEST_F(MarketDataPumpTest, drop_when_ring_full)
+{
+    const std::string_view tick = R"({"command":"tickPrices","data":{"symbol":"EURUSD"}})";
+    EXPECT_TRUE(m_pump.publish(tick));
+    EXPECT_TRUE(m_pump.publish(tick));
+    EXPECT_FALSE(m_pump.publish(tick));
+    EXPECT_EQ(m_pump.published(), 2u);
+    EXPECT_EQ(m_pump.dropped(), 1u);
+}
+
+TEST_F(MarketDataPumpTest, publish_to_broadcast_ring)
+{
+    BroadcastRing<MarketRecord> ring(4, 2);
+    MarketDataPump<BroadcastRing<MarketRecord>> pump(m_stream, ring);
+    EXPECT_TRUE(pump.publish(R"({"command":"candle","data":{"symbol":"US100","close":1.0}})"));
+
+    MarketRecord record;
+    EXPECT_TRUE(ring.tryPop(0, record));
+    EXPECT_TRUE(ring.tryPop(1, record));
+    EXPECT_EQ(std::get<CandleRecord>(record).symbol, "US100");
+}
+
+TEST_F(MarketDataPumpTest, publish_invalid_json)
+{
+    EXPECT_THROW(m_pump.publish(R"({"command":"candle","data":{)"), boost::system::system_error);
+}
@@ -0,0 +1,99 @@
+#include "xapi/Metrics.hpp"
+#include <gtest/gtest.h>
+
+using namespace xapi;
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogramTest, empty)
+{
+    const LatencyHistogram histogram;
+    EXPECT_EQ(histogram.count(), 0);
+    EXPECT_EQ(histogram.percentile(50.0), 0us);
+    EXPECT_EQ(histogram.mean(), 0us);
+}
+
+TEST(LatencyHistogramTest, small_values_are_exact)
+{
+    LatencyHistogram histogram;
+    for (int i = 1; i <= 10; ++i)
+    {
+        histogram.record(std::chrono::microseconds(i));
+    }
+
+    EXPECT_EQ(histogram.count(), 10);
+    EXPECT_EQ(histogram.min(), 1us);
+    EXPECT_EQ(histogram.max(), 10us);
+    EXPECT_EQ(histogram.mean(), 5us);
+    EXPECT_EQ(histogram.percentile(50.0), 5us);
+    EXPECT_EQ(histogram.percentile(90.0), 9us);
+    EXPECT_EQ(histogram.percentile(100.0), 10us);
+}
+
+TEST(LatencyHistogramTest, large_values_within_relative_error)
+{
+    LatencyHistogram histogram;
+    for (int i = 1; i <= 1000; ++i)
+    {
+        histogram.record(std::chrono::milliseconds(i));
+    }
+
+    const auto p50 = histogram.percentile(50.0).count();
+    const auto p99 = histogram.percentile(99.0).count();
+    EXPECT_NEAR(p50, 500000, 500000 / 16);
+    EXPECT_NEAR(p99, 990000, 990000 / 16);
+    EXPECT_EQ(histogram.percentile(100.0), 1000ms);
+}
+
+TEST(LatencyHistogramTest, out_of_range_values_are_clamped)
+{
+    LatencyHistogram histogram;
+    histogram.record(-5us);
+    histogram.record(std::chrono::hours(24 * 365));
+
+    EXPECT_EQ(histogram.count(), 2);
+    EXPECT_EQ(histogram.min(), 0us);
+    EXPECT_EQ(histogram.percentile(100.0), std::chrono::hours(24 * 365));
+}
+
+TEST(LatencyHistogramTest, merge)
+{
+    LatencyHistogram first;
+    LatencyHistogram second;
+    first.record(10us);
+    second.record(20us);
+    second.record(30us);
+
+    first.merge(second);
+    EXPECT_EQ(first.count(), 3);
+    EXPECT_EQ(first.min(), 10us);
+    EXPECT_EQ(first.max(), 30us);
+
+    first.reset();
+    EXPECT_EQ(first.count(), 0);
+}
+
+TEST(MetricsRecorderTest, snapshot)
+{
+    internals::MetricsRecorder recorder;
+    recorder.recordRequest("getVersion", 1ms, 20ms, 15us);
+    recorder.recordRequest("getVersion", 0ms, 22ms, 17us);
+    recorder.recordRequest("getSymbol", 200ms, 25ms, 40us);
+    recorder.recordSent(100);
+    recorder.recordSent(50);
+    recorder.recordReceived(1000);
+
+    const MetricsSnapshot snapshot = recorder.snapshot();
+    ASSERT_EQ(snapshot.commands.size(), 2);
+    EXPECT_EQ(snapshot.commands.at("getVersion").roundTrip.count(), 2);
+    EXPECT_EQ(snapshot.commands.at("getVersion").roundTrip.max(), 22ms);
+    EXPECT_EQ(snapshot.commands.at("getSymbol").queueWait.max(), 200ms);
+    EXPECT_EQ(snapshot.commands.at("getSymbol").parse.max(), 40us);
+    EXPECT_EQ(snapshot.messagesSent, 2);
+    EXPECT_EQ(snapshot.bytesSent, 150);
+    EXPECT_EQ(snapshot.messagesReceived, 1);
+    EXPECT_EQ(snapshot.bytesReceived, 1000);
+
+    recorder.reset();
+    EXPECT_TRUE(recorder.snapshot().commands.empty());
+    EXPECT_EQ(recorder.snapshot().bytesSent, 0);
+}
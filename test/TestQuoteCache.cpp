@@ -0,0 +1,133 @@
+#include "xapi/QuoteCache.hpp"
+#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <thread>
+
+using namespace xapi;
+
+namespace
+{
+
+TickRecord makeTick(std::string_view symbol, double bid, double ask, int level = 0)
+{
+    TickRecord tick;
+    tick.symbol = SymbolName(symbol);
+    tick.bid = bid;
+    tick.ask = ask;
+    tick.level = level;
+    return tick;
+}
+
+} // namespace
+
+TEST(QuoteCacheTest, intern_symbols)
+{
+    QuoteCache cache(2);
+    EXPECT_EQ(cache.intern("EURUSD"), 0u);
+    EXPECT_EQ(cache.intern("US100"), 1u);
+    EXPECT_EQ(cache.intern("EURUSD"), 0u);
+    EXPECT_FALSE(cache.intern("GOLD").has_value());
+
+    EXPECT_EQ(cache.find("US100"), 1u);
+    EXPECT_FALSE(cache.find("GOLD").has_value());
+    EXPECT_EQ(cache.symbol(1), "US100");
+    EXPECT_TRUE(cache.symbol(2).empty());
+    EXPECT_EQ(cache.symbolCount(), 2u);
+}
+
+TEST(QuoteCacheTest, update_and_read_quote)
+{
+    QuoteCache cache;
+    EXPECT_TRUE(cache.update(makeTick("EURUSD", 1.0, 1.1)));
+    EXPECT_TRUE(cache.update(makeTick("EURUSD", 1.2, 1.3)));
+
+    const auto id = cache.find("EURUSD");
+    ASSERT_TRUE(id.has_value());
+
+    QuoteLevel quote;
+    ASSERT_TRUE(cache.quote(*id, quote));
+    EXPECT_DOUBLE_EQ(quote.bid, 1.2);
+    EXPECT_DOUBLE_EQ(quote.ask, 1.3);
+
+    // Level not received yet
+    EXPECT_FALSE(cache.quote(*id, quote, 1));
+    EXPECT_FALSE(cache.quote(7, quote));
+}
+
+TEST(QuoteCacheTest, update_by_id)
+{
+    QuoteCache cache(2, 2);
+    const auto id = cache.intern("US100");
+    ASSERT_TRUE(id.has_value());
+
+    EXPECT_TRUE(cache.update(*id, makeTick("US100", 18000.0, 18001.0)));
+    EXPECT_FALSE(cache.update(*id, makeTick("US100", 18000.0, 18001.0, 2)));
+    EXPECT_FALSE(cache.update(1, makeTick("GOLD", 2300.0, 2300.5)));
+
+    QuoteLevel quote;
+    ASSERT_TRUE(cache.quote(*id, quote));
+    EXPECT_DOUBLE_EQ(quote.bid, 18000.0);
+    EXPECT_DOUBLE_EQ(quote.ask, 18001.0);
+    EXPECT_EQ(cache.symbolCount(), 1u);
+}
+
+TEST(QuoteCacheTest, depth_levels)
+{
+    QuoteCache cache(16, 3);
+    EXPECT_TRUE(cache.update(makeTick("US100", 100.0, 101.0, 0)));
+    EXPECT_TRUE(cache.update(makeTick("US100", 99.0, 102.0, 1)));
+    EXPECT_TRUE(cache.update(makeTick("US100", 98.0, 103.0, 2)));
+    EXPECT_FALSE(cache.update(makeTick("US100", 97.0, 104.0, 3)));
+    EXPECT_FALSE(cache.update(makeTick("US100", 97.0, 104.0, -1)));
+
+    std::array<QuoteLevel, 5> levels;
+    ASSERT_EQ(cache.book(*cache.find("US100"), levels), 3u);
+    EXPECT_DOUBLE_EQ(levels[0].bid, 100.0);
+    EXPECT_DOUBLE_EQ(levels[1].bid, 99.0);
+    EXPECT_DOUBLE_EQ(levels[2].ask, 103.0);
+
+    std::array<QuoteLevel, 2> top;
+    EXPECT_EQ(cache.book(*cache.find("US100"), top), 2u);
+}
+
+TEST(QuoteCacheTest, without_seqlock)
+{
+    QuoteCache cache(16, 1, false);
+    EXPECT_TRUE(cache.update(makeTick("EURUSD", 1.0, 1.1)));
+
+    QuoteLevel quote;
+    ASSERT_TRUE(cache.quote(0, quote));
+    EXPECT_DOUBLE_EQ(quote.ask, 1.1);
+}
+
+TEST(QuoteCacheTest, consistent_snapshots)
+{
+    QuoteCache cache(4, 2);
+    const SymbolId id = *cache.intern("EURUSD");
+    std::atomic<bool> done{false};
+
+    std::thread writer([&cache, &done]() {
+        for (int i = 1; i <= 100'000; ++i)
+        {
+            cache.update(makeTick("EURUSD", i, i, 0));
+            cache.update(makeTick("EURUSD", i, i, 1));
+        }
+        done = true;
+    });
+
+    std::array<QuoteLevel, 2> levels;
+    bool consistent = true;
+    while (!done && consistent)
+    {
+        if (cache.book(id, levels) == 2)
+        {
+            // Level 1 is written after level 0 from the same tick number
+            consistent = levels[0].bid == levels[0].ask && levels[1].bid == levels[1].ask &&
+                         levels[0].bid >= levels[1].bid && levels[0].bid - levels[1].bid <= 1.0;
+        }
+        std::this_thread::yield();
+    }
+    writer.join();
+    EXPECT_TRUE(consistent);
+}
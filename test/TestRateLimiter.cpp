@@ -0,0 +1,115 @@
+#include "xapi/RateLimiter.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace xapi;
+using namespace std::chrono_literals;
+
+TEST(RateLimiterTest, burst_is_sent_without_delay)
+{
+    internals::RateLimiter rateLimiter(5, 5.0);
+    const auto now = internals::RateLimiter::Clock::now();
+
+    for (int i = 0; i < 5; ++i)
+    {
+        EXPECT_EQ(rateLimiter.reserve(now), internals::RateLimiter::Clock::duration::zero());
+    }
+    EXPECT_GT(rateLimiter.reserve(now), internals::RateLimiter::Clock::duration::zero());
+}
+
+TEST(RateLimiterTest, requests_over_burst_are_spaced_by_refill_rate)
+{
+    internals::RateLimiter rateLimiter(1, 5.0);
+    const auto now = internals::RateLimiter::Clock::now();
+
+    EXPECT_EQ(rateLimiter.reserve(now), internals::RateLimiter::Clock::duration::zero());
+    EXPECT_EQ(std::chrono::round<std::chrono::milliseconds>(rateLimiter.reserve(now)), 200ms);
+    EXPECT_EQ(std::chrono::round<std::chrono::milliseconds>(rateLimiter.reserve(now)), 400ms);
+}
+
+TEST(RateLimiterTest, sixth_short_gap_in_a_row_is_delayed)
+{
+    internals::RateLimiter rateLimiter(5, 5.0);
+    const auto start = internals::RateLimiter::Clock::now();
+
+    // Requests every 150 ms keep the bucket from running out, only the short gaps limit them
+    auto lastSend = start;
+    std::size_t shortGaps = 0;
+    for (int i = 0; i < 40; ++i)
+    {
+        const auto now = start + i * 150ms;
+        const auto sendAt = now + rateLimiter.reserve(now);
+        if (i > 0 && sendAt - lastSend < 200ms)
+        {
+            ++shortGaps;
+            EXPECT_LE(shortGaps, 5u);
+        }
+        else
+        {
+            shortGaps = 0;
+        }
+        lastSend = sendAt;
+    }
+}
+
+TEST(RateLimiterTest, bucket_is_refilled_up_to_burst_size)
+{
+    internals::RateLimiter rateLimiter(2, 10.0);
+    const auto now = internals::RateLimiter::Clock::now();
+
+    rateLimiter.reserve(now);
+    rateLimiter.reserve(now);
+    EXPECT_NEAR(rateLimiter.availableTokens(now), 0.0, 1e-9);
+    EXPECT_NEAR(rateLimiter.availableTokens(now + 100ms), 1.0, 1e-9);
+    EXPECT_NEAR(rateLimiter.availableTokens(now + 10s), 2.0, 1e-9);
+}
+
+TEST(RateLimiterTest, configure_limits_available_tokens)
+{
+    internals::RateLimiter rateLimiter(10, 10.0);
+    rateLimiter.configure(3, 1.0);
+    EXPECT_LE(rateLimiter.availableTokens(internals::RateLimiter::Clock::now()), 3.0);
+}
+
+TEST(RateLimiterTest, acquire_waits_for_token)
+{
+    boost::asio::io_context context;
+    internals::RateLimiter rateLimiter(1, 20.0);
+
+    const auto start = internals::RateLimiter::Clock::now();
+    boost::asio::co_spawn(
+        context,
+        [&]() -> boost::asio::awaitable<void> {
+            co_await rateLimiter.acquire();
+            co_await rateLimiter.acquire();
+        },
+        boost::asio::detached);
+    context.run();
+
+    EXPECT_GE(internals::RateLimiter::Clock::now() - start, 45ms);
+}
+
+TEST(RateLimiterTest, reserve_from_several_threads)
+{
+    internals::RateLimiter rateLimiter(1000, 1.0);
+    const auto now = internals::RateLimiter::Clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&rateLimiter, now]() {
+            for (int j = 0; j < 250; ++j)
+            {
+                rateLimiter.reserve(now);
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    // Every reservation took exactly one token
+    EXPECT_NEAR(rateLimiter.availableTokens(now), 0.0, 1e-9);
+}
@@ -0,0 +1,137 @@
+#include "xapi/Exceptions.hpp"
+#include "xapi/ReplayConnection.hpp"
+#include "xapi/XStationClientStream.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace xapi;
+
+class ReplayConnectionTest : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_journal = std::filesystem::temp_directory_path() / "xapi_replay_test.journal";
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove(m_journal);
+    }
+
+    // Records the frames 10 ms apart.
+    void record(const std::vector<std::string> &frames)
+    {
+        SessionRecorder recorder(m_journal);
+        auto receivedAt = SessionRecorder::Clock::now();
+        for (const auto &frame : frames)
+        {
+            recorder.record(frame, receivedAt);
+            receivedAt += std::chrono::milliseconds(10);
+        }
+        EXPECT_EQ(recorder.frames(), frames.size());
+        EXPECT_TRUE(recorder.good());
+    }
+
+    template <typename Function> void run(Function &&function)
+    {
+        std::exception_ptr eptr;
+        boost::asio::co_spawn(m_context, std::forward<Function>(function), [&eptr](std::exception_ptr e) { eptr = e; });
+        m_context.run();
+        m_context.restart();
+        if (eptr)
+        {
+            std::rethrow_exception(eptr);
+        }
+    }
+
+    boost::asio::io_context m_context;
+    std::filesystem::path m_journal;
+};
+
+TEST_F(ReplayConnectionTest, replays_recorded_frames)
+{
+    const std::vector<std::string> frames{R"({"command":"keepAlive","data":{"timestamp":1}})",
+                                          R"({"status":true,"returnData":{}})", ""};
+    record(frames);
+
+    internals::ReplayConnection connection(m_context, m_journal);
+    std::vector<std::string> replayed;
+    EXPECT_THROW(run([&]() -> boost::asio::awaitable<void> {
+                     co_await connection.connect(boost::url("wss://ws.xtb.com/demo"));
+                     co_await connection.makeRequest(internals::Command("getVersion"));
+                     while (true)
+                     {
+                         replayed.emplace_back(co_await connection.waitFrame());
+                     }
+                 }),
+                 exception::ConnectionClosed);
+
+    EXPECT_EQ(replayed, frames);
+    EXPECT_EQ(connection.replayed(), 3u);
+    EXPECT_EQ(connection.requests(), 1u);
+
+    // connect() starts again from the first frame
+    boost::json::object response;
+    EXPECT_NO_THROW(run([&]() -> boost::asio::awaitable<void> {
+        co_await connection.connect(boost::url("wss://ws.xtb.com/demo"));
+        response = co_await connection.waitResponse();
+    }));
+    EXPECT_EQ(response.at("command"), "keepAlive");
+}
+
+TEST_F(ReplayConnectionTest, replays_at_recorded_pace)
+{
+    record({R"({"command":"keepAlive","data":{}})", R"({"command":"keepAlive","data":{}})",
+            R"({"command":"keepAlive","data":{}})"});
+
+    internals::ReplayConnection connection(m_context, m_journal, internals::ReplayPace::Recorded);
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_NO_THROW(run([&]() -> boost::asio::awaitable<void> {
+        co_await connection.connect(boost::url("wss://ws.xtb.com/demo"));
+        for (int i = 0; i < 3; ++i)
+        {
+            co_await connection.waitFrame();
+        }
+    }));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+}
+
+TEST_F(ReplayConnectionTest, stream_reads_typed_records)
+{
+    record({R"({"command":"tickPrices","data":{"symbol":"EURUSD","bid":1.1,"ask":1.2,"level":0}})",
+            R"({"command":"keepAlive","data":{"timestamp":1}})",
+            R"({"command":"tickPrices","data":{"symbol":"US100","bid":15000.5,"ask":15001.0,"level":0}})"});
+
+    XStationClientStream stream(std::make_unique<internals::ReplayConnection>(m_context, m_journal));
+    std::vector<TickRecord> ticks;
+    EXPECT_THROW(run([&]() -> boost::asio::awaitable<void> {
+                     co_await stream.open();
+                     while (true)
+                     {
+                         const StreamRecord record = co_await stream.listenTyped();
+                         if (std::holds_alternative<TickRecord>(record))
+                         {
+                             ticks.push_back(std::get<TickRecord>(record));
+                         }
+                     }
+                 }),
+                 exception::ConnectionClosed);
+
+    ASSERT_EQ(ticks.size(), 2u);
+    EXPECT_EQ(ticks[0].symbol, "EURUSD");
+    EXPECT_DOUBLE_EQ(ticks[1].bid, 15000.5);
+}
+
+TEST_F(ReplayConnectionTest, rejects_other_files)
+{
+    {
+        std::ofstream file(m_journal, std::ios::binary);
+        file << "not a journal at all";
+    }
+    EXPECT_THROW(internals::ReplayConnection(m_context, m_journal), std::runtime_error);
+    EXPECT_THROW(internals::ReplayConnection(m_context, m_journal.string() + ".missing"), std::system_error);
+}
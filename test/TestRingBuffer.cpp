@@ -0,0 +1,189 @@
+#include "xapi/RingBuffer.hpp"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace xapi;
+
+TEST(SpscRingTest, capacity_rounded_to_power_of_two)
+{
+    SpscRing<int> ring(5);
+    EXPECT_EQ(ring.capacity(), 8u);
+    EXPECT_TRUE(ring.empty());
+
+    EXPECT_THROW(SpscRing<int>(0), std::invalid_argument);
+}
+
+TEST(SpscRingTest, push_pop_in_order)
+{
+    SpscRing<int> ring(4);
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(ring.tryPush(i));
+    }
+    EXPECT_FALSE(ring.tryPush(4));
+    EXPECT_EQ(ring.size(), 4u);
+
+    int value = -1;
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(ring.tryPop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(ring.tryPop(value));
+    EXPECT_EQ(value, 3);
+}
+
+TEST(SpscRingTest, wraps_around)
+{
+    SpscRing<int> ring(2);
+    int value = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(ring.tryPush(i));
+        ASSERT_TRUE(ring.tryPop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, two_threads)
+{
+    constexpr std::uint64_t count = 200'000;
+    SpscRing<std::uint64_t> ring(1024);
+
+    std::thread producer([&ring]() {
+        for (std::uint64_t i = 0; i < count;)
+        {
+            if (ring.tryPush(i))
+            {
+                ++i;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // Keep draining after a mismatch, the producer would block on a full ring otherwise
+    std::uint64_t expected = 0;
+    std::uint64_t value = 0;
+    std::uint64_t mismatches = 0;
+    while (expected < count)
+    {
+        if (ring.tryPop(value))
+        {
+            if (value != expected)
+            {
+                ++mismatches;
+            }
+            ++expected;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_EQ(mismatches, 0u);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(BroadcastRingTest, every_consumer_reads_every_element)
+{
+    BroadcastRing<int> ring(4, 2);
+    EXPECT_EQ(ring.consumers(), 2u);
+    EXPECT_TRUE(ring.tryPush(1));
+    EXPECT_TRUE(ring.tryPush(2));
+
+    int value = 0;
+    for (std::size_t consumer = 0; consumer < 2; ++consumer)
+    {
+        EXPECT_EQ(ring.pending(consumer), 2u);
+        ASSERT_TRUE(ring.tryPop(consumer, value));
+        EXPECT_EQ(value, 1);
+        ASSERT_TRUE(ring.tryPop(consumer, value));
+        EXPECT_EQ(value, 2);
+        EXPECT_FALSE(ring.tryPop(consumer, value));
+    }
+
+    EXPECT_THROW(BroadcastRing<int>(4, 0), std::invalid_argument);
+}
+
+TEST(BroadcastRingTest, slowest_consumer_blocks_producer)
+{
+    BroadcastRing<int> ring(2, 2);
+    EXPECT_TRUE(ring.tryPush(1));
+    EXPECT_TRUE(ring.tryPush(2));
+
+    int value = 0;
+    ASSERT_TRUE(ring.tryPop(0, value));
+    ASSERT_TRUE(ring.tryPop(0, value));
+
+    // Consumer 1 has not read anything yet
+    EXPECT_FALSE(ring.tryPush(3));
+
+    ASSERT_TRUE(ring.tryPop(1, value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(ring.tryPush(3));
+    EXPECT_FALSE(ring.tryPush(4));
+}
+
+TEST(BroadcastRingTest, consumer_threads)
+{
+    constexpr std::uint64_t count = 100'000;
+    constexpr std::size_t consumers = 3;
+    BroadcastRing<std::uint64_t> ring(256, consumers);
+
+    std::vector<std::uint64_t> sums(consumers, 0);
+    std::vector<std::uint64_t> mismatches(consumers, 0);
+    std::vector<std::thread> threads;
+    for (std::size_t consumer = 0; consumer < consumers; ++consumer)
+    {
+        threads.emplace_back([&ring, &sums, &mismatches, consumer]() {
+            // A consumer that stopped early would block the producer, so a mismatch is only counted.
+            std::uint64_t expected = 0;
+            std::uint64_t value = 0;
+            while (expected < count)
+            {
+                if (ring.tryPop(consumer, value))
+                {
+                    if (value != expected)
+                    {
+                        ++mismatches[consumer];
+                    }
+                    sums[consumer] += value;
+                    ++expected;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (std::uint64_t i = 0; i < count;)
+    {
+        if (ring.tryPush(i))
+        {
+            ++i;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    for (std::size_t consumer = 0; consumer < consumers; ++consumer)
+    {
+        EXPECT_EQ(mismatches[consumer], 0u) << "consumer " << consumer;
+        EXPECT_EQ(sums[consumer], count * (count - 1) / 2) << "consumer " << consumer;
+    }
+}
@@ -0,0 +1,74 @@
+#include "xapi/StreamDispatcher.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace xapi;
+
+class StreamDispatcherTest : public testing::Test
+{
+  protected:
+    boost::asio::io_context m_context;
+    XStationClientStream m_stream{m_context, "demo", "testStreamSessionId"};
+    StreamDispatcher m_dispatcher{m_stream};
+};
+
+TEST(StreamDispatcherScanTest, scanCommand)
+{
+    EXPECT_EQ(StreamDispatcher::scanCommand(R"({"command":"candle","data":{}})"), "candle");
+    EXPECT_EQ(StreamDispatcher::scanCommand(R"({"data":{}, "command" : "keepAlive"})"), "keepAlive");
+    EXPECT_EQ(StreamDispatcher::scanCommand(R"({"status":true})"), "");
+    EXPECT_EQ(StreamDispatcher::scanCommand(R"({"command":1})"), "");
+    EXPECT_EQ(StreamDispatcher::scanCommand(R"({"command":"trunc)"), "");
+}
+
+TEST_F(StreamDispatcherTest, dispatch_typed_handler)
+{
+    int candles = 0;
+    m_dispatcher.on<CandleRecord>([&candles](const CandleRecord &candle) {
+        EXPECT_EQ(candle.symbol, "US100");
+        EXPECT_DOUBLE_EQ(candle.close, 15000.5);
+        ++candles;
+    });
+
+    EXPECT_TRUE(m_dispatcher.dispatch(R"({"command":"candle","data":{"symbol":"US100","close":15000.5}})"));
+    EXPECT_EQ(candles, 1);
+}
+
+TEST_F(StreamDispatcherTest, dispatch_json_handler)
+{
+    std::string command;
+    m_dispatcher.on("news", [&command](const boost::json::object &message) {
+        command = message.at("command").as_string().c_str();
+    });
+
+    EXPECT_TRUE(m_dispatcher.dispatch(R"({"command":"news","data":{"title":"t"}})"));
+    EXPECT_EQ(command, "news");
+}
+
+TEST_F(StreamDispatcherTest, dispatch_skips_messages_without_handler)
+{
+    int ticks = 0;
+    m_dispatcher.on<TickRecord>([&ticks](const TickRecord &) { ++ticks; });
+
+    // Invalid JSON is not parsed when nobody handles the command
+    EXPECT_FALSE(m_dispatcher.dispatch(R"({"command":"keepAlive","data":{)"));
+    EXPECT_FALSE(m_dispatcher.dispatch(R"({"command":"candle","data":{}})"));
+    EXPECT_EQ(m_dispatcher.skippedMessages(), 2u);
+    EXPECT_EQ(ticks, 0);
+}
+
+TEST_F(StreamDispatcherTest, remove_handler)
+{
+    int keepAlives = 0;
+    m_dispatcher.on<KeepAliveRecord>([&keepAlives](const KeepAliveRecord &) { ++keepAlives; });
+    m_dispatcher.remove("keepAlive");
+
+    EXPECT_FALSE(m_dispatcher.dispatch(R"({"command":"keepAlive","data":{"timestamp":1}})"));
+    EXPECT_EQ(keepAlives, 0);
+}
+
+TEST_F(StreamDispatcherTest, dispatch_invalid_json)
+{
+    m_dispatcher.on<CandleRecord>([](const CandleRecord &) {});
+    EXPECT_THROW(m_dispatcher.dispatch(R"({"command":"candle","data":{)"), boost::system::system_error);
+}
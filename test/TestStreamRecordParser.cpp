@@ -0,0 +1,137 @@
+#include "xapi/StreamRecordParser.hpp"
+#include <boost/system/system_error.hpp>
+#include <gtest/gtest.h>
+
+using namespace xapi;
+
+TEST(StreamRecordParserTest, parse_candle)
+{
+    internals::StreamRecordParser parser;
+    StreamRecord record;
+
+    const std::string_view frame =
+        R"({"command":"candle","data":{"close":4.1,"ctm":1378369375000,"ctmString":"Sep 05, 2013 10:22:55 AM",)"
+        R"("high":4.2,"low":3.9,"open":4.0,"quoteId":2,"symbol":"EURUSD","vol":12.0}})";
+    ASSERT_TRUE(parser.parse(frame, record));
+    ASSERT_TRUE(std::holds_alternative<CandleRecord>(record));
+
+    const auto &candle = std::get<CandleRecord>(record);
+    EXPECT_DOUBLE_EQ(candle.close, 4.1);
+    EXPECT_EQ(candle.ctm, 1378369375000);
+    EXPECT_DOUBLE_EQ(candle.high, 4.2);
+    EXPECT_DOUBLE_EQ(candle.low, 3.9);
+    EXPECT_DOUBLE_EQ(candle.open, 4.0);
+    EXPECT_EQ(candle.quoteId, 2);
+    EXPECT_EQ(candle.symbol, "EURUSD");
+    EXPECT_DOUBLE_EQ(candle.vol, 12.0);
+}
+
+TEST(StreamRecordParserTest, parse_balance_with_integer_values)
+{
+    internals::StreamRecordParser parser;
+    StreamRecord record;
+
+    const std::string_view frame =
+        R"({"command":"balance","data":{"balance":995800269,"credit":1000.0,"equity":995985397.56,)"
+        R"("margin":572634.43,"marginFree":995227635.0,"marginLevel":173930.41}})";
+    ASSERT_TRUE(parser.parse(frame, record));
+    ASSERT_TRUE(std::holds_alternative<BalanceRecord>(record));
+
+    const auto &balance = std::get<BalanceRecord>(record);
+    EXPECT_DOUBLE_EQ(balance.balance, 995800269.0);
+    EXPECT_DOUBLE_EQ(balance.credit, 1000.0);
+    EXPECT_DOUBLE_EQ(balance.marginLevel, 173930.41);
+}
+
+TEST(StreamRecordParserTest, parse_trade_with_nulls)
+{
+    internals::StreamRecordParser parser;
+    StreamRecord record;
+
+    const std::string_view frame =
+        R"({"command":"trade","data":{"close_price":1.3256,"close_time":null,"closed":false,"cmd":0,)"
+        R"("comment":"Web Trader","commission":0.0,"customComment":"Some text","digits":4,"expiration":null,)"
+        R"("margin_rate":3.9149000,"offset":0,"open_price":1.4,"open_time":1272380927000,"order":7497776,)"
+        R"("order2":1234567,"position":1234567,"profit":null,"sl":0.0,"state":"Modified","storage":-4.46,)"
+        R"("symbol":"EURUSD","tp":0.0,"type":0,"volume":0.10}})";
+    ASSERT_TRUE(parser.parse(frame, record));
+    ASSERT_TRUE(std::holds_alternative<TradeRecord>(record));
+
+    const auto &trade = std::get<TradeRecord>(record);
+    EXPECT_EQ(trade.closeTime, 0);
+    EXPECT_FALSE(trade.closed);
+    EXPECT_EQ(trade.comment, "Web Trader");
+    EXPECT_EQ(trade.customComment, "Some text");
+    EXPECT_EQ(trade.digits, 4);
+    EXPECT_EQ(trade.order, 7497776);
+    EXPECT_DOUBLE_EQ(trade.profit, 0.0);
+    EXPECT_EQ(trade.state, "Modified");
+    EXPECT_DOUBLE_EQ(trade.storage, -4.46);
+    EXPECT_EQ(trade.symbol, "EURUSD");
+    EXPECT_DOUBLE_EQ(trade.volume, 0.10);
+}
+
+TEST(StreamRecordParserTest, parse_command_after_data)
+{
+    internals::StreamRecordParser parser;
+    StreamRecord record;
+
+    const std::string_view frame = R"({"data":{"timestamp":1362944112000},"command":"keepAlive"})";
+    ASSERT_TRUE(parser.parse(frame, record));
+    ASSERT_TRUE(std::holds_alternative<KeepAliveRecord>(record));
+    EXPECT_EQ(std::get<KeepAliveRecord>(record).timestamp, 1362944112000);
+}
+
+TEST(StreamRecordParserTest, parse_reuses_parser)
+{
+    internals::StreamRecordParser parser;
+    StreamRecord record;
+
+    ASSERT_TRUE(parser.parse(R"({"command":"profit","data":{"order":1,"order2":2,"position":3,"profit":7.5}})", record));
+    EXPECT_DOUBLE_EQ(std::get<ProfitRecord>(record).profit, 7.5);
+
+    ASSERT_TRUE(parser.parse(R"({"command":"tradeStatus","data":{"customComment":"c","message":null,"order":43,)"
+                             R"("price":1.392,"requestStatus":3}})",
+                             record));
+    const auto &status = std::get<TradeStatusRecord>(record);
+    EXPECT_EQ(status.order, 43);
+    EXPECT_TRUE(status.message.empty());
+    EXPECT_EQ(status.requestStatus, 3);
+}
+
+TEST(StreamRecordParserTest, parse_same_record_keeps_string_capacity)
+{
+    internals::StreamRecordParser parser;
+    StreamRecord record;
+
+    ASSERT_TRUE(parser.parse(R"({"command":"news","data":{"body":"<html>A body longer than the string buffer</html>",)"
+                             R"("key":"1f6da766abd29927aa854823f0105c23","time":1262944112000,)"
+                             R"("title":"Breaking trend"}})",
+                             record));
+    const std::size_t bodyCapacity = std::get<NewsRecord>(record).body.capacity();
+
+    ASSERT_TRUE(parser.parse(R"({"command":"news","data":{"key":"k2","time":1262944112001,"title":"Short"}})", record));
+    const auto &news = std::get<NewsRecord>(record);
+    EXPECT_TRUE(news.body.empty());
+    EXPECT_EQ(news.body.capacity(), bodyCapacity);
+    EXPECT_EQ(news.key, "k2");
+    EXPECT_EQ(news.time, 1262944112001);
+    EXPECT_EQ(news.title, "Short");
+}
+
+TEST(StreamRecordParserTest, parse_unknown_command)
+{
+    internals::StreamRecordParser parser;
+    StreamRecord record;
+
+    EXPECT_FALSE(parser.parse(R"({"status":true})", record));
+    EXPECT_FALSE(parser.parse(R"({"command":"unknown","data":{"a":1}})", record));
+}
+
+TEST(StreamRecordParserTest, parse_invalid_json)
+{
+    internals::StreamRecordParser parser;
+    StreamRecord record;
+
+    EXPECT_THROW(parser.parse(R"({"command":"candle","data":{)", record), boost::system::system_error);
+}
@@ -0,0 +1,48 @@
+#include "xapi/SubscriptionRegistry.hpp"
+#include <gtest/gtest.h>
+
+using namespace xapi;
+
+TEST(SubscriptionRegistryTest, subscriptions_are_kept_in_order)
+{
+    internals::SubscriptionRegistry registry;
+    registry.add(internals::Subscription("getBalance"));
+    registry.add(internals::Subscription("getCandles", "US100"));
+    registry.add(internals::Subscription("getTickPrices", "EURUSD", 100, 1));
+
+    ASSERT_EQ(registry.size(), 3);
+    EXPECT_EQ(registry.subscriptions()[0].command, "getBalance");
+    EXPECT_EQ(registry.subscriptions()[1].symbol, "US100");
+    EXPECT_EQ(registry.subscriptions()[2].minArrivalTime, 100);
+    EXPECT_EQ(registry.subscriptions()[2].maxLevel, 1);
+}
+
+TEST(SubscriptionRegistryTest, same_subscription_is_replaced)
+{
+    internals::SubscriptionRegistry registry;
+    registry.add(internals::Subscription("getTickPrices", "EURUSD", 0, 2));
+    registry.add(internals::Subscription("getTickPrices", "EURUSD", 500, 0));
+
+    ASSERT_EQ(registry.size(), 1);
+    EXPECT_EQ(registry.subscriptions()[0].minArrivalTime, 500);
+    EXPECT_EQ(registry.subscriptions()[0].maxLevel, 0);
+}
+
+TEST(SubscriptionRegistryTest, remove_matches_command_and_symbol)
+{
+    internals::SubscriptionRegistry registry;
+    registry.add(internals::Subscription("getCandles", "US100"));
+    registry.add(internals::Subscription("getCandles", "DE30"));
+    registry.add(internals::Subscription("getNews"));
+
+    registry.remove("getCandles", "US100");
+    ASSERT_EQ(registry.size(), 2);
+    EXPECT_EQ(registry.subscriptions()[0].symbol, "DE30");
+
+    registry.remove("getNews");
+    registry.remove("getTrades");
+    ASSERT_EQ(registry.size(), 1);
+
+    registry.clear();
+    EXPECT_TRUE(registry.empty());
+}
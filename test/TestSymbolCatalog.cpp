@@ -0,0 +1,158 @@
+#include "xapi/SymbolCatalog.hpp"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+using namespace xapi;
+
+class SymbolCatalogTest : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_file = std::filesystem::temp_directory_path() /
+                 ("xapi_catalog_" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove(m_file);
+    }
+
+    static boost::json::array symbols()
+    {
+        boost::json::array result;
+        result.push_back(boost::json::object{{"symbol", "EURUSD"},
+                                             {"categoryName", "FX"},
+                                             {"currency", "EUR"},
+                                             {"description", "Euro to American Dollar"},
+                                             {"contractSize", 100000},
+                                             {"lotMin", 0.01},
+                                             {"precision", 5},
+                                             {"expiration", nullptr},
+                                             {"trailingEnabled", true}});
+        result.push_back(boost::json::object{{"symbol", "US100"}, {"categoryName", "IND"}, {"leverage", 5}});
+        return result;
+    }
+
+    std::filesystem::path m_file;
+};
+
+TEST_F(SymbolCatalogTest, build_and_find)
+{
+    const SymbolCatalog catalog = SymbolCatalog::build(symbols(), "2.5.0");
+    EXPECT_EQ(catalog.size(), 2u);
+    EXPECT_EQ(catalog.serverVersion(), "2.5.0");
+    EXPECT_FALSE(catalog.isMapped());
+
+    const SymbolInfo *eurusd = catalog.find("EURUSD");
+    ASSERT_NE(eurusd, nullptr);
+    EXPECT_EQ(eurusd->categoryName, "FX");
+    EXPECT_EQ(eurusd->description, "Euro to American Dollar");
+    EXPECT_EQ(eurusd->contractSize, 100000);
+    EXPECT_DOUBLE_EQ(eurusd->lotMin, 0.01);
+    EXPECT_EQ(eurusd->precision, 5);
+    EXPECT_EQ(eurusd->expiration, 0);
+    EXPECT_TRUE(eurusd->trailingEnabled);
+
+    ASSERT_NE(catalog.find("US100"), nullptr);
+    EXPECT_DOUBLE_EQ(catalog.find("US100")->leverage, 5.0);
+    EXPECT_EQ(catalog.find("GOLD"), nullptr);
+}
+
+TEST_F(SymbolCatalogTest, save_and_load)
+{
+    const auto validatedAt = SymbolCatalog::Clock::time_point(std::chrono::seconds(1700000000));
+    SymbolCatalog::build(symbols(), "2.5.0", validatedAt).save(m_file);
+
+    const SymbolCatalog catalog = SymbolCatalog::load(m_file);
+    EXPECT_TRUE(catalog.isMapped());
+    EXPECT_EQ(catalog.size(), 2u);
+    EXPECT_EQ(catalog.validatedAt(), validatedAt);
+    ASSERT_NE(catalog.find("EURUSD"), nullptr);
+    EXPECT_EQ(catalog.find("EURUSD")->currency, "EUR");
+    EXPECT_EQ(catalog.symbols()[1].symbol, "US100");
+}
+
+TEST_F(SymbolCatalogTest, touch)
+{
+    SymbolCatalog::build(symbols(), "2.5.0", SymbolCatalog::Clock::time_point()).save(m_file);
+
+    const auto validatedAt = SymbolCatalog::Clock::time_point(std::chrono::seconds(1800000000));
+    SymbolCatalog::touch(m_file, validatedAt);
+    EXPECT_EQ(SymbolCatalog::load(m_file).validatedAt(), validatedAt);
+}
+
+TEST_F(SymbolCatalogTest, load_invalid_file)
+{
+    EXPECT_THROW(SymbolCatalog::load(m_file), std::system_error);
+
+    std::ofstream(m_file) << "not a catalog, but long enough to hold a header of sixty four bytes";
+    EXPECT_THROW(SymbolCatalog::load(m_file), std::runtime_error);
+}
+
+TEST_F(SymbolCatalogTest, load_corrupt_file)
+{
+    // Offsets of count and bucketCount in the header, the records follow the 64 byte header and
+    // the buckets are at the end of the file
+    constexpr std::streamoff countOffset = 16;
+    constexpr std::streamoff bucketCountOffset = 24;
+    constexpr std::streamoff recordsOffset = 64;
+    const auto patch = [this](std::streamoff offset, const auto &value) {
+        std::fstream file(m_file, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+    const auto bucketCount = [this]() {
+        std::uint64_t count = 0;
+        std::ifstream file(m_file, std::ios::binary);
+        file.seekg(bucketCountOffset);
+        file.read(reinterpret_cast<char *>(&count), sizeof(count));
+        return count;
+    };
+    const auto bucketOffset = [this, &bucketCount](std::uint64_t bucket) {
+        return static_cast<std::streamoff>(std::filesystem::file_size(m_file) -
+                                           (bucketCount() - bucket) * sizeof(std::uint32_t));
+    };
+
+    // The size computed from the count overflows
+    SymbolCatalog::build(symbols(), "2.5.0").save(m_file);
+    patch(countOffset, std::uint64_t{1} << 62);
+    patch(bucketCountOffset, std::uint64_t{1} << 63);
+    EXPECT_THROW(SymbolCatalog::load(m_file), std::runtime_error);
+
+    // A bucket points past the two records
+    SymbolCatalog::build(symbols(), "2.5.0").save(m_file);
+    patch(bucketOffset(0), std::uint32_t{3});
+    EXPECT_THROW(SymbolCatalog::load(m_file), std::runtime_error);
+
+    // No empty bucket, find() would probe forever
+    SymbolCatalog::build(symbols(), "2.5.0").save(m_file);
+    const std::uint64_t buckets = bucketCount();
+    for (std::uint64_t bucket = 0; bucket < buckets; ++bucket)
+    {
+        patch(bucketOffset(bucket), std::uint32_t{1});
+    }
+    EXPECT_THROW(SymbolCatalog::load(m_file), std::runtime_error);
+
+    // The size byte of a symbol name, after its 31 characters, is larger than its capacity
+    SymbolCatalog::build(symbols(), "2.5.0").save(m_file);
+    patch(recordsOffset + static_cast<std::streamoff>(offsetof(SymbolInfo, symbol) + 31), std::uint8_t{200});
+    EXPECT_THROW(SymbolCatalog::load(m_file), std::runtime_error);
+}
+
+TEST_F(SymbolCatalogTest, build_invalid_records)
+{
+    EXPECT_THROW(SymbolCatalog::build(boost::json::array{1}, "2.5.0"), std::invalid_argument);
+    EXPECT_THROW(SymbolCatalog::build(boost::json::array{boost::json::object{{"lotMin", 1}}}, "2.5.0"),
+                 std::invalid_argument);
+}
+
+TEST_F(SymbolCatalogTest, empty_catalog)
+{
+    const SymbolCatalog catalog;
+    EXPECT_EQ(catalog.size(), 0u);
+    EXPECT_EQ(catalog.find("EURUSD"), nullptr);
+}
@@ -0,0 +1,88 @@
+#include "xapi/TickConflator.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace xapi;
+
+namespace
+{
+
+TickRecord makeTick(std::string_view symbol, double bid, int level = 0)
+{
+    TickRecord tick;
+    tick.symbol = SymbolName(symbol);
+    tick.bid = bid;
+    tick.level = level;
+    return tick;
+}
+
+} // namespace
+
+TEST(TickConflatorTest, keeps_latest_tick_per_symbol)
+{
+    TickConflator conflator;
+    EXPECT_TRUE(conflator.update(makeTick("EURUSD", 1.0)));
+    EXPECT_TRUE(conflator.update(makeTick("US100", 15000.0)));
+    EXPECT_TRUE(conflator.update(makeTick("EURUSD", 1.1)));
+
+    EXPECT_EQ(conflator.updates(), 3u);
+    EXPECT_EQ(conflator.conflated(), 1u);
+    EXPECT_EQ(conflator.dirtyCount(), 2u);
+
+    std::vector<TickRecord> ticks;
+    EXPECT_EQ(conflator.poll(ticks), 2u);
+    ASSERT_EQ(ticks.size(), 2u);
+    EXPECT_EQ(ticks[0].symbol, "EURUSD");
+    EXPECT_DOUBLE_EQ(ticks[0].bid, 1.1);
+    EXPECT_EQ(ticks[1].symbol, "US100");
+}
+
+TEST(TickConflatorTest, poll_returns_only_changes)
+{
+    TickConflator conflator;
+    conflator.update(makeTick("EURUSD", 1.0));
+    conflator.update(makeTick("US100", 15000.0));
+
+    std::vector<TickRecord> ticks;
+    conflator.poll(ticks);
+    ticks.clear();
+
+    EXPECT_EQ(conflator.poll(ticks), 0u);
+
+    conflator.update(makeTick("US100", 15001.0));
+    EXPECT_EQ(conflator.poll(ticks), 1u);
+    EXPECT_EQ(ticks[0].symbol, "US100");
+
+    // A tick after a poll is not conflated
+    EXPECT_EQ(conflator.conflated(), 0u);
+}
+
+TEST(TickConflatorTest, levels_are_separate)
+{
+    TickConflator conflator;
+    conflator.update(makeTick("EURUSD", 1.0, 0));
+    conflator.update(makeTick("EURUSD", 0.9, 1));
+
+    EXPECT_EQ(conflator.size(), 2u);
+    EXPECT_DOUBLE_EQ(conflator.latest("EURUSD", 1)->bid, 0.9);
+    EXPECT_DOUBLE_EQ(conflator.latest("EURUSD")->bid, 1.0);
+    EXPECT_FALSE(conflator.latest("EURUSD", 2).has_value());
+}
+
+TEST(TickConflatorTest, entry_limit)
+{
+    TickConflator conflator(2);
+    EXPECT_TRUE(conflator.update(makeTick("A", 1.0)));
+    EXPECT_TRUE(conflator.update(makeTick("B", 1.0)));
+    EXPECT_FALSE(conflator.update(makeTick("C", 1.0)));
+
+    // Known symbols are still updated
+    EXPECT_TRUE(conflator.update(makeTick("A", 2.0)));
+    EXPECT_EQ(conflator.rejected(), 1u);
+    EXPECT_EQ(conflator.size(), 2u);
+
+    conflator.clear();
+    EXPECT_EQ(conflator.size(), 0u);
+    EXPECT_EQ(conflator.rejected(), 0u);
+    EXPECT_TRUE(conflator.update(makeTick("C", 1.0)));
+}
@@ -0,0 +1,50 @@
+#include "xapi/TlsContext.hpp"
+#include <gtest/gtest.h>
+
+using namespace xapi;
+
+namespace
+{
+
+SSL *newClientSsl(internals::TlsContext &tlsContext, const char *host)
+{
+    SSL *ssl = SSL_new(tlsContext.context().native_handle());
+    SSL_set_connect_state(ssl);
+    SSL_set_tlsext_host_name(ssl, host);
+    return ssl;
+}
+
+} // namespace
+
+TEST(TlsContextTest, no_session_to_resume_initially)
+{
+    internals::TlsContext tlsContext;
+    SSL *ssl = newClientSsl(tlsContext, "ws.xtb.com");
+
+    EXPECT_EQ(tlsContext.cachedSessions(), 0);
+    EXPECT_FALSE(tlsContext.resumeSession(ssl, "ws.xtb.com"));
+
+    SSL_free(ssl);
+}
+
+TEST(TlsContextTest, new_session_is_cached_per_host)
+{
+    internals::TlsContext tlsContext;
+    auto newSessionCallback = SSL_CTX_sess_get_new_cb(tlsContext.context().native_handle());
+    ASSERT_NE(newSessionCallback, nullptr);
+
+    SSL *first = newClientSsl(tlsContext, "ws.xtb.com");
+    EXPECT_EQ(newSessionCallback(first, SSL_SESSION_new()), 1);
+    EXPECT_EQ(newSessionCallback(first, SSL_SESSION_new()), 1);
+    EXPECT_EQ(tlsContext.cachedSessions(), 1);
+
+    SSL *second = newClientSsl(tlsContext, "ws.xtb.com");
+    EXPECT_TRUE(tlsContext.resumeSession(second, "ws.xtb.com"));
+    EXPECT_FALSE(tlsContext.resumeSession(second, "other.host"));
+
+    tlsContext.clear();
+    EXPECT_EQ(tlsContext.cachedSessions(), 0);
+
+    SSL_free(second);
+    SSL_free(first);
+}
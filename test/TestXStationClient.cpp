@@ -2,6 +2,7 @@
 #include "xapi/Exceptions.hpp"
 #include "xapi/XStationClient.hpp"
 #include <gtest/gtest.h>
+#include <filesystem>
 #include <iostream>
 #include <string>
 
@@ -124,6 +125,13 @@ TEST_F(XStationClientTest, login_invalid_account_type)
     EXPECT_TRUE(client.m_streamSessionId.empty());
 }
 
+TEST_F(XStationClientTest, loginWithStream_invalid_account_type)
+{
+    XStationClient client(getIoContext(), "test", "test", "asdasda");
+    EXPECT_THROW(runAwaitableVoid(client.loginWithStream()), exception::LoginFailed);
+    EXPECT_TRUE(client.m_streamSessionId.empty());
+}
+
 TEST_F(XStationClientTest, login_account_credentials_null)
 {    
     const boost::json::object accountCredentials = {
@@ -1327,6 +1335,118 @@ TEST_F(XStationClientTest, getVersion_exception)
     EXPECT_THROW(result = runAwaitable(client->getVersion()), exception::ConnectionClosed);
 }
 
+TEST_F(XStationClientTest, getSymbolCatalog_fresh_file)
+{
+    const auto file = std::filesystem::temp_directory_path() / "xapi_catalog_fresh";
+    SymbolCatalog::build(boost::json::array{boost::json::object{{"symbol", "EURUSD"}}}, "2.5.0").save(file);
+
+    EXPECT_CALL(getMockedConnection(), makeRequest(testing::_)).Times(0);
+
+    SymbolCatalog catalog;
+    EXPECT_NO_THROW(catalog = runAwaitable(client->getSymbolCatalog(file, std::chrono::hours(1))));
+    EXPECT_TRUE(catalog.isMapped());
+    EXPECT_NE(catalog.find("EURUSD"), nullptr);
+    std::filesystem::remove(file);
+}
+
+TEST_F(XStationClientTest, getSymbolCatalog_download)
+{
+    const auto file = std::filesystem::temp_directory_path() / "xapi_catalog_download";
+    std::filesystem::remove(file);
+
+    std::vector<std::string> commands;
+    EXPECT_CALL(getMockedConnection(), makeRequest(testing::_))
+        .Times(2)
+        .WillRepeatedly([&commands](const boost::json::object &command) -> boost::asio::awaitable<void> {
+            commands.push_back(command.at("command").as_string().c_str());
+            co_return;
+        });
+
+    EXPECT_CALL(getMockedConnection(), waitResponse())
+        .WillOnce([]() -> boost::asio::awaitable<boost::json::object> {
+            co_return boost::json::object{{"status", true}, {"returnData", {{"version", "2.5.0"}}}};
+        })
+        .WillOnce([]() -> boost::asio::awaitable<boost::json::object> {
+            co_return boost::json::object{
+                {"status", true},
+                {"returnData", boost::json::array{boost::json::object{{"symbol", "US100"}, {"leverage", 5}}}}};
+        });
+
+    SymbolCatalog catalog;
+    EXPECT_NO_THROW(catalog = runAwaitable(client->getSymbolCatalog(file)));
+    EXPECT_EQ(commands, (std::vector<std::string>{"getVersion", "getAllSymbols"}));
+    EXPECT_EQ(catalog.serverVersion(), "2.5.0");
+    ASSERT_NE(catalog.find("US100"), nullptr);
+    EXPECT_TRUE(std::filesystem::exists(file));
+    std::filesystem::remove(file);
+}
+
+TEST_F(XStationClientTest, getSymbolCatalog_revalidate_same_version)
+{
+    const auto file = std::filesystem::temp_directory_path() / "xapi_catalog_revalidate";
+    SymbolCatalog::build(boost::json::array{boost::json::object{{"symbol", "EURUSD"}}}, "2.5.0",
+                         SymbolCatalog::Clock::time_point())
+        .save(file);
+
+    EXPECT_CALL(getMockedConnection(), makeRequest(testing::_))
+        .WillOnce([](const boost::json::object &command) -> boost::asio::awaitable<void> {
+            EXPECT_EQ(command.at("command"), "getVersion");
+            co_return;
+        });
+
+    EXPECT_CALL(getMockedConnection(), waitResponse())
+        .WillOnce([]() -> boost::asio::awaitable<boost::json::object> {
+            co_return boost::json::object{{"status", true}, {"returnData", {{"version", "2.5.0"}}}};
+        });
+
+    SymbolCatalog catalog;
+    EXPECT_NO_THROW(catalog = runAwaitable(client->getSymbolCatalog(file)));
+    EXPECT_NE(catalog.find("EURUSD"), nullptr);
+    EXPECT_GT(catalog.validatedAt(), SymbolCatalog::Clock::time_point());
+    std::filesystem::remove(file);
+}
+
+TEST_F(XStationClientTest, getCachedChartRange_requests_missing_range)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "xapi_candles_client";
+    std::filesystem::remove_all(directory);
+    CandleStore store(directory);
+
+    constexpr std::int64_t minute = 60'000;
+    const std::vector<Candle> stored{Candle{0, 1.1, 1.1, 1.1, 1.1, 1.0}, Candle{minute, 1.2, 1.2, 1.2, 1.2, 1.0}};
+    store.merge("EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 10 * minute}, stored, 5);
+
+    EXPECT_CALL(getMockedConnection(), makeRequest(testing::_))
+        .WillOnce([](const boost::json::object &command) -> boost::asio::awaitable<void> {
+            const auto &info = command.at("arguments").at("info");
+            EXPECT_EQ(info.at("start"), 10 * minute);
+            EXPECT_EQ(info.at("end"), 20 * minute);
+            co_return;
+        });
+
+    EXPECT_CALL(getMockedConnection(), waitResponse())
+        .WillOnce([]() -> boost::asio::awaitable<boost::json::object> {
+            co_return boost::json::object{
+                {"status", true},
+                {"returnData",
+                 {{"digits", 5},
+                  {"rateInfos", boost::json::array{boost::json::object{
+                                    {"ctm", 10 * minute}, {"open", 130000.0}, {"high", 20.0}, {"low", -10.0},
+                                    {"close", 5.0}, {"vol", 3.0}}}}}}};
+        });
+
+    std::vector<Candle> candles;
+    EXPECT_NO_THROW(candles = runAwaitable(
+                        client->getCachedChartRange(store, "EURUSD", 0, 20 * minute, PeriodCode::PERIOD_M1)));
+    ASSERT_EQ(candles.size(), 3u);
+    EXPECT_DOUBLE_EQ(candles[2].open, 1.3);
+    EXPECT_DOUBLE_EQ(candles[2].high, 1.3002);
+    EXPECT_DOUBLE_EQ(candles[2].low, 1.2999);
+    EXPECT_DOUBLE_EQ(candles[2].close, 1.30005);
+    EXPECT_TRUE(store.missing("EURUSD", PeriodCode::PERIOD_M1, TimeRange{0, 20 * minute}).empty());
+    std::filesystem::remove_all(directory);
+}
+
 TEST_F(XStationClientTest, tradeTransactionStatus_ok)
 {
     const int order = 12345;
@@ -28,6 +28,16 @@ class XStationClientStreamTest : public ::testing::Test
         return *dynamic_cast<MockConnection *>(stream->m_connection.get());
     }
 
+    void setConnectionFactory(std::function<std::unique_ptr<internals::IConnection>()> factory)
+    {
+        stream->m_connectionFactory = std::move(factory);
+    }
+
+    const internals::SubscriptionRegistry &getSubscriptions()
+    {
+        return stream->m_subscriptions;
+    }
+
     boost::asio::io_context &getIoContext()
     {
         return m_context;
@@ -167,6 +177,191 @@ TEST_F(XStationClientStreamTest, listen_exception)
     EXPECT_TRUE(result.empty());
 }
 
+TEST_F(XStationClientStreamTest, listenTyped_ok)
+{
+    static constexpr std::string_view unknownFrame = R"({"command":"unknown","data":{}})";
+    static constexpr std::string_view tickFrame =
+        R"({"command":"tickPrices","data":{"ask":4000.0,"askVolume":15000,"bid":4000.5,"bidVolume":16000,)"
+        R"("high":4000.0,"level":0,"low":3500.0,"quoteId":0,"spreadRaw":0.000003,"spreadTable":0.00042,)"
+        R"("symbol":"KOMB.CZ","timestamp":1272529161605}})";
+
+    EXPECT_CALL(getMockedConnection(), waitFrame())
+        .WillOnce([]() -> boost::asio::awaitable<std::string_view> { co_return unknownFrame; })
+        .WillOnce([]() -> boost::asio::awaitable<std::string_view> { co_return tickFrame; });
+
+    StreamRecord result;
+    EXPECT_NO_THROW(result = runAwaitable(stream->listenTyped()));
+    ASSERT_TRUE(std::holds_alternative<TickRecord>(result));
+    const auto &tick = std::get<TickRecord>(result);
+    EXPECT_EQ(tick.symbol, "KOMB.CZ");
+    EXPECT_DOUBLE_EQ(tick.ask, 4000.0);
+    EXPECT_DOUBLE_EQ(tick.bid, 4000.5);
+    EXPECT_EQ(tick.askVolume, 15000);
+    EXPECT_EQ(tick.timestamp, 1272529161605);
+}
+
+TEST_F(XStationClientStreamTest, listenTyped_into_record)
+{
+    static constexpr std::string_view keepAliveFrame = R"({"command":"keepAlive","data":{"timestamp":1}})";
+    static constexpr std::string_view tickFrame =
+        R"({"command":"tickPrices","data":{"ask":4000.0,"bid":4000.5,"level":0,"symbol":"KOMB.CZ"}})";
+
+    EXPECT_CALL(getMockedConnection(), waitFrame())
+        .WillOnce([]() -> boost::asio::awaitable<std::string_view> { co_return keepAliveFrame; })
+        .WillOnce([]() -> boost::asio::awaitable<std::string_view> { co_return tickFrame; });
+
+    StreamRecord record;
+    EXPECT_NO_THROW(runAwaitableVoid(stream->listenTyped(record)));
+    EXPECT_TRUE(std::holds_alternative<KeepAliveRecord>(record));
+
+    EXPECT_NO_THROW(runAwaitableVoid(stream->listenTyped(record)));
+    ASSERT_TRUE(std::holds_alternative<TickRecord>(record));
+    EXPECT_EQ(std::get<TickRecord>(record).symbol, "KOMB.CZ");
+}
+
+TEST_F(XStationClientStreamTest, listenTyped_exception)
+{
+    EXPECT_CALL(getMockedConnection(), waitFrame())
+        .WillOnce([]() -> boost::asio::awaitable<std::string_view> {
+            throw exception::ConnectionClosed("Exception");
+        });
+
+    EXPECT_THROW(runAwaitable(stream->listenTyped()), exception::ConnectionClosed);
+}
+
+TEST_F(XStationClientStreamTest, listenTyped_invalid_json)
+{
+    EXPECT_CALL(getMockedConnection(), waitFrame())
+        .WillOnce([]() -> boost::asio::awaitable<std::string_view> { co_return "{\"command\":"; });
+
+    EXPECT_THROW(runAwaitable(stream->listenTyped()), exception::ConnectionClosed);
+}
+
+TEST_F(XStationClientStreamTest, listenTyped_reconnect_replays_subscriptions)
+{
+    static constexpr std::string_view candleFrame =
+        R"({"command":"candle","data":{"close":4.1,"ctm":1378369375000,"ctmString":"Sep 05, 2013 10:22:55 AM",)"
+        R"("high":4.1,"low":4.1,"open":4.1,"quoteId":2,"symbol":"US100","vol":0.0}})";
+
+    EXPECT_CALL(getMockedConnection(), makeRequest(testing::_))
+        .Times(2)
+        .WillRepeatedly([](const internals::Command &) -> boost::asio::awaitable<void> { co_return; });
+    EXPECT_CALL(getMockedConnection(), waitFrame())
+        .WillOnce([]() -> boost::asio::awaitable<std::string_view> {
+            throw exception::ConnectionClosed("Exception");
+        });
+    EXPECT_CALL(getMockedConnection(), disconnect())
+        .WillOnce([]() -> boost::asio::awaitable<void> { co_return; });
+
+    runAwaitableVoid(stream->getCandles("US100"));
+    getIoContext().restart();
+    runAwaitableVoid(stream->getNews());
+    getIoContext().restart();
+
+    const std::vector<boost::json::object> expectedCommands = {
+        {{"command", "getCandles"}, {"streamSessionId", "refreshedSessionId"}, {"symbol", "US100"}},
+        {{"command", "getNews"}, {"streamSessionId", "refreshedSessionId"}}
+    };
+
+    int connections = 0;
+    setConnectionFactory([&connections, &expectedCommands]() {
+        ++connections;
+        auto connection = std::make_unique<MockConnection>();
+        EXPECT_CALL(*connection, connect(testing::_))
+            .WillOnce([](const boost::url &) -> boost::asio::awaitable<void> { co_return; });
+        auto replayed = std::make_shared<std::size_t>(0);
+        EXPECT_CALL(*connection, makeRequest(testing::_))
+            .Times(2)
+            .WillRepeatedly([replayed, &expectedCommands](const boost::json::object &command) -> boost::asio::awaitable<void> {
+                EXPECT_EQ(command, expectedCommands[(*replayed)++]);
+                co_return;
+            });
+        EXPECT_CALL(*connection, waitFrame())
+            .WillOnce([]() -> boost::asio::awaitable<std::string_view> { co_return candleFrame; });
+        return connection;
+    });
+    stream->setSessionRefresher([]() -> boost::asio::awaitable<std::string> { co_return "refreshedSessionId"; });
+
+    ReconnectPolicy policy;
+    policy.enabled = true;
+    stream->setReconnectPolicy(policy);
+
+    StreamRecord result;
+    EXPECT_NO_THROW(result = runAwaitable(stream->listenTyped()));
+    ASSERT_TRUE(std::holds_alternative<CandleRecord>(result));
+    EXPECT_EQ(std::get<CandleRecord>(result).symbol, "US100");
+    EXPECT_EQ(connections, 1);
+    EXPECT_EQ(stream->reconnectCount(), 1);
+}
+
+TEST_F(XStationClientStreamTest, listen_reconnect_gives_up_after_max_attempts)
+{
+    EXPECT_CALL(getMockedConnection(), waitResponse())
+        .WillOnce([]() -> boost::asio::awaitable<boost::json::object> {
+            throw exception::ConnectionClosed("Exception");
+        });
+    EXPECT_CALL(getMockedConnection(), disconnect())
+        .WillOnce([]() -> boost::asio::awaitable<void> { co_return; });
+
+    int connections = 0;
+    setConnectionFactory([&connections]() {
+        ++connections;
+        auto connection = std::make_unique<MockConnection>();
+        EXPECT_CALL(*connection, connect(testing::_))
+            .WillOnce([](const boost::url &) -> boost::asio::awaitable<void> {
+                throw exception::ConnectionClosed("Exception");
+            });
+        // Every failed connection but the last one is closed before the next attempt
+        EXPECT_CALL(*connection, disconnect())
+            .Times(testing::AtMost(1))
+            .WillRepeatedly([]() -> boost::asio::awaitable<void> { co_return; });
+        return connection;
+    });
+
+    ReconnectPolicy policy;
+    policy.enabled = true;
+    policy.initialDelay = std::chrono::milliseconds(1);
+    policy.maxAttempts = 3;
+    stream->setReconnectPolicy(policy);
+
+    EXPECT_THROW(runAwaitable(stream->listen()), exception::ConnectionClosed);
+    EXPECT_EQ(connections, 3);
+    EXPECT_EQ(stream->reconnectCount(), 0);
+}
+
+TEST_F(XStationClientStreamTest, listen_reconnect_without_factory_fails)
+{
+    auto connection = std::make_unique<MockConnection>();
+    EXPECT_CALL(*connection, waitResponse())
+        .WillOnce([]() -> boost::asio::awaitable<boost::json::object> {
+            throw exception::ConnectionClosed("End of journal");
+        });
+    XStationClientStream givenStream(std::move(connection));
+
+    ReconnectPolicy policy;
+    policy.enabled = true;
+    givenStream.setReconnectPolicy(policy);
+
+    EXPECT_THROW(runAwaitable(givenStream.listen()), exception::ConnectionClosed);
+    EXPECT_EQ(givenStream.reconnectCount(), 0);
+}
+
+TEST_F(XStationClientStreamTest, stop_removes_subscription_from_replay)
+{
+    EXPECT_CALL(getMockedConnection(), makeRequest(testing::_))
+        .Times(3)
+        .WillRepeatedly([](const internals::Command &) -> boost::asio::awaitable<void> { co_return; });
+
+    runAwaitableVoid(stream->getTickPrices("EURUSD"));
+    getIoContext().restart();
+    runAwaitableVoid(stream->getBalance());
+    getIoContext().restart();
+    runAwaitableVoid(stream->stopTickPrices("EURUSD"));
+
+    ASSERT_EQ(getSubscriptions().size(), 1);
+    EXPECT_EQ(getSubscriptions().subscriptions()[0].command, "getBalance");
+}
+
 TEST_F(XStationClientStreamTest, getBalance_ok)
 {
     const boost::json::object expectedCommand = {
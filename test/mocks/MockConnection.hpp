@@ -13,8 +13,11 @@ public:
     MOCK_METHOD((boost::asio::awaitable<void>), disconnect, (), (override));
 
     // Mock the makeRequest method
-    MOCK_METHOD((boost::asio::awaitable<void>), makeRequest, (const boost::json::object &command), (override));
+    MOCK_METHOD((boost::asio::awaitable<void>), makeRequest, (const xapi::internals::Command &command), (override));
 
     // Mock the waitResponse method
     MOCK_METHOD((boost::asio::awaitable<boost::json::object>), waitResponse, (), (override));
+
+    // Mock the waitFrame method
+    MOCK_METHOD((boost::asio::awaitable<std::string_view>), waitFrame, (), (override));
 };
@@ -0,0 +1,211 @@
+#include "CandleAggregator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+namespace xapi
+{
+
+namespace
+{
+
+constexpr std::int64_t minuteMs = 60'000;
+constexpr std::int64_t dayMs = 1440 * minuteMs;
+
+// 1970-01-01 was a Thursday, the first Monday is 4 days later.
+constexpr std::int64_t firstMondayMs = 4 * dayMs;
+
+std::int64_t floorTo(std::int64_t value, std::int64_t step) noexcept
+{
+    std::int64_t quotient = value / step;
+    if (value % step < 0)
+    {
+        --quotient;
+    }
+    return quotient * step;
+}
+
+std::chrono::year_month_day toDate(std::int64_t time)
+{
+    const std::chrono::sys_time<std::chrono::milliseconds> point{std::chrono::milliseconds(time)};
+    return std::chrono::year_month_day(std::chrono::floor<std::chrono::days>(point));
+}
+
+std::int64_t toMilliseconds(std::chrono::year_month_day date)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::sys_days(date).time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+CandleAggregator::CandleAggregator(BarHandler handler) : m_handler(std::move(handler)), m_series(), m_late(0)
+{
+}
+
+void CandleAggregator::setBarHandler(BarHandler handler)
+{
+    m_handler = std::move(handler);
+}
+
+void CandleAggregator::onTick(const TickRecord &tick)
+{
+    if (tick.level != 0)
+    {
+        return;
+    }
+
+    Series &symbolSeries = series(tick.symbol);
+    if (tick.timestamp < symbolSeries.lateBefore)
+    {
+        ++m_late;
+        return;
+    }
+    // The M1 bar is the latest one, a tick before it is before all the others.
+    symbolSeries.lateBefore = periodStart(PeriodCode::PERIOD_M1, tick.timestamp);
+
+    const Candle price{tick.timestamp, tick.bid, tick.bid, tick.bid, tick.bid, 0.0};
+    for (std::size_t i = 0; i < periods.size(); ++i)
+    {
+        fold(tick.symbol, i, symbolSeries.bars[i], tick.timestamp, tick.timestamp, price);
+    }
+}
+
+void CandleAggregator::onCandle(const CandleRecord &candle)
+{
+    Series &symbolSeries = series(candle.symbol);
+    if (candle.ctm < symbolSeries.lateBefore)
+    {
+        ++m_late;
+        return;
+    }
+    // A candle received again would be counted twice in the longer bars.
+    const std::int64_t end = candle.ctm + minuteMs;
+    symbolSeries.lateBefore = end;
+
+    const Candle price{candle.ctm, candle.open, candle.high, candle.low, candle.close, candle.vol};
+    for (std::size_t i = 0; i < periods.size(); ++i)
+    {
+        fold(candle.symbol, i, symbolSeries.bars[i], candle.ctm, end, price);
+    }
+}
+
+std::size_t CandleAggregator::closeExpired(std::int64_t now)
+{
+    std::size_t closed = 0;
+    for (auto &[symbol, symbolSeries] : m_series)
+    {
+        for (std::size_t i = 0; i < periods.size(); ++i)
+        {
+            Bar &bar = symbolSeries.bars[i];
+            if (bar.open && bar.end <= now)
+            {
+                close(symbol, i, bar);
+                ++closed;
+            }
+        }
+    }
+    return closed;
+}
+
+std::optional<Candle> CandleAggregator::current(std::string_view symbol, PeriodCode period) const
+{
+    const auto it = m_series.find(SymbolName(symbol));
+    const auto index = std::find(periods.begin(), periods.end(), period);
+    if (it == m_series.end() || index == periods.end())
+    {
+        return std::nullopt;
+    }
+
+    const Bar &bar = it->second.bars[static_cast<std::size_t>(index - periods.begin())];
+    if (!bar.open)
+    {
+        return std::nullopt;
+    }
+    return bar.candle;
+}
+
+std::size_t CandleAggregator::symbolCount() const noexcept
+{
+    return m_series.size();
+}
+
+std::uint64_t CandleAggregator::late() const noexcept
+{
+    return m_late;
+}
+
+std::int64_t CandleAggregator::periodStart(PeriodCode period, std::int64_t time)
+{
+    switch (period)
+    {
+    case PeriodCode::PERIOD_W1:
+        return floorTo(time - firstMondayMs, 7 * dayMs) + firstMondayMs;
+    case PeriodCode::PERIOD_MN1: {
+        const std::chrono::year_month_day date = toDate(time);
+        return toMilliseconds(date.year() / date.month() / 1);
+    }
+    default:
+        return floorTo(time, static_cast<std::int64_t>(period) * minuteMs);
+    }
+}
+
+std::int64_t CandleAggregator::periodEnd(PeriodCode period, std::int64_t start)
+{
+    if (period == PeriodCode::PERIOD_MN1)
+    {
+        const std::chrono::year_month_day date = toDate(start);
+        return toMilliseconds(date.year() / date.month() / 1 + std::chrono::months(1));
+    }
+    return start + static_cast<std::int64_t>(period) * minuteMs;
+}
+
+CandleAggregator::Series &CandleAggregator::series(const SymbolName &symbol)
+{
+    return m_series.try_emplace(symbol).first->second;
+}
+
+void CandleAggregator::fold(const SymbolName &symbol, std::size_t index, Bar &bar, std::int64_t time,
+                            std::int64_t end, const Candle &price)
+{
+    if (bar.open && time >= bar.end)
+    {
+        close(symbol, index, bar);
+    }
+
+    if (!bar.open)
+    {
+        const std::int64_t start = periodStart(periods[index], time);
+        bar.candle = Candle{start, price.open, price.high, price.low, price.close, price.vol};
+        bar.end = periodEnd(periods[index], start);
+        bar.open = true;
+    }
+    else
+    {
+        bar.candle.high = std::max(bar.candle.high, price.high);
+        bar.candle.low = std::min(bar.candle.low, price.low);
+        bar.candle.close = price.close;
+        bar.candle.vol += price.vol;
+    }
+
+    if (end >= bar.end)
+    {
+        close(symbol, index, bar);
+    }
+}
+
+void CandleAggregator::close(const SymbolName &symbol, std::size_t index, Bar &bar)
+{
+    bar.open = false;
+    if (m_handler)
+    {
+        m_handler(symbol.view(), periods[index], bar.candle);
+    }
+}
+
+std::size_t CandleAggregator::SymbolHash::operator()(const SymbolName &symbol) const noexcept
+{
+    return std::hash<std::string_view>()(symbol.view());
+}
+
+} // namespace xapi
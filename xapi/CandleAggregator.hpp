@@ -0,0 +1,147 @@
+#pragma once
+
+/**
+ * @file CandleAggregator.hpp
+ * @brief Defines the CandleAggregator class building candles of every period from the stream.
+ *
+ * This file contains the definition of the CandleAggregator class, which maintains the current
+ * bar of each PeriodCode per symbol from streamed ticks or one minute candles.
+ */
+
+#include "CandleStore.hpp"
+#include "Enums.hpp"
+#include "StreamRecords.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace xapi
+{
+
+/**
+ * @class CandleAggregator
+ * @brief Aggregates streamed prices into candles of all periods, from M1 to MN1.
+ *
+ * onTick() folds the bid price of level 0 ticks into the current bar of every period, as the
+ * server charts are built from bid prices; tick volume is not known so `vol` stays 0.
+ * onCandle() folds the one minute candles of the getCandles stream, with their volume.
+ * Feed a symbol from one of the two sources only, otherwise its prices are counted twice.
+ *
+ * Bars start at multiples of their period in the received time base, W1 bars on Monday and
+ * MN1 bars on the first day of the calendar month. A bar is closed when a price of a later
+ * bar arrives, when a candle reaching its end is folded, or by closeExpired(). Every update
+ * costs a constant amount of work per period. Prices older than the current bar are counted
+ * as late and ignored.
+ *
+ * The aggregator is not thread-safe, it is meant to be fed from the thread receiving the stream,
+ * for example by StreamDispatcher handlers. The bar handler is called on that thread.
+ */
+class CandleAggregator final
+{
+  public:
+    using BarHandler = std::function<void(std::string_view symbol, PeriodCode period, const Candle &bar)>;
+
+    // Periods maintained for every symbol, shortest first.
+    static constexpr std::array<PeriodCode, 9> periods{
+        PeriodCode::PERIOD_M1, PeriodCode::PERIOD_M5, PeriodCode::PERIOD_M15,
+        PeriodCode::PERIOD_M30, PeriodCode::PERIOD_H1, PeriodCode::PERIOD_H4,
+        PeriodCode::PERIOD_D1, PeriodCode::PERIOD_W1, PeriodCode::PERIOD_MN1};
+
+    CandleAggregator(const CandleAggregator &) = delete;
+    CandleAggregator &operator=(const CandleAggregator &) = delete;
+
+    /**
+     * @brief Constructs a new CandleAggregator object.
+     * @param handler Called with every closed bar, may be empty.
+     */
+    explicit CandleAggregator(BarHandler handler = BarHandler());
+
+    void setBarHandler(BarHandler handler);
+
+    /**
+     * @brief Folds a tick into the bars of its symbol, ticks of other levels than 0 are ignored.
+     * @param tick The received tick.
+     */
+    void onTick(const TickRecord &tick);
+
+    /**
+     * @brief Folds a one minute candle into the bars of its symbol.
+     * @param candle The received candle.
+     */
+    void onCandle(const CandleRecord &candle);
+
+    /**
+     * @brief Closes the bars ending before a time, for symbols that stopped trading.
+     * @param now The current time in milliseconds, in the time base of the stream.
+     * @return Number of closed bars.
+     */
+    std::size_t closeExpired(std::int64_t now);
+
+    /**
+     * @brief Gets the bar being built.
+     * @param symbol The symbol name.
+     * @param period The bar period.
+     * @return The bar, or std::nullopt if there is no open bar.
+     */
+    std::optional<Candle> current(std::string_view symbol, PeriodCode period) const;
+
+    std::size_t symbolCount() const noexcept;
+
+    // Number of prices ignored because they were older than the current bar.
+    std::uint64_t late() const noexcept;
+
+    /**
+     * @brief Gets the start of the bar containing a time.
+     * @param period The bar period.
+     * @param time Time in milliseconds since epoch.
+     * @return Start of the bar in milliseconds since epoch.
+     */
+    static std::int64_t periodStart(PeriodCode period, std::int64_t time);
+
+    /**
+     * @brief Gets the end of a bar, which is the start of the next one.
+     * @param period The bar period.
+     * @param start Start of the bar, as returned by periodStart().
+     * @return End of the bar in milliseconds since epoch.
+     */
+    static std::int64_t periodEnd(PeriodCode period, std::int64_t start);
+
+  private:
+    struct Bar
+    {
+        Candle candle;
+        std::int64_t end = 0;
+        bool open = false;
+    };
+
+    struct SymbolHash
+    {
+        std::size_t operator()(const SymbolName &symbol) const noexcept;
+    };
+
+    struct Series
+    {
+        std::array<Bar, periods.size()> bars;
+        // Prices before this time are late.
+        std::int64_t lateBefore = std::numeric_limits<std::int64_t>::min();
+    };
+
+    Series &series(const SymbolName &symbol);
+
+    // Folds one price interval [time, end) into a bar, closing it first if the price belongs to a later bar.
+    void fold(const SymbolName &symbol, std::size_t index, Bar &bar, std::int64_t time, std::int64_t end,
+              const Candle &price);
+
+    void close(const SymbolName &symbol, std::size_t index, Bar &bar);
+
+    BarHandler m_handler;
+    std::unordered_map<SymbolName, Series, SymbolHash> m_series;
+    std::uint64_t m_late;
+};
+
+} // namespace xapi
@@ -0,0 +1,475 @@
+#include "CandleStore.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace xapi
+{
+namespace internals
+{
+
+namespace
+{
+
+constexpr std::array<char, 8> seriesMagic = {'X', 'A', 'P', 'I', 'C', 'D', 'L', '\0'};
+constexpr std::uint32_t seriesFormatVersion = 1;
+
+// Candles between two absolute block entries.
+constexpr std::size_t blockSize = 1024;
+
+struct SeriesHeader
+{
+    std::array<char, 8> magic;
+    std::uint32_t formatVersion;
+    std::int32_t digits;
+    std::uint64_t count;
+    std::uint64_t rangeCount;
+    std::uint64_t blockCount;
+};
+
+struct Block
+{
+    std::int64_t ctm;
+    std::int64_t open;
+};
+
+// Candle with prices in integer points.
+struct EncodedCandle
+{
+    std::int64_t ctm;
+    std::int64_t open;
+    std::int64_t high;
+    std::int64_t low;
+    std::int64_t close;
+    double vol;
+};
+
+std::system_error systemError(const std::string &what, const std::filesystem::path &file)
+{
+    return std::system_error(errno, std::generic_category(), what + " " + file.string());
+}
+
+std::int64_t toPoints(double price, double scale)
+{
+    const double points = std::round(price * scale);
+    if (!(std::abs(points) < 9.0e15))
+    {
+        throw std::range_error("Candle price cannot be stored in points");
+    }
+    return static_cast<std::int64_t>(points);
+}
+
+template <typename Integer> Integer narrow(std::int64_t value)
+{
+    if (value < std::numeric_limits<Integer>::min() || value > std::numeric_limits<Integer>::max())
+    {
+        throw std::range_error("Candle delta out of range");
+    }
+    return static_cast<Integer>(value);
+}
+
+} // namespace
+
+/**
+ * @class CandleSeries
+ * @brief Read-only view of a mapped series file.
+ *
+ * Layout: header, fetched ranges, blocks, then the columns vol (double), ctm delta in seconds
+ * (uint32), open delta, high, low and close offsets in points (int32).
+ */
+class CandleSeries final
+{
+  public:
+    CandleSeries(const CandleSeries &) = delete;
+    CandleSeries &operator=(const CandleSeries &) = delete;
+
+    ~CandleSeries()
+    {
+        ::munmap(const_cast<std::byte *>(m_data), m_size);
+    }
+
+    static std::unique_ptr<CandleSeries> load(const std::filesystem::path &file)
+    {
+        const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            throw systemError("Cannot open candle series", file);
+        }
+
+        struct stat status;
+        if (::fstat(fd, &status) != 0)
+        {
+            const auto error = systemError("Cannot stat candle series", file);
+            ::close(fd);
+            throw error;
+        }
+
+        const auto size = static_cast<std::size_t>(status.st_size);
+        if (size < sizeof(SeriesHeader))
+        {
+            ::close(fd);
+            throw std::runtime_error("Candle series is truncated: " + file.string());
+        }
+
+        void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            throw systemError("Cannot map candle series", file);
+        }
+
+        std::unique_ptr<CandleSeries> series(new CandleSeries(static_cast<const std::byte *>(data), size));
+        const SeriesHeader &header = series->header();
+        const bool valid = header.magic == seriesMagic && header.formatVersion == seriesFormatVersion &&
+                           header.blockCount == (header.count + blockSize - 1) / blockSize &&
+                           size == fileSize(header.count, header.rangeCount, header.blockCount);
+        if (!valid)
+        {
+            throw std::runtime_error("Not a candle series of this version: " + file.string());
+        }
+        return series;
+    }
+
+    static void write(const std::filesystem::path &file, int digits, const std::vector<EncodedCandle> &candles,
+                      const std::vector<TimeRange> &ranges)
+    {
+        const std::size_t count = candles.size();
+        const std::size_t blockCount = (count + blockSize - 1) / blockSize;
+
+        std::vector<Block> blocks(blockCount);
+        std::vector<double> vol(count);
+        std::vector<std::uint32_t> ctmDelta(count);
+        std::vector<std::int32_t> openDelta(count);
+        std::vector<std::int32_t> high(count);
+        std::vector<std::int32_t> low(count);
+        std::vector<std::int32_t> close(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const EncodedCandle &candle = candles[i];
+            if (i % blockSize == 0)
+            {
+                blocks[i / blockSize] = Block{candle.ctm, candle.open};
+            }
+            else
+            {
+                ctmDelta[i] = narrow<std::uint32_t>((candle.ctm - candles[i - 1].ctm) / 1000);
+                openDelta[i] = narrow<std::int32_t>(candle.open - candles[i - 1].open);
+            }
+            vol[i] = candle.vol;
+            high[i] = narrow<std::int32_t>(candle.high - candle.open);
+            low[i] = narrow<std::int32_t>(candle.low - candle.open);
+            close[i] = narrow<std::int32_t>(candle.close - candle.open);
+        }
+
+        SeriesHeader header{};
+        header.magic = seriesMagic;
+        header.formatVersion = seriesFormatVersion;
+        header.digits = digits;
+        header.count = count;
+        header.rangeCount = ranges.size();
+        header.blockCount = blockCount;
+
+        // Readers that mapped the previous file keep it until they unmap it.
+        std::filesystem::path temporary = file;
+        temporary += ".tmp" + std::to_string(::getpid());
+        {
+            std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+            const auto append = [&output](const void *data, std::size_t size) {
+                output.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            };
+            append(&header, sizeof(header));
+            append(ranges.data(), ranges.size() * sizeof(TimeRange));
+            append(blocks.data(), blocks.size() * sizeof(Block));
+            append(vol.data(), count * sizeof(double));
+            append(ctmDelta.data(), count * sizeof(std::uint32_t));
+            append(openDelta.data(), count * sizeof(std::int32_t));
+            append(high.data(), count * sizeof(std::int32_t));
+            append(low.data(), count * sizeof(std::int32_t));
+            append(close.data(), count * sizeof(std::int32_t));
+            output.flush();
+            if (!output)
+            {
+                const auto error = systemError("Cannot write candle series", temporary);
+                output.close();
+                std::filesystem::remove(temporary);
+                throw error;
+            }
+        }
+        std::filesystem::rename(temporary, file);
+    }
+
+    int digits() const noexcept
+    {
+        return header().digits;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return header().count;
+    }
+
+    std::span<const TimeRange> ranges() const noexcept
+    {
+        return {reinterpret_cast<const TimeRange *>(m_data + sizeof(SeriesHeader)), header().rangeCount};
+    }
+
+    // Decodes the candles starting in [start, end), in time order.
+    template <typename Output> void decode(std::int64_t start, std::int64_t end, Output &&output) const
+    {
+        const SeriesHeader &seriesHeader = header();
+        const std::size_t count = seriesHeader.count;
+        const auto *blocks = reinterpret_cast<const Block *>(ranges().data() + seriesHeader.rangeCount);
+        const auto *vol = reinterpret_cast<const double *>(blocks + seriesHeader.blockCount);
+        const auto *ctmDelta = reinterpret_cast<const std::uint32_t *>(vol + count);
+        const auto *openDelta = reinterpret_cast<const std::int32_t *>(ctmDelta + count);
+        const auto *high = openDelta + count;
+        const auto *low = high + count;
+        const auto *close = low + count;
+
+        // Last block starting at or before start.
+        const auto *block =
+            std::upper_bound(blocks, blocks + seriesHeader.blockCount, start,
+                             [](std::int64_t value, const Block &candidate) { return value < candidate.ctm; });
+        std::size_t i = block == blocks ? 0 : static_cast<std::size_t>(block - blocks - 1) * blockSize;
+
+        EncodedCandle candle{};
+        for (; i < count; ++i)
+        {
+            if (i % blockSize == 0)
+            {
+                candle.ctm = blocks[i / blockSize].ctm;
+                candle.open = blocks[i / blockSize].open;
+            }
+            else
+            {
+                candle.ctm += static_cast<std::int64_t>(ctmDelta[i]) * 1000;
+                candle.open += openDelta[i];
+            }
+
+            if (candle.ctm >= end)
+            {
+                break;
+            }
+            if (candle.ctm >= start)
+            {
+                candle.high = candle.open + high[i];
+                candle.low = candle.open + low[i];
+                candle.close = candle.open + close[i];
+                candle.vol = vol[i];
+                output(candle);
+            }
+        }
+    }
+
+  private:
+    CandleSeries(const std::byte *data, std::size_t size) noexcept : m_data(data), m_size(size)
+    {
+    }
+
+    static std::size_t fileSize(std::size_t count, std::size_t rangeCount, std::size_t blockCount) noexcept
+    {
+        return sizeof(SeriesHeader) + rangeCount * sizeof(TimeRange) + blockCount * sizeof(Block) +
+               count * (sizeof(double) + sizeof(std::uint32_t) + 4 * sizeof(std::int32_t));
+    }
+
+    const SeriesHeader &header() const noexcept
+    {
+        return *reinterpret_cast<const SeriesHeader *>(m_data);
+    }
+
+    const std::byte *m_data;
+    std::size_t m_size;
+};
+
+} // namespace internals
+
+CandleStore::CandleStore(std::filesystem::path directory)
+    : m_directory(std::move(directory)), m_mutex(), m_series()
+{
+    std::filesystem::create_directories(m_directory);
+}
+
+CandleStore::~CandleStore() = default;
+
+std::vector<Candle> CandleStore::read(std::string_view symbol, PeriodCode period, TimeRange range)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Candle> candles;
+    const internals::CandleSeries *stored = series(symbol, period);
+    if (stored == nullptr)
+    {
+        return candles;
+    }
+
+    const double scale = std::pow(10.0, stored->digits());
+    stored->decode(range.start, range.end, [&candles, scale](const internals::EncodedCandle &candle) {
+        candles.push_back(Candle{candle.ctm, candle.open / scale, candle.high / scale, candle.low / scale,
+                                 candle.close / scale, candle.vol});
+    });
+    return candles;
+}
+
+std::vector<TimeRange> CandleStore::missing(std::string_view symbol, PeriodCode period, TimeRange range)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<TimeRange> result;
+    const internals::CandleSeries *stored = series(symbol, period);
+
+    std::int64_t cursor = range.start;
+    if (stored != nullptr)
+    {
+        for (const TimeRange &fetched : stored->ranges())
+        {
+            if (fetched.start >= range.end)
+            {
+                break;
+            }
+            if (fetched.end <= cursor)
+            {
+                continue;
+            }
+            if (fetched.start > cursor)
+            {
+                result.push_back(TimeRange{cursor, fetched.start});
+            }
+            cursor = fetched.end;
+        }
+    }
+    if (cursor < range.end)
+    {
+        result.push_back(TimeRange{cursor, range.end});
+    }
+    return result;
+}
+
+void CandleStore::merge(std::string_view symbol, PeriodCode period, TimeRange range, std::span<const Candle> candles,
+                        int digits)
+{
+    merge(symbol, period, std::span<const TimeRange>(&range, 1), candles, digits);
+}
+
+void CandleStore::merge(std::string_view symbol, PeriodCode period, std::span<const TimeRange> ranges,
+                        std::span<const Candle> candles, int digits)
+{
+    const double scale = std::pow(10.0, digits);
+
+    // New candles first, so they are kept when the stored series has the same time.
+    std::vector<internals::EncodedCandle> merged;
+    merged.reserve(candles.size());
+    for (const Candle &candle : candles)
+    {
+        if (candle.ctm % 1000 != 0)
+        {
+            throw std::invalid_argument("Candle time is not in whole seconds");
+        }
+        merged.push_back(internals::EncodedCandle{
+            candle.ctm, internals::toPoints(candle.open, scale), internals::toPoints(candle.high, scale),
+            internals::toPoints(candle.low, scale), internals::toPoints(candle.close, scale), candle.vol});
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<TimeRange> fetched;
+    const internals::CandleSeries *stored = series(symbol, period);
+    if (stored != nullptr)
+    {
+        fetched.assign(stored->ranges().begin(), stored->ranges().end());
+
+        // Points of the stored digits are converted if the symbol's digits changed.
+        const double rescale = std::pow(10.0, digits - stored->digits());
+        const auto convert = [rescale](std::int64_t points) {
+            return static_cast<std::int64_t>(std::round(static_cast<double>(points) * rescale));
+        };
+        merged.reserve(merged.size() + stored->size());
+        stored->decode(std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max(),
+                       [&merged, &convert](const internals::EncodedCandle &candle) {
+                           merged.push_back(internals::EncodedCandle{candle.ctm, convert(candle.open),
+                                                                     convert(candle.high), convert(candle.low),
+                                                                     convert(candle.close), candle.vol});
+                       });
+    }
+
+    std::stable_sort(merged.begin(), merged.end(),
+                     [](const auto &lhs, const auto &rhs) { return lhs.ctm < rhs.ctm; });
+    merged.erase(std::unique(merged.begin(), merged.end(),
+                             [](const auto &lhs, const auto &rhs) { return lhs.ctm == rhs.ctm; }),
+                 merged.end());
+
+    for (const TimeRange &range : ranges)
+    {
+        if (range.start < range.end)
+        {
+            fetched.push_back(range);
+        }
+    }
+    std::sort(fetched.begin(), fetched.end(),
+              [](const TimeRange &lhs, const TimeRange &rhs) { return lhs.start < rhs.start; });
+
+    std::vector<TimeRange> coalesced;
+    for (const TimeRange &range : fetched)
+    {
+        if (!coalesced.empty() && range.start <= coalesced.back().end)
+        {
+            coalesced.back().end = std::max(coalesced.back().end, range.end);
+        }
+        else
+        {
+            coalesced.push_back(range);
+        }
+    }
+
+    const auto file = seriesFile(symbol, period);
+    internals::CandleSeries::write(file, digits, merged, coalesced);
+    m_series[Key(std::string(symbol), period)] = internals::CandleSeries::load(file);
+}
+
+std::size_t CandleStore::size(std::string_view symbol, PeriodCode period)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const internals::CandleSeries *stored = series(symbol, period);
+    return stored == nullptr ? 0 : stored->size();
+}
+
+std::filesystem::path CandleStore::seriesFile(std::string_view symbol, PeriodCode period) const
+{
+    std::string name(symbol);
+    std::replace(name.begin(), name.end(), '/', '_');
+    std::replace(name.begin(), name.end(), '\\', '_');
+    return m_directory / (name + "_" + std::to_string(static_cast<int>(period)) + ".candles");
+}
+
+const internals::CandleSeries *CandleStore::series(std::string_view symbol, PeriodCode period)
+{
+    Key key(std::string(symbol), period);
+    const auto it = m_series.find(key);
+    if (it != m_series.end())
+    {
+        return it->second.get();
+    }
+
+    const auto file = seriesFile(symbol, period);
+    if (!std::filesystem::exists(file))
+    {
+        return nullptr;
+    }
+
+    auto loaded = internals::CandleSeries::load(file);
+    const internals::CandleSeries *result = loaded.get();
+    m_series.emplace(std::move(key), std::move(loaded));
+    return result;
+}
+
+} // namespace xapi
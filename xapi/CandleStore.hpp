@@ -0,0 +1,164 @@
+#pragma once
+
+/**
+ * @file CandleStore.hpp
+ * @brief Defines the CandleStore class, a local on-disk cache of chart candles.
+ *
+ * This file contains the definition of the Candle record, the TimeRange interval and the
+ * CandleStore class, which keeps columnar delta-encoded candles in memory-mapped files.
+ */
+
+#include "Enums.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace xapi
+{
+
+/**
+ * @brief One chart candle with absolute prices.
+ */
+struct Candle
+{
+    // Candle start time in milliseconds since epoch, CET/CEST as sent by the server.
+    std::int64_t ctm = 0;
+    double open = 0.0;
+    double high = 0.0;
+    double low = 0.0;
+    double close = 0.0;
+    double vol = 0.0;
+};
+
+/**
+ * @brief Half-open time interval [start, end) in milliseconds since epoch.
+ */
+struct TimeRange
+{
+    std::int64_t start = 0;
+    std::int64_t end = 0;
+
+    friend bool operator==(const TimeRange &lhs, const TimeRange &rhs) noexcept = default;
+};
+
+namespace internals
+{
+class CandleSeries;
+} // namespace internals
+
+/**
+ * @class CandleStore
+ * @brief Cache of chart candles keyed by symbol and period, persisted in a directory.
+ *
+ * Each series is one file holding its candles as columns: time and open price are stored as
+ * deltas from the previous candle, high, low and close as offsets from the open, all in integer
+ * points of the symbol's digits. Every 1024 candles a block entry keeps the absolute values,
+ * so a range is read by decoding only the blocks it overlaps. The file also lists the time
+ * ranges fetched from the server, so that missing() returns what still has to be requested.
+ *
+ * Files are mapped read-only, merge() writes a new file and replaces the old one atomically.
+ * All methods are thread-safe. XStationClient::getCachedChartRange() fills the store.
+ */
+class CandleStore final
+{
+  public:
+    CandleStore(const CandleStore &) = delete;
+    CandleStore &operator=(const CandleStore &) = delete;
+
+    /**
+     * @brief Constructs a new CandleStore object.
+     * @param directory The directory of the series files, created if needed.
+     * @throw std::filesystem::filesystem_error if the directory cannot be created.
+     */
+    explicit CandleStore(std::filesystem::path directory);
+
+    ~CandleStore();
+
+    /**
+     * @brief Reads the stored candles of a time range.
+     * @param symbol The symbol name.
+     * @param period The candle period.
+     * @param range The time range, candles starting inside it are returned.
+     * @return The candles ordered by time.
+     */
+    std::vector<Candle> read(std::string_view symbol, PeriodCode period, TimeRange range);
+
+    /**
+     * @brief Gets the parts of a time range that were not fetched from the server yet.
+     * @param symbol The symbol name.
+     * @param period The candle period.
+     * @param range The wanted time range.
+     * @return The missing ranges, ordered by time.
+     */
+    std::vector<TimeRange> missing(std::string_view symbol, PeriodCode period, TimeRange range);
+
+    /**
+     * @brief Adds candles fetched from the server and marks their range as fetched.
+     *
+     * Stored candles with the same time are replaced.
+     * @param symbol The symbol name.
+     * @param period The candle period.
+     * @param range The requested time range, empty ranges only add candles.
+     * @param candles The received candles, in any order.
+     * @param digits Number of decimal digits of the symbol's prices.
+     * @throw std::invalid_argument if a candle time is not in whole seconds.
+     * @throw std::range_error if the prices cannot be encoded with the digits.
+     * @throw std::system_error if the file cannot be written.
+     */
+    void merge(std::string_view symbol, PeriodCode period, TimeRange range, std::span<const Candle> candles,
+               int digits);
+
+    /**
+     * @brief Adds candles fetched from the server with several requests.
+     * @param symbol The symbol name.
+     * @param period The candle period.
+     * @param ranges The requested time ranges, in any order.
+     * @param candles The received candles, in any order.
+     * @param digits Number of decimal digits of the symbol's prices.
+     * @throw std::invalid_argument if a candle time is not in whole seconds.
+     * @throw std::range_error if the prices cannot be encoded with the digits.
+     * @throw std::system_error if the file cannot be written.
+     */
+    void merge(std::string_view symbol, PeriodCode period, std::span<const TimeRange> ranges,
+               std::span<const Candle> candles, int digits);
+
+    /**
+     * @brief Gets the number of stored candles of a series.
+     * @param symbol The symbol name.
+     * @param period The candle period.
+     * @return Number of candles.
+     */
+    std::size_t size(std::string_view symbol, PeriodCode period);
+
+    /**
+     * @brief Gets the file of a series.
+     * @param symbol The symbol name.
+     * @param period The candle period.
+     * @return The file path, the file may not exist.
+     */
+    std::filesystem::path seriesFile(std::string_view symbol, PeriodCode period) const;
+
+  private:
+    using Key = std::pair<std::string, PeriodCode>;
+
+    // Finds the mapped series, mapping its file on first use, nullptr if there is no file.
+    const internals::CandleSeries *series(std::string_view symbol, PeriodCode period);
+
+    const std::filesystem::path m_directory;
+
+    // Guards m_series.
+    std::mutex m_mutex;
+
+    // Mapped series, replaced when merged.
+    std::map<Key, std::unique_ptr<internals::CandleSeries>> m_series;
+};
+
+} // namespace xapi
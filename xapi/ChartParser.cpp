@@ -0,0 +1,38 @@
+#include "ChartParser.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace xapi
+{
+namespace internals
+{
+
+int parseChart(const boost::json::object &response, std::vector<Candle> &candles)
+{
+    const auto *returnData = response.if_contains("returnData");
+    if (returnData == nullptr || !returnData->is_object() || !returnData->as_object().contains("rateInfos"))
+    {
+        throw std::runtime_error("Chart request did not return the candles");
+    }
+
+    const auto &chart = returnData->as_object();
+    const int digits = chart.contains("digits") ? chart.at("digits").to_number<int>() : 0;
+    const double scale = std::pow(10.0, digits);
+
+    const auto &rateInfos = chart.at("rateInfos").as_array();
+    candles.reserve(candles.size() + rateInfos.size());
+    for (const auto &value : rateInfos)
+    {
+        const auto &rateInfo = value.as_object();
+        const double open = rateInfo.at("open").to_number<double>();
+        candles.push_back(Candle{rateInfo.at("ctm").to_number<std::int64_t>(), open / scale,
+                                 (open + rateInfo.at("high").to_number<double>()) / scale,
+                                 (open + rateInfo.at("low").to_number<double>()) / scale,
+                                 (open + rateInfo.at("close").to_number<double>()) / scale,
+                                 rateInfo.at("vol").to_number<double>()});
+    }
+    return digits;
+}
+
+} // namespace internals
+} // namespace xapi
@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+ * @file ChartParser.hpp
+ * @brief Declares the parsing of chart responses into candles.
+ *
+ * This file contains the declaration of parseChart, which converts the rateInfos of a
+ * getChartRangeRequest or getChartLastRequest response into Candle records.
+ */
+
+#include "CandleStore.hpp"
+#include <boost/json.hpp>
+#include <vector>
+
+namespace xapi
+{
+namespace internals
+{
+
+/**
+ * @brief Converts the candles of a chart response to absolute prices.
+ *
+ * In rateInfos, open is in points and high, low and close are offsets from open in points.
+ * @param response The whole response of the chart request.
+ * @param candles Receives the candles, they are appended.
+ * @return Number of decimal digits of the prices.
+ * @throw std::runtime_error if the response has no candles.
+ */
+int parseChart(const boost::json::object &response, std::vector<Candle> &candles);
+
+} // namespace internals
+} // namespace xapi
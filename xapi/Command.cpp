@@ -0,0 +1,339 @@
+#include "Command.hpp"
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace xapi
+{
+namespace internals
+{
+
+namespace
+{
+
+void appendString(std::string &buffer, std::string_view value)
+{
+    static constexpr char hexDigits[] = "0123456789abcdef";
+
+    buffer.push_back('"');
+    std::size_t chunkStart = 0;
+    for (std::size_t i = 0; i < value.size(); ++i)
+    {
+        const auto c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+
+        buffer.append(value.substr(chunkStart, i - chunkStart));
+        chunkStart = i + 1;
+        switch (c)
+        {
+        case '"':
+            buffer.append("\\\"");
+            break;
+        case '\\':
+            buffer.append("\\\\");
+            break;
+        case '\n':
+            buffer.append("\\n");
+            break;
+        case '\r':
+            buffer.append("\\r");
+            break;
+        case '\t':
+            buffer.append("\\t");
+            break;
+        default:
+            buffer.append("\\u00");
+            buffer.push_back(hexDigits[c >> 4]);
+            buffer.push_back(hexDigits[c & 0x0F]);
+            break;
+        }
+    }
+    buffer.append(value.substr(chunkStart));
+    buffer.push_back('"');
+}
+
+void appendInteger(std::string &buffer, std::int64_t value)
+{
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, result.ptr);
+}
+
+void appendDouble(std::string &buffer, double value)
+{
+    if (!std::isfinite(value))
+    {
+        buffer.append("null");
+        return;
+    }
+
+    char digits[32];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    const std::string_view rendered(digits, static_cast<std::size_t>(result.ptr - digits));
+    buffer.append(rendered);
+    if (rendered.find_first_of(".e") == std::string_view::npos)
+    {
+        // Keep the value a floating point number for the server
+        buffer.append(".0");
+    }
+}
+
+} // namespace
+
+PrerenderedMember::PrerenderedMember(std::string_view key, std::string_view value) : m_key(key), m_value(value)
+{
+    appendString(m_rendered, m_key);
+    m_rendered.push_back(':');
+    appendString(m_rendered, m_value);
+}
+
+std::string_view PrerenderedMember::key() const noexcept
+{
+    return m_key;
+}
+
+std::string_view PrerenderedMember::value() const noexcept
+{
+    return m_value;
+}
+
+std::string_view PrerenderedMember::rendered() const noexcept
+{
+    return m_rendered;
+}
+
+Command::Command(std::string_view name) : m_name(name), m_members(), m_size(0)
+{
+}
+
+Command &Command::add(std::string_view key, std::string_view value)
+{
+    return append(key, value);
+}
+
+Command &Command::add(std::string_view key, const char *value)
+{
+    return append(key, std::string_view(value));
+}
+
+Command &Command::add(std::string_view key, const std::string &value)
+{
+    return append(key, std::string_view(value));
+}
+
+Command &Command::add(std::string_view key, bool value)
+{
+    return append(key, value);
+}
+
+Command &Command::add(std::string_view key, int value)
+{
+    return append(key, static_cast<std::int64_t>(value));
+}
+
+Command &Command::add(std::string_view key, std::int64_t value)
+{
+    return append(key, value);
+}
+
+Command &Command::add(std::string_view key, double value)
+{
+    return append(key, value);
+}
+
+Command &Command::add(std::string_view key, const std::vector<std::string> &values)
+{
+    return append(key, &values);
+}
+
+Command &Command::add(std::string_view key, const std::vector<int> &values)
+{
+    return append(key, &values);
+}
+
+Command &Command::add(const PrerenderedMember &member)
+{
+    return append(member.key(), &member);
+}
+
+Command &Command::beginObject(std::string_view key)
+{
+    return append(key, BeginObject{});
+}
+
+Command &Command::endObject()
+{
+    return append({}, EndObject{});
+}
+
+std::string_view Command::name() const noexcept
+{
+    return m_name;
+}
+
+void Command::writeTo(std::string &buffer, std::uint64_t customTag) const
+{
+    buffer.append("{\"command\":");
+    appendString(buffer, m_name);
+
+    bool firstInObject = false;
+    for (std::size_t i = 0; i < m_size; ++i)
+    {
+        const auto &member = m_members[i];
+        if (std::holds_alternative<EndObject>(member.value))
+        {
+            buffer.push_back('}');
+            firstInObject = false;
+            continue;
+        }
+
+        if (!firstInObject)
+        {
+            buffer.push_back(',');
+        }
+        firstInObject = false;
+
+        if (const auto *prerendered = std::get_if<const PrerenderedMember *>(&member.value))
+        {
+            buffer.append((*prerendered)->rendered());
+            continue;
+        }
+
+        appendString(buffer, member.key);
+        buffer.push_back(':');
+        if (const auto *string = std::get_if<std::string_view>(&member.value))
+        {
+            appendString(buffer, *string);
+        }
+        else if (const auto *boolean = std::get_if<bool>(&member.value))
+        {
+            buffer.append(*boolean ? "true" : "false");
+        }
+        else if (const auto *integer = std::get_if<std::int64_t>(&member.value))
+        {
+            appendInteger(buffer, *integer);
+        }
+        else if (const auto *number = std::get_if<double>(&member.value))
+        {
+            appendDouble(buffer, *number);
+        }
+        else if (const auto *strings = std::get_if<const std::vector<std::string> *>(&member.value))
+        {
+            buffer.push_back('[');
+            for (std::size_t j = 0; j < (*strings)->size(); ++j)
+            {
+                if (j > 0)
+                {
+                    buffer.push_back(',');
+                }
+                appendString(buffer, (**strings)[j]);
+            }
+            buffer.push_back(']');
+        }
+        else if (const auto *integers = std::get_if<const std::vector<int> *>(&member.value))
+        {
+            buffer.push_back('[');
+            for (std::size_t j = 0; j < (*integers)->size(); ++j)
+            {
+                if (j > 0)
+                {
+                    buffer.push_back(',');
+                }
+                appendInteger(buffer, (**integers)[j]);
+            }
+            buffer.push_back(']');
+        }
+        else if (std::holds_alternative<BeginObject>(member.value))
+        {
+            buffer.push_back('{');
+            firstInObject = true;
+        }
+    }
+
+    if (customTag != 0)
+    {
+        buffer.append(",\"customTag\":\"");
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), customTag);
+        buffer.append(digits, result.ptr);
+        buffer.push_back('"');
+    }
+    buffer.push_back('}');
+}
+
+boost::json::object Command::toJson() const
+{
+    boost::json::object result;
+    result["command"] = m_name;
+
+    std::array<boost::json::object *, maxMembers + 1> objects{};
+    std::size_t depth = 0;
+    objects[depth] = &result;
+
+    for (std::size_t i = 0; i < m_size; ++i)
+    {
+        const auto &member = m_members[i];
+        auto &current = *objects[depth];
+        if (std::holds_alternative<EndObject>(member.value))
+        {
+            if (depth > 0)
+            {
+                --depth;
+            }
+        }
+        else if (std::holds_alternative<BeginObject>(member.value))
+        {
+            objects[++depth] = &current[member.key].emplace_object();
+        }
+        else if (const auto *prerendered = std::get_if<const PrerenderedMember *>(&member.value))
+        {
+            current[(*prerendered)->key()] = (*prerendered)->value();
+        }
+        else if (const auto *string = std::get_if<std::string_view>(&member.value))
+        {
+            current[member.key] = *string;
+        }
+        else if (const auto *boolean = std::get_if<bool>(&member.value))
+        {
+            current[member.key] = *boolean;
+        }
+        else if (const auto *integer = std::get_if<std::int64_t>(&member.value))
+        {
+            current[member.key] = *integer;
+        }
+        else if (const auto *number = std::get_if<double>(&member.value))
+        {
+            current[member.key] = *number;
+        }
+        else if (const auto *strings = std::get_if<const std::vector<std::string> *>(&member.value))
+        {
+            current[member.key] = boost::json::array((*strings)->begin(), (*strings)->end());
+        }
+        else if (const auto *integers = std::get_if<const std::vector<int> *>(&member.value))
+        {
+            current[member.key] = boost::json::array((*integers)->begin(), (*integers)->end());
+        }
+    }
+    return result;
+}
+
+Command::operator boost::json::object() const
+{
+    return toJson();
+}
+
+Command &Command::append(std::string_view key, Value value)
+{
+    if (m_size == m_members.size())
+    {
+        throw std::length_error("Too many members in command " + std::string(m_name));
+    }
+    m_members[m_size++] = Member{key, value};
+    return *this;
+}
+
+} // namespace internals
+} // namespace xapi
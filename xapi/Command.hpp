@@ -0,0 +1,164 @@
+#pragma once
+
+/**
+ * @file Command.hpp
+ * @brief Defines the Command class describing a request sent to xAPI.
+ *
+ * This file contains the definition of the Command class, which describes a command
+ * without building a JSON object tree, and renders it straight into a write buffer.
+ */
+
+#include <boost/json.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace xapi
+{
+namespace internals
+{
+
+/**
+ * @class PrerenderedMember
+ * @brief JSON member rendered once and copied verbatim into every command that uses it.
+ *
+ * Used for values that stay the same for the whole session, like streamSessionId.
+ */
+class PrerenderedMember final
+{
+  public:
+    /**
+     * @brief Constructs a new PrerenderedMember object.
+     * @param key The member name.
+     * @param value The member string value.
+     */
+    PrerenderedMember(std::string_view key, std::string_view value);
+
+    std::string_view key() const noexcept;
+
+    std::string_view value() const noexcept;
+
+    /**
+     * @brief Gets the rendered member, for example `"streamSessionId":"abc"`.
+     * @return The rendered member.
+     */
+    std::string_view rendered() const noexcept;
+
+  private:
+    std::string m_key;
+    std::string m_value;
+    std::string m_rendered;
+};
+
+/**
+ * @class Command
+ * @brief Describes a command as a flat list of members, without allocating.
+ *
+ * Strings and arrays are referenced, not copied, so they must outlive the Command.
+ * Members are rendered in the order they were added, nested objects are opened with
+ * beginObject() and closed with endObject().
+ */
+class Command final
+{
+  public:
+    // Maximum number of members, including nested object markers.
+    static constexpr std::size_t maxMembers = 24;
+
+    /**
+     * @brief Constructs a new Command object.
+     * @param name The command name, rendered as the `command` member.
+     */
+    explicit Command(std::string_view name);
+
+    Command &add(std::string_view key, std::string_view value);
+
+    Command &add(std::string_view key, const char *value);
+
+    Command &add(std::string_view key, const std::string &value);
+
+    Command &add(std::string_view key, bool value);
+
+    Command &add(std::string_view key, int value);
+
+    Command &add(std::string_view key, std::int64_t value);
+
+    Command &add(std::string_view key, double value);
+
+    Command &add(std::string_view key, const std::vector<std::string> &values);
+
+    Command &add(std::string_view key, const std::vector<int> &values);
+
+    Command &add(const PrerenderedMember &member);
+
+    /**
+     * @brief Opens a nested object, members added until endObject() belong to it.
+     * @param key The nested object name.
+     * @return Reference to this command.
+     */
+    Command &beginObject(std::string_view key);
+
+    /**
+     * @brief Closes the most recently opened nested object.
+     * @return Reference to this command.
+     */
+    Command &endObject();
+
+    /**
+     * @brief Gets the command name.
+     * @return The command name.
+     */
+    std::string_view name() const noexcept;
+
+    /**
+     * @brief Renders the command as JSON, appending it to the buffer.
+     * @param buffer The buffer to append to.
+     * @param customTag If not zero, rendered as the `customTag` member.
+     */
+    void writeTo(std::string &buffer, std::uint64_t customTag = 0) const;
+
+    /**
+     * @brief Builds the equivalent JSON object.
+     * @return The command as boost::json::object.
+     */
+    boost::json::object toJson() const;
+
+    operator boost::json::object() const;
+
+  private:
+    struct BeginObject
+    {
+    };
+
+    struct EndObject
+    {
+    };
+
+    using Value = std::variant<std::string_view, bool, std::int64_t, double, const std::vector<std::string> *,
+                               const std::vector<int> *, const PrerenderedMember *, BeginObject, EndObject>;
+
+    struct Member
+    {
+        std::string_view key;
+        Value value;
+    };
+
+    /**
+     * @brief Appends a member.
+     * @param key The member name.
+     * @param value The member value.
+     * @return Reference to this command.
+     * @throw std::length_error if the command has more than maxMembers members.
+     */
+    Command &append(std::string_view key, Value value);
+
+    std::string_view m_name;
+    std::array<Member, maxMembers> m_members;
+    std::size_t m_size;
+};
+
+} // namespace internals
+} // namespace xapi
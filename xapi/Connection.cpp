@@ -1,31 +1,68 @@
 #include "Connection.hpp"
 #include "Exceptions.hpp"
+#include <charconv>
 
 namespace xapi
 {
 namespace internals
 {
 
-Connection::Connection(boost::asio::io_context &ioContext)
-    : m_ioContext(ioContext), m_sslContext(boost::asio::ssl::context::tlsv13_client),
-      m_websocket(m_ioContext, m_sslContext), m_cancellationSignal(),
-      m_lastRequestTime(std::chrono::system_clock::now()), m_requestTimeout(200), m_websocketDefaultPort("443")
+Connection::Connection(boost::asio::io_context &ioContext, std::shared_ptr<RateLimiter> rateLimiter,
+                       std::shared_ptr<TlsContext> tlsContext, std::shared_ptr<MetricsRecorder> metrics)
+    : Connection(boost::asio::make_strand(ioContext), std::move(rateLimiter), std::move(tlsContext), std::move(metrics))
+{
+}
+
+Connection::Connection(Strand strand, std::shared_ptr<RateLimiter> rateLimiter, std::shared_ptr<TlsContext> tlsContext,
+                       std::shared_ptr<MetricsRecorder> metrics)
+    : m_strand(std::move(strand)), m_tlsContext(tlsContext ? std::move(tlsContext) : std::make_shared<TlsContext>()),
+      m_websocket(m_strand, m_tlsContext->context()), m_readBuffer(), m_parser(), m_arenaBuffer(), m_arena(),
+      m_rateLimiter(rateLimiter ? std::move(rateLimiter) : std::make_shared<RateLimiter>()),
+      m_metrics(std::move(metrics)),
+      m_recorder(),
+      m_websocketDefaultPort("443"),
+      m_nextTag(1), m_tasks(std::make_shared<TaskState>(m_strand))
 {
 }
 
 Connection::Connection(Connection &&other) noexcept
-    : m_ioContext(other.m_ioContext),
-      m_sslContext(std::move(other.m_sslContext)),
+    : m_strand(other.m_strand),
+      m_tlsContext(std::move(other.m_tlsContext)),
       m_websocket(std::move(other.m_websocket)),
-      m_lastRequestTime(std::move(other.m_lastRequestTime)),
-      m_requestTimeout(other.m_requestTimeout),
-      m_websocketDefaultPort(std::move(other.m_websocketDefaultPort))
+      m_readBuffer(std::move(other.m_readBuffer)),
+      m_parser(),
+      m_arenaBuffer(std::move(other.m_arenaBuffer)),
+      m_arena(std::move(other.m_arena)),
+      m_writeBuffer(std::move(other.m_writeBuffer)),
+      m_rateLimiter(std::move(other.m_rateLimiter)),
+      m_metrics(std::move(other.m_metrics)),
+      m_recorder(std::move(other.m_recorder)),
+      m_websocketDefaultPort(std::move(other.m_websocketDefaultPort)),
+      m_nextTag(other.m_nextTag),
+      m_tasks(std::move(other.m_tasks))
 {
 }
 
 Connection::~Connection()
 {
-    cancelAsyncOperations();
+    if (!m_tasks)
+    {
+        // Moved from
+        return;
+    }
+
+    // The coroutines still suspended resume after this, they find the connection destroyed and stop
+    m_tasks->alive = false;
+    if (m_tasks->hasActiveTasks() || m_tasks->writeInProgress)
+    {
+        cancelAsyncOperations();
+        m_tasks->failPendingRequests(std::make_exception_ptr(exception::ConnectionClosed("Connection destroyed")));
+    }
+}
+
+const Connection::Strand &Connection::executor() const noexcept
+{
+    return m_strand;
 }
 
 boost::asio::awaitable<void> Connection::connect(const boost::url &url)
@@ -34,8 +71,8 @@ boost::asio::awaitable<void> Connection::connect(const boost::url &url)
     try
     {
         boost::asio::ip::tcp::resolver resolver(executor);
-        auto const results =
-            co_await resolver.async_resolve(url.host(), m_websocketDefaultPort, boost::asio::use_awaitable);
+        const std::string port = url.has_port() ? std::string(url.port()) : m_websocketDefaultPort;
+        auto const results = co_await resolver.async_resolve(url.host(), port, boost::asio::use_awaitable);
 
         co_await establishSSLConnection(results, url.host().c_str());
 
@@ -45,7 +82,8 @@ boost::asio::awaitable<void> Connection::connect(const boost::url &url)
         co_await m_websocket.async_handshake(url.host(), url.path(), boost::asio::use_awaitable);
 
         // Start sending periodic ping messages to keep the connection alive
-        boost::asio::co_spawn(executor, startKeepAlive(m_cancellationSignal.slot()), boost::asio::detached);
+        m_tasks->keepAliveActive = true;
+        boost::asio::co_spawn(m_strand, startKeepAlive(m_tasks), boost::asio::detached);
     }
     catch (const boost::system::system_error &e)
     {
@@ -68,6 +106,7 @@ boost::asio::awaitable<void> Connection::establishSSLConnection(
             boost::beast::error_code ec(static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category());
             throw boost::beast::system_error{ec};
         }
+        m_tlsContext->resumeSession(sslStream.native_handle(), host);
         co_await sslStream.async_handshake(boost::asio::ssl::stream_base::client, boost::asio::use_awaitable);
         tcpStream.expires_never();
     }
@@ -77,6 +116,11 @@ boost::asio::awaitable<void> Connection::establishSSLConnection(
     }
 }
 
+bool Connection::isSessionResumed()
+{
+    return SSL_session_reused(m_websocket.next_layer().native_handle()) == 1;
+}
+
 boost::asio::awaitable<void> Connection::disconnect()
 {
     cancelAsyncOperations();
@@ -84,71 +128,240 @@ boost::asio::awaitable<void> Connection::disconnect()
     {
         co_await m_websocket.async_close(boost::beast::websocket::close_code::normal, boost::asio::use_awaitable);
     }
-    catch (const boost::system::system_error &e)
+    catch (const boost::system::system_error &)
+    {
+        // operation_aborted or eof is expected when the connection is closed by remote peer
+    }
+
+    // The reader, the keep-alive task and the failed requests still resume on the connection
+    while (m_tasks->hasActiveTasks())
+    {
+        boost::system::error_code ec;
+        co_await m_tasks->tasksDoneSignal.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    }
+};
+
+template <typename Render>
+boost::asio::awaitable<void> Connection::writeMessage(Render render, MetricsRecorder::Clock::time_point *writeStart)
+{
+    // The connection may be destroyed while this coroutine is suspended
+    const auto tasks = m_tasks;
+    const auto rateLimiter = m_rateLimiter;
+
+    // Concurrent callers queue up here, a WebSocket allows only one write at a time
+    co_await acquireWriteSlot(tasks);
+
+    try
     {
-        if (e.code() == boost::asio::error::operation_aborted || e.code() == boost::asio::error::eof)
+        co_await rateLimiter->acquire();
+        tasks->throwIfDestroyed();
+        if (writeStart)
         {
-            // operation_aborted or eof is expected when the connection is closed by remote peer
-            co_return;
+            *writeStart = MetricsRecorder::Clock::now();
+        }
+
+        m_writeBuffer.clear();
+        render(m_writeBuffer);
+        co_await m_websocket.async_write(boost::asio::buffer(m_writeBuffer), boost::asio::use_awaitable);
+        tasks->throwIfDestroyed();
+        if (m_metrics)
+        {
+            m_metrics->recordSent(m_writeBuffer.size());
         }
     }
-};
+    catch (const boost::system::system_error &e)
+    {
+        tasks->releaseWriteSlot();
+        tasks->throwIfDestroyed();
+        throw exception::ConnectionClosed(e.what());
+    }
+    catch (const exception::ConnectionClosed &)
+    {
+        tasks->releaseWriteSlot();
+        throw;
+    }
+    tasks->releaseWriteSlot();
+}
+
+boost::asio::awaitable<void> Connection::makeRequest(const Command &command)
+{
+    co_await writeMessage([&command](std::string &buffer) { command.writeTo(buffer); });
+}
 
 boost::asio::awaitable<void> Connection::makeRequest(const boost::json::object &command)
 {
-    const auto currentTime = std::chrono::system_clock::now();
-    const auto duration = currentTime - m_lastRequestTime;
-    if (duration < m_requestTimeout)
+    co_await writeMessage([&command](std::string &buffer) { buffer = boost::json::serialize(command); });
+}
+
+boost::asio::awaitable<boost::json::object> Connection::request(const Command &command)
+{
+    // The connection may be destroyed while this coroutine is suspended
+    const auto tasks = m_tasks;
+    const std::uint64_t tag = m_nextTag++;
+    auto pending = std::make_shared<PendingRequest>(m_strand);
+    tasks->pendingRequests.emplace(tag, pending);
+    ++tasks->requestsInFlight;
+
+    const auto queuedAt = MetricsRecorder::Clock::now();
+    auto writeStart = queuedAt;
+    try
+    {
+        co_await writeMessage([&command, tag](std::string &buffer) { command.writeTo(buffer, tag); }, &writeStart);
+    }
+    catch (...)
     {
-        boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor);
-        timer.expires_after(m_requestTimeout - duration);
-        co_await timer.async_wait(boost::asio::use_awaitable);
+        tasks->pendingRequests.erase(tag);
+        pending->error = std::current_exception();
+        pending->completed = true;
     }
 
-    try
+    if (!pending->completed && !tasks->readerActive)
     {
-        const std::string message = boost::json::serialize(command);
-        co_await m_websocket.async_write(boost::asio::buffer(message), boost::asio::use_awaitable);
-        m_lastRequestTime = std::chrono::system_clock::now();
+        tasks->readerActive = true;
+        boost::asio::co_spawn(m_strand, readResponses(tasks), boost::asio::detached);
     }
-    catch (const boost::system::system_error &e)
+
+    if (!pending->completed)
     {
-        throw exception::ConnectionClosed(e.what());
+        // The reader cancels the signal when the response arrives, operation_aborted is expected
+        boost::system::error_code ec;
+        co_await pending->signal.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
     }
+
+    // A response completed right before the connection was destroyed leaves no error
+    if (tasks->alive && !pending->error && m_metrics)
+    {
+        m_metrics->recordRequest(command.name(), writeStart - queuedAt, pending->receivedAt - writeStart,
+                                 pending->parseTime);
+    }
+
+    // Last use of the connection, disconnect() may destroy it from here
+    --tasks->requestsInFlight;
+    tasks->notifyTaskFinished();
+    if (pending->error)
+    {
+        std::rethrow_exception(pending->error);
+    }
+    co_return std::move(pending->response);
 }
 
 boost::asio::awaitable<boost::json::object> Connection::waitResponse()
 {
-    boost::beast::flat_buffer buffer;
     try
     {
-        co_await m_websocket.async_read(buffer, boost::asio::use_awaitable);
-        auto dataString = boost::beast::buffers_to_string(buffer.data());
-        buffer.consume(buffer.size());
+        const std::string_view frame = co_await readFrame();
+        co_return parseFrame(frame, true);
+    }
+    catch (const boost::system::system_error &e)
+    {
+        throwReadError(e);
+    }
+}
+
+boost::asio::awaitable<std::string_view> Connection::waitFrame()
+{
+    // Not a coroutine itself, so that reading a frame costs one coroutine frame instead of two
+    return readFrame();
+}
+
+void Connection::throwReadError(const boost::system::system_error &error)
+{
+    if (error.code() == boost::asio::error::eof)
+    {
+        throw exception::ConnectionClosed("Connection closed by remote host");
+    }
+    else
+    {
+        throw exception::ConnectionClosed(error.what());
+    }
+}
 
-        boost::json::object jsonData = boost::json::parse(dataString).as_object();
+void Connection::setArenaParsing(bool enabled)
+{
+    if (!enabled)
+    {
+        m_arena.reset();
+        m_arenaBuffer.reset();
+        return;
+    }
 
-        co_return jsonData;
+    if (!m_arena)
+    {
+        constexpr std::size_t arenaBufferSize = 64 * 1024;
+        m_arenaBuffer = std::make_unique<unsigned char[]>(arenaBufferSize);
+        m_arena = std::make_unique<boost::json::monotonic_resource>(m_arenaBuffer.get(), arenaBufferSize);
+    }
+}
+
+void Connection::setRecorder(std::shared_ptr<SessionRecorder> recorder)
+{
+    m_recorder = std::move(recorder);
+}
+
+boost::asio::awaitable<std::string_view> Connection::readFrame()
+{
+    // The connection may be destroyed while this coroutine is suspended
+    const auto tasks = m_tasks;
+
+    // Drop the previous message, the buffer keeps its capacity
+    m_readBuffer.consume(m_readBuffer.size());
+    try
+    {
+        co_await m_websocket.async_read(m_readBuffer, boost::asio::use_awaitable);
     }
     catch (const boost::system::system_error &e)
     {
-        if (e.code() == boost::asio::error::eof)
-        {
-            throw exception::ConnectionClosed("Connection closed by remote host");
-        }
-        else
-        {
-            throw exception::ConnectionClosed(e.what());
-        }
+        tasks->throwIfDestroyed();
+        throwReadError(e);
+    }
+    tasks->throwIfDestroyed();
+
+    const auto data = m_readBuffer.cdata();
+    const std::string_view frame(static_cast<const char *>(data.data()), data.size());
+    if (m_metrics)
+    {
+        m_metrics->recordReceived(data.size());
+    }
+    if (m_recorder)
+    {
+        m_recorder->record(frame);
+    }
+    co_return frame;
+}
+
+boost::json::object Connection::parseFrame(std::string_view frame, bool intoArena)
+{
+    boost::json::storage_ptr storage;
+    if (intoArena && m_arena)
+    {
+        // Objects returned for the previous message are no longer valid from here
+        m_arena->release();
+        storage = m_arena.get();
+    }
+
+    m_parser.reset(storage);
+    boost::system::error_code ec;
+    m_parser.write(frame.data(), frame.size(), ec);
+    if (!ec)
+    {
+        m_parser.finish(ec);
+    }
+    if (ec)
+    {
+        throw boost::system::system_error(ec);
     }
+
+    boost::json::value message = m_parser.release();
+    return std::move(message.as_object());
 }
 
-boost::asio::awaitable<void> Connection::startKeepAlive(boost::asio::cancellation_slot cancellationSlot)
+boost::asio::awaitable<void> Connection::startKeepAlive(std::shared_ptr<TaskState> tasks)
 {
     const auto executor = co_await boost::asio::this_coro::executor;
     boost::asio::steady_timer pingTimer(executor);
     const auto pingInterval = std::chrono::seconds(20);
 
+    auto cancellationSlot = tasks->cancellationSignal.slot();
     cancellationSlot.assign([&]([[maybe_unused]] boost::asio::cancellation_type type) {
         if (type == boost::asio::cancellation_type::all)
         {
@@ -156,37 +369,169 @@ boost::asio::awaitable<void> Connection::startKeepAlive(boost::asio::cancellatio
         }
     });
 
-    while (true)
+    try
     {
-        try
+        while (tasks->alive)
         {
             pingTimer.expires_after(pingInterval);
             co_await pingTimer.async_wait(boost::asio::use_awaitable);
 
-            if (m_websocket.is_open())
+            if (!tasks->alive || !m_websocket.is_open())
             {
-                co_await m_websocket.async_ping({}, boost::asio::use_awaitable);
+                break;
             }
-            else
+            co_await m_websocket.async_ping({}, boost::asio::use_awaitable);
+        }
+    }
+    catch (const boost::system::system_error &)
+    {
+        // Cancelled by disconnect() or the destructor, or the connection dropped and the reads report it
+    }
+
+    // The handler refers to the timer of this frame
+    cancellationSlot.clear();
+    tasks->keepAliveActive = false;
+    tasks->notifyTaskFinished();
+}
+
+boost::asio::awaitable<void> Connection::acquireWriteSlot(std::shared_ptr<TaskState> tasks)
+{
+    while (tasks->writeInProgress)
+    {
+        // Woken up by releaseWriteSlot() or the destructor, operation_aborted is expected
+        boost::system::error_code ec;
+        co_await tasks->writeSlotSignal.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        tasks->throwIfDestroyed();
+    }
+    tasks->writeInProgress = true;
+}
+
+boost::asio::awaitable<void> Connection::readResponses(std::shared_ptr<TaskState> tasks)
+{
+    try
+    {
+        while (tasks->alive && !tasks->pendingRequests.empty())
+        {
+            boost::json::object response;
+            MetricsRecorder::Clock::time_point receivedAt;
+            try
             {
-                break;
+                const std::string_view frame = co_await readFrame();
+                receivedAt = MetricsRecorder::Clock::now();
+                // Not into the arena, the response outlives the next read of this task
+                response = parseFrame(frame, false);
             }
+            catch (const boost::system::system_error &e)
+            {
+                throwReadError(e);
+            }
+            completeRequest(std::move(response), receivedAt, MetricsRecorder::Clock::now() - receivedAt);
         }
-        catch (const boost::system::system_error &e)
+    }
+    catch (...)
+    {
+        tasks->failPendingRequests(std::current_exception());
+    }
+    tasks->readerActive = false;
+    tasks->notifyTaskFinished();
+}
+
+void Connection::completeRequest(boost::json::object &&response, MetricsRecorder::Clock::time_point receivedAt,
+                                 MetricsRecorder::Clock::duration parseTime)
+{
+    auto &pendingRequests = m_tasks->pendingRequests;
+    auto it = pendingRequests.end();
+    if (const auto *tagValue = response.if_contains("customTag"))
+    {
+        // A tagged response goes to its own request only, unknown tags are dropped
+        if (tagValue->is_string())
         {
-            throw exception::ConnectionClosed(e.what());
+            const auto &tagString = tagValue->get_string();
+            std::uint64_t tag = 0;
+            const auto [ptr, ec] = std::from_chars(tagString.data(), tagString.data() + tagString.size(), tag);
+            if (ec == std::errc() && ptr == tagString.data() + tagString.size())
+            {
+                it = pendingRequests.find(tag);
+            }
         }
+        response.erase("customTag");
     }
+    else
+    {
+        // Untagged responses, for example errors, go to the oldest request
+        it = pendingRequests.begin();
+    }
+
+    if (it == pendingRequests.end())
+    {
+        // Nobody is waiting for this response
+        return;
+    }
+
+    auto pending = std::move(it->second);
+    pendingRequests.erase(it);
+    pending->response = std::move(response);
+    pending->receivedAt = receivedAt;
+    pending->parseTime = parseTime;
+    pending->completed = true;
+    pending->signal.cancel();
 }
 
 void Connection::cancelAsyncOperations() noexcept
 {
-    m_cancellationSignal.emit(boost::asio::cancellation_type::all);
+    m_tasks->cancellationSignal.emit(boost::asio::cancellation_type::all);
+    m_tasks->writeSlotSignal.cancel();
     if (m_websocket.is_open())
     {
         m_websocket.next_layer().next_layer().cancel();
     }
 }
 
+Connection::TaskState::TaskState(const boost::asio::any_io_executor &executor)
+    : alive(true), pendingRequests(), readerActive(false), requestsInFlight(0), keepAliveActive(false),
+      writeInProgress(false), writeSlotSignal(executor, boost::asio::steady_timer::time_point::max()),
+      tasksDoneSignal(executor, boost::asio::steady_timer::time_point::max()), cancellationSignal()
+{
+}
+
+void Connection::TaskState::throwIfDestroyed() const
+{
+    if (!alive)
+    {
+        throw exception::ConnectionClosed("Connection destroyed");
+    }
+}
+
+bool Connection::TaskState::hasActiveTasks() const noexcept
+{
+    return readerActive || keepAliveActive || requestsInFlight > 0;
+}
+
+void Connection::TaskState::notifyTaskFinished() noexcept
+{
+    if (!hasActiveTasks())
+    {
+        tasksDoneSignal.cancel();
+    }
+}
+
+void Connection::TaskState::failPendingRequests(const std::exception_ptr &error)
+{
+    auto requests = std::move(pendingRequests);
+    pendingRequests.clear();
+    for (auto &[tag, pending] : requests)
+    {
+        pending->error = error;
+        pending->completed = true;
+        pending->signal.cancel();
+    }
+}
+
+void Connection::TaskState::releaseWriteSlot() noexcept
+{
+    writeInProgress = false;
+    writeSlotSignal.cancel_one();
+}
+
 } // namespace internals
 } // namespace xapi
@@ -9,10 +9,19 @@
  */
 
 #include "IConnection.hpp"
+#include "Metrics.hpp"
+#include "RateLimiter.hpp"
+#include "SessionRecorder.hpp"
+#include "TlsContext.hpp"
 #include <boost/beast.hpp>
 #include <boost/beast/websocket/ssl.hpp>
 #include <chrono>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 
 namespace xapi
 {
@@ -25,10 +34,21 @@ namespace internals
  *
  * The Connection class encapsulates the functionality for establishing an SSL connection,
  * sending requests, and receiving responses.
+ *
+ * The keep-alive and response reader tasks of a connection run on its strand. When the IO
+ * context is run by several threads, the connection must only be called from coroutines running
+ * on executor(), XStationClient and XStationClientStream move their calls there.
+ *
+ * Before destroying a connection, co_await disconnect() on its strand. A connection destroyed
+ * while its coroutines are suspended cancels them and fails the pending requests with
+ * xapi::exception::ConnectionClosed. The coroutines still resume later on the strand, they find
+ * the connection destroyed in the task state they share with it and finish without using it.
  */
-class Connection : public IConnection
+class Connection final : public IConnection
 {
   public:
+    using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+
     Connection() = delete;
 
     Connection(const Connection &other) = delete;
@@ -39,16 +59,43 @@ class Connection : public IConnection
     Connection &operator=(Connection &&other) = delete;
 
     /**
-     * @brief Constructs a new Connection object.
+     * @brief Constructs a new Connection object running on a new strand of the IO context.
      * @param ioContext The IO context for asynchronous operations.
+     * @param rateLimiter Rate limiter for outgoing requests, can be shared with other connections.
+     * If null, the connection uses its own limiter with default parameters.
+     * @param tlsContext TLS context with the session cache, can be shared with other connections.
+     * If null, the connection uses its own context.
+     * @param metrics Recorder of request latencies and traffic, if null nothing is recorded.
+     */
+    explicit Connection(boost::asio::io_context &ioContext, std::shared_ptr<RateLimiter> rateLimiter = nullptr,
+                        std::shared_ptr<TlsContext> tlsContext = nullptr,
+                        std::shared_ptr<MetricsRecorder> metrics = nullptr);
+
+    /**
+     * @brief Constructs a new Connection object running on the given strand.
+     *
+     * Connections that replace each other, for example after a reconnect, can share one strand,
+     * so that their users keep running on the same executor.
+     * @param strand The strand serializing the operations of the connection.
+     * @param rateLimiter Rate limiter for outgoing requests, can be shared with other connections.
+     * @param tlsContext TLS context with the session cache, can be shared with other connections.
+     * @param metrics Recorder of request latencies and traffic, if null nothing is recorded.
      */
-    explicit Connection(boost::asio::io_context &ioContext);
+    explicit Connection(Strand strand, std::shared_ptr<RateLimiter> rateLimiter = nullptr,
+                        std::shared_ptr<TlsContext> tlsContext = nullptr,
+                        std::shared_ptr<MetricsRecorder> metrics = nullptr);
 
     virtual ~Connection() override;
 
+    /**
+     * @brief Gets the strand the operations of the connection run on.
+     * @return The strand.
+     */
+    const Strand &executor() const noexcept;
+
     /**
      * @brief Asynchronously establishes secure WebSocket connection to the server.
-     * @param url The URL to connect to.
+     * @param url The URL to connect to, port 443 is used if the URL has none.
      * @return An awaitable void.
      * @throw xapi::exception::ConnectionClosed if the connection fails.
      */
@@ -56,17 +103,29 @@ class Connection : public IConnection
 
     /**
      * @brief Asynchronously disconnects from the server.
+     *
+     * Pending requests fail, and the call returns once the reader, the keep-alive task and the
+     * requests in flight have finished, so the connection can be destroyed afterwards.
      * @return An awaitable void.
      */
     boost::asio::awaitable<void> disconnect() override;
 
+    /**
+     * @brief Makes an asynchronous request to the server.
+     * The command is rendered straight into the connection write buffer.
+     * @param command The command to send.
+     * @return An awaitable void.
+     * @throw xapi::exception::ConnectionClosed if the request fails.
+     */
+    boost::asio::awaitable<void> makeRequest(const Command &command) override;
+
     /**
      * @brief Makes an asynchronous request to the server.
      * @param command The command to send as a JSON value.
      * @return An awaitable void.
      * @throw xapi::exception::ConnectionClosed if the request fails.
      */
-    boost::asio::awaitable<void> makeRequest(const boost::json::object &command) override;
+    boost::asio::awaitable<void> makeRequest(const boost::json::object &command);
 
     /**
      * @brief Waits for a response from the server.
@@ -75,9 +134,137 @@ class Connection : public IConnection
      */
     boost::asio::awaitable<boost::json::object> waitResponse() override;
 
+    /**
+     * @brief Waits for a message from the server without parsing it.
+     * @return An awaitable view of the raw message, valid until the next message is read.
+     * @throw xapi::exception::ConnectionClosed if the read fails.
+     */
+    boost::asio::awaitable<std::string_view> waitFrame() override;
+
+    /**
+     * @brief Sends a request tagged with a unique customTag and waits for the matching response.
+     *
+     * Responses are read by a single reader task and routed to the waiting caller by customTag,
+     * so several requests can be in flight on the same connection at once.
+     * Do not mix with direct waitResponse() calls on the same connection.
+     * @param command The command to send.
+     * @return An awaitable boost::json::object with response from the server.
+     * @throw xapi::exception::ConnectionClosed if the request or the response fails.
+     */
+    boost::asio::awaitable<boost::json::object> request(const Command &command) override;
+
+    /**
+     * @brief Enables or disables parsing of responses into a per-connection arena.
+     *
+     * When enabled, the objects returned by waitResponse() are allocated in a monotonic arena that
+     * is reset on every message, so they are only valid until the next message is read. To keep
+     * one longer, copy it into the default storage, for example
+     * boost::json::object(object, boost::json::storage_ptr()): a plain copy shares the arena of the
+     * original. Responses returned by request() use the default storage: the reader task goes on
+     * reading while the caller resumes.
+     * @param enabled true/false to enable/disable arena parsing.
+     */
+    void setArenaParsing(bool enabled);
+
+    /**
+     * @brief Checks whether the last connect resumed a cached TLS session.
+     * @return True if the TLS handshake was abbreviated.
+     */
+    bool isSessionResumed();
+
+    /**
+     * @brief Sets the recorder receiving every message read from the server.
+     * @param recorder The journal recorder, null to stop recording.
+     */
+    void setRecorder(std::shared_ptr<SessionRecorder> recorder);
+
   private:
-    // The IO context for asynchronous operations.
-    boost::asio::io_context &m_ioContext;
+    /**
+     * @brief State of a request waiting for its response.
+     */
+    struct PendingRequest
+    {
+        explicit PendingRequest(const boost::asio::any_io_executor &executor)
+            : signal(executor, boost::asio::steady_timer::time_point::max())
+        {
+        }
+
+        // Cancelled by the reader task once the response (or an error) is available.
+        boost::asio::steady_timer signal;
+        boost::json::object response;
+        std::exception_ptr error;
+        bool completed = false;
+
+        // When the response was received and how long it took to parse, for the metrics.
+        MetricsRecorder::Clock::time_point receivedAt;
+        MetricsRecorder::Clock::duration parseTime{};
+    };
+
+    /**
+     * @brief State shared by the connection and its coroutines, which can outlive it.
+     */
+    struct TaskState
+    {
+        explicit TaskState(const boost::asio::any_io_executor &executor);
+
+        /**
+         * @brief Makes a coroutine resumed after the connection was destroyed stop.
+         * @throw xapi::exception::ConnectionClosed if the connection was destroyed.
+         */
+        void throwIfDestroyed() const;
+
+        /**
+         * @brief Checks whether a coroutine of the connection still uses it.
+         * @return True while the reader, the keep-alive task or a request is running.
+         */
+        bool hasActiveTasks() const noexcept;
+
+        /**
+         * @brief Wakes up disconnect() once the last coroutine using the connection has finished.
+         */
+        void notifyTaskFinished() noexcept;
+
+        /**
+         * @brief Completes all pending requests with the given error.
+         * @param error The exception to rethrow in every waiting caller.
+         */
+        void failPendingRequests(const std::exception_ptr &error);
+
+        /**
+         * @brief Releases the write slot and wakes up one waiting writer.
+         */
+        void releaseWriteSlot() noexcept;
+
+        // False once the connection is destroyed.
+        bool alive;
+
+        // Requests waiting for their responses, keyed by customTag. Lowest tag is the oldest request.
+        std::map<std::uint64_t, std::shared_ptr<PendingRequest>> pendingRequests;
+
+        // True while the reader task is running.
+        bool readerActive;
+
+        // Number of request() calls that have not returned yet.
+        std::size_t requestsInFlight;
+
+        // True while the keep-alive task is running.
+        bool keepAliveActive;
+
+        // True while a coroutine writes to the WebSocket.
+        bool writeInProgress;
+
+        // Wakes up coroutines waiting for the write slot.
+        boost::asio::steady_timer writeSlotSignal;
+
+        // Wakes up disconnect() waiting for the coroutines using the connection.
+        boost::asio::steady_timer tasksDoneSignal;
+
+        // Cancellation signal for stopping the keep-alive coroutine.
+        boost::asio::cancellation_signal cancellationSignal;
+    };
+
+    // Serializes the operations of the connection, declared first as the other members use it.
+    Strand m_strand;
 
     /**
      * @brief Establishes an SSL connection asynchronously.
@@ -90,12 +277,11 @@ class Connection : public IConnection
                                                         const char *host);
 
     /**
-     * @brief Starts the keep-alive coroutine.
-     * @param cancellationSlot The cancellation slot for stopping the coroutine.
+     * @brief Starts the keep-alive coroutine, it returns when cancelled or when a ping fails.
+     * @param tasks The task state of the connection, stopping the coroutine through its cancellation signal.
      * @return An awaitable void.
-     * @throw xapi::exception::ConnectionClosed if the ping fails.
      */
-    boost::asio::awaitable<void> startKeepAlive(boost::asio::cancellation_slot cancellationSlot);
+    boost::asio::awaitable<void> startKeepAlive(std::shared_ptr<TaskState> tasks);
 
     /**
      * @brief Cancels all pending asynchronous operations and stops the keep-alive coroutine.
@@ -103,23 +289,104 @@ class Connection : public IConnection
      */
     void cancelAsyncOperations() noexcept;
 
-    // SSL context, stores certificates.
-    boost::asio::ssl::context m_sslContext;
+    /**
+     * @brief Reads the next message into the persistent read buffer.
+     * @return An awaitable view of the message, valid until the next read.
+     * @throw xapi::exception::ConnectionClosed if the read fails.
+     */
+    boost::asio::awaitable<std::string_view> readFrame();
+
+    /**
+     * @brief Converts a read error to xapi::exception::ConnectionClosed.
+     * @param error The error reported by the WebSocket.
+     * @throw xapi::exception::ConnectionClosed always.
+     */
+    [[noreturn]] static void throwReadError(const boost::system::system_error &error);
+
+    /**
+     * @brief Parses a message with the reusable parser.
+     * @param frame The message to parse.
+     * @param intoArena Parse into the arena if it is enabled, otherwise the default storage is used.
+     * @return The parsed JSON object.
+     * @throw boost::system::system_error if the message is not valid JSON.
+     */
+    boost::json::object parseFrame(std::string_view frame, bool intoArena);
+
+    /**
+     * @brief Renders the message with the given function into the write buffer and sends it.
+     * @param render Appends the message to the write buffer.
+     * @param writeStart If not null, set to the time the write started, after the rate limiter.
+     * @return An awaitable void.
+     * @throw xapi::exception::ConnectionClosed if the write fails.
+     */
+    template <typename Render>
+    boost::asio::awaitable<void> writeMessage(Render render, MetricsRecorder::Clock::time_point *writeStart = nullptr);
+
+    /**
+     * @brief Waits until no other coroutine is writing to the WebSocket and takes the write slot.
+     * @param tasks The task state of the connection.
+     * @return An awaitable void.
+     * @throw xapi::exception::ConnectionClosed if the connection is destroyed meanwhile.
+     */
+    static boost::asio::awaitable<void> acquireWriteSlot(std::shared_ptr<TaskState> tasks);
+
+    /**
+     * @brief Reads responses and routes them to pending requests until none are left.
+     * @param tasks The task state of the connection.
+     * @return An awaitable void.
+     */
+    boost::asio::awaitable<void> readResponses(std::shared_ptr<TaskState> tasks);
+
+    /**
+     * @brief Completes the pending request the response belongs to.
+     * Untagged responses complete the oldest pending request, as the server answers in order.
+     * Responses with a customTag of no pending request are dropped.
+     * @param response The response received from the server.
+     * @param receivedAt When the response was received.
+     * @param parseTime How long the response took to parse.
+     * @return void.
+     */
+    void completeRequest(boost::json::object &&response, MetricsRecorder::Clock::time_point receivedAt,
+                         MetricsRecorder::Clock::duration parseTime);
+
+    // SSL context and TLS session cache, stores certificates.
+    std::shared_ptr<TlsContext> m_tlsContext;
 
     // The WebSocket stream.
     boost::beast::websocket::stream<boost::asio::ssl::stream<boost::beast::tcp_stream>> m_websocket;
 
-    // Cancellation signal for stopping keepAlive coroutine
-    boost::asio::cancellation_signal m_cancellationSignal;
+    // Read buffer reused for every message, its capacity grows to the largest message received.
+    boost::beast::flat_buffer m_readBuffer;
+
+    // Parser reused for every message, keeps its internal buffers between messages.
+    boost::json::stream_parser m_parser;
+
+    // Initial block of the arena, so that typical messages are parsed without touching the heap.
+    std::unique_ptr<unsigned char[]> m_arenaBuffer;
 
-    // Time of the last request.
-    std::chrono::time_point<std::chrono::system_clock> m_lastRequestTime;
+    // Arena for parsed messages, null if arena parsing is disabled.
+    std::unique_ptr<boost::json::monotonic_resource> m_arena;
 
-    // Timeout for requests.
-    const std::chrono::milliseconds m_requestTimeout;
+    // Write buffer reused for every outgoing message.
+    std::string m_writeBuffer;
+
+    // Paces outgoing requests.
+    std::shared_ptr<RateLimiter> m_rateLimiter;
+
+    // Request latencies and traffic counters, null if not recorded.
+    std::shared_ptr<MetricsRecorder> m_metrics;
+
+    // Journal of received messages, null if not recorded.
+    std::shared_ptr<SessionRecorder> m_recorder;
 
     // Default port for WebSocket connections.
     const std::string m_websocketDefaultPort;
+
+    // Next customTag value to assign.
+    std::uint64_t m_nextTag;
+
+    // Pending requests and state of the coroutines, null in a moved-from connection.
+    std::shared_ptr<TaskState> m_tasks;
 };
 
 } // namespace internals
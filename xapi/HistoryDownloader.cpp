@@ -0,0 +1,224 @@
+#include "HistoryDownloader.hpp"
+#include "ChartParser.hpp"
+#include "Exceptions.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace xapi
+{
+
+HistoryDownloader::HistoryDownloader(std::vector<XStationClient *> sessions, CandleStore &store)
+    : m_sessions(std::move(sessions)), m_store(store), m_chunkCandles(5000), m_maxAttempts(3), m_initialDelay(500),
+      m_progressHandler(), m_queue(), m_results(), m_progress(), m_activeWorkers(0)
+{
+    if (m_sessions.empty() || std::find(m_sessions.begin(), m_sessions.end(), nullptr) != m_sessions.end())
+    {
+        throw std::invalid_argument("HistoryDownloader needs at least one session");
+    }
+}
+
+void HistoryDownloader::setChunkCandles(std::size_t candles)
+{
+    m_chunkCandles = std::max<std::size_t>(candles, 1);
+}
+
+void HistoryDownloader::setRetry(std::size_t maxAttempts, std::chrono::milliseconds initialDelay)
+{
+    m_maxAttempts = std::max<std::size_t>(maxAttempts, 1);
+    m_initialDelay = initialDelay;
+}
+
+void HistoryDownloader::setProgressHandler(ProgressHandler handler)
+{
+    m_progressHandler = std::move(handler);
+}
+
+boost::asio::awaitable<DownloadProgress> HistoryDownloader::run(const std::vector<HistoryJob> &jobs)
+{
+    // The workers and this coroutine share the download state, so they all run on one strand.
+    auto strand = boost::asio::make_strand(co_await boost::asio::this_coro::executor);
+    co_return co_await boost::asio::co_spawn(strand, download(jobs), boost::asio::use_awaitable);
+}
+
+boost::asio::awaitable<DownloadProgress> HistoryDownloader::download(const std::vector<HistoryJob> &jobs)
+{
+    m_queue.clear();
+    m_results.assign(jobs.size(), JobResult());
+    m_progress = DownloadProgress();
+    m_progress.totalJobs = jobs.size();
+
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        const HistoryJob &job = jobs[i];
+        const std::int64_t span = static_cast<std::int64_t>(job.period) * 60'000 *
+                                  static_cast<std::int64_t>(m_chunkCandles);
+        for (const TimeRange &missing : m_store.missing(job.symbol, job.period, job.range))
+        {
+            for (std::int64_t start = missing.start; start < missing.end; start += span)
+            {
+                m_queue.push_back(Chunk{i, TimeRange{start, std::min(start + span, missing.end)}, 0});
+                ++m_results[i].pendingChunks;
+            }
+        }
+        if (m_results[i].pendingChunks == 0)
+        {
+            ++m_progress.completedJobs;
+        }
+    }
+    m_progress.totalChunks = m_queue.size();
+
+    auto executor = co_await boost::asio::this_coro::executor;
+    boost::asio::steady_timer done(executor, boost::asio::steady_timer::time_point::max());
+    std::exception_ptr error;
+
+    m_activeWorkers = m_sessions.size();
+    for (XStationClient *session : m_sessions)
+    {
+        boost::asio::co_spawn(executor, work(*session, jobs), [this, &done, &error](std::exception_ptr e) {
+            if (e && !error)
+            {
+                error = e;
+            }
+            if (--m_activeWorkers == 0)
+            {
+                done.cancel();
+            }
+        });
+    }
+
+    if (m_activeWorkers > 0)
+    {
+        boost::system::error_code ec;
+        co_await done.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    }
+
+    // Left when every session closed, nobody can retry them.
+    while (!m_queue.empty())
+    {
+        const Chunk chunk = m_queue.front();
+        m_queue.pop_front();
+        ++m_progress.failedChunks;
+        finishChunk(chunk, jobs);
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    co_return m_progress;
+}
+
+boost::asio::awaitable<void> HistoryDownloader::work(XStationClient &session, const std::vector<HistoryJob> &jobs)
+{
+    auto executor = co_await boost::asio::this_coro::executor;
+
+    while (!m_queue.empty())
+    {
+        Chunk chunk = m_queue.front();
+        m_queue.pop_front();
+        ++chunk.attempts;
+
+        const HistoryJob &job = jobs[chunk.job];
+
+        // The other sessions add to the job while this one waits, so the chunk is only added once parsed.
+        std::vector<Candle> candles;
+        int digits = 0;
+        bool closed = false;
+        bool failed = false;
+        try
+        {
+            const auto response =
+                co_await session.getChartRangeRequest(job.symbol, chunk.range.start, chunk.range.end, job.period, 0);
+            digits = internals::parseChart(response, candles);
+        }
+        catch (const exception::ConnectionClosed &)
+        {
+            closed = true;
+        }
+        catch (const std::exception &)
+        {
+            failed = true;
+        }
+
+        if (closed || failed)
+        {
+            if (closed)
+            {
+                // The session cannot be used anymore, the other sessions take its chunks.
+                retry(chunk, jobs);
+                co_return;
+            }
+
+            const auto backoff = std::min<std::size_t>(chunk.attempts - 1, 16);
+            boost::asio::steady_timer delay(executor, m_initialDelay * (1 << backoff));
+            co_await delay.async_wait(boost::asio::use_awaitable);
+            retry(chunk, jobs);
+            continue;
+        }
+
+        // The last period before now is not marked as fetched, its candle may still change.
+        const std::int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count();
+        const std::int64_t periodMs = static_cast<std::int64_t>(job.period) * 60'000;
+        JobResult &result = m_results[chunk.job];
+        result.fetched.push_back(TimeRange{chunk.range.start, std::min(chunk.range.end, now - periodMs)});
+        result.candles.insert(result.candles.end(), candles.begin(), candles.end());
+        result.digits = digits;
+
+        m_progress.candles += candles.size();
+        ++m_progress.completedChunks;
+        finishChunk(chunk, jobs);
+    }
+}
+
+void HistoryDownloader::retry(Chunk chunk, const std::vector<HistoryJob> &jobs)
+{
+    if (chunk.attempts < m_maxAttempts)
+    {
+        m_queue.push_back(chunk);
+        return;
+    }
+
+    ++m_progress.failedChunks;
+    finishChunk(chunk, jobs);
+}
+
+void HistoryDownloader::finishChunk(const Chunk &chunk, const std::vector<HistoryJob> &jobs)
+{
+    JobResult &result = m_results[chunk.job];
+    if (--result.pendingChunks == 0)
+    {
+        // Chunks are stitched by the store, which orders the candles and drops duplicates at chunk edges.
+        bool merged = true;
+        if (!result.candles.empty() || !result.fetched.empty())
+        {
+            // A job that cannot be written does not stop the worker, the other jobs go on
+            const HistoryJob &job = jobs[chunk.job];
+            try
+            {
+                m_store.merge(job.symbol, job.period, result.fetched, result.candles, result.digits);
+            }
+            catch (const std::exception &)
+            {
+                merged = false;
+            }
+        }
+        result = JobResult();
+        if (merged)
+        {
+            ++m_progress.completedJobs;
+        }
+        else
+        {
+            ++m_progress.failedJobs;
+        }
+    }
+
+    if (m_progressHandler)
+    {
+        m_progressHandler(m_progress);
+    }
+}
+
+} // namespace xapi
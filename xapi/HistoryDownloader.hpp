@@ -0,0 +1,149 @@
+#pragma once
+
+/**
+ * @file HistoryDownloader.hpp
+ * @brief Defines the HistoryDownloader class fetching chart history over several sessions.
+ *
+ * This file contains the definition of the HistoryDownloader class, which splits chart
+ * downloads into time chunks and fetches them in parallel on a pool of logged-in clients.
+ */
+
+#include "CandleStore.hpp"
+#include "XStationClient.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace xapi
+{
+
+/**
+ * @brief Chart history to download.
+ */
+struct HistoryJob
+{
+    std::string symbol;
+    PeriodCode period = PeriodCode::PERIOD_M1;
+    TimeRange range;
+};
+
+/**
+ * @brief Progress of a download, reported after every chunk.
+ */
+struct DownloadProgress
+{
+    std::size_t totalChunks = 0;
+    std::size_t completedChunks = 0;
+    std::size_t failedChunks = 0;
+    std::size_t totalJobs = 0;
+    std::size_t completedJobs = 0;
+    // Jobs whose candles could not be merged into the store, they are not counted as completed.
+    std::size_t failedJobs = 0;
+    std::size_t candles = 0;
+};
+
+/**
+ * @class HistoryDownloader
+ * @brief Downloads chart history into a CandleStore using several sessions in parallel.
+ *
+ * Each job is reduced to the ranges missing from the store and split into chunks of a fixed
+ * number of candles. Every session takes the next chunk from a shared queue, so the download
+ * scales with the number of sessions, each paced by its own rate limiter. A failed chunk is
+ * put back into the queue for another attempt after a delay; a session whose connection
+ * closed stops taking chunks. The candles of a job are kept until all its chunks are done,
+ * then they are merged into the store in one write. Chunks that failed all attempts are not
+ * marked as fetched, so a later run downloads them again, and so is a job whose merge failed.
+ */
+class HistoryDownloader final
+{
+  public:
+    using ProgressHandler = std::function<void(const DownloadProgress &)>;
+
+    HistoryDownloader() = delete;
+
+    HistoryDownloader(const HistoryDownloader &) = delete;
+    HistoryDownloader &operator=(const HistoryDownloader &) = delete;
+
+    /**
+     * @brief Constructs a new HistoryDownloader object.
+     * @param sessions Logged-in clients, they must outlive the downloader.
+     * @param store The store receiving the candles, must outlive the downloader.
+     * @throw std::invalid_argument if there is no session.
+     */
+    HistoryDownloader(std::vector<XStationClient *> sessions, CandleStore &store);
+
+    /**
+     * @brief Sets the number of candles requested at once, 5000 by default.
+     * @param candles Number of periods covered by one chunk.
+     */
+    void setChunkCandles(std::size_t candles);
+
+    /**
+     * @brief Sets how failed chunks are retried, 3 attempts starting 500 ms apart by default.
+     * @param maxAttempts Number of attempts of a chunk, at least 1.
+     * @param initialDelay Delay before the second attempt, doubled for every further attempt.
+     */
+    void setRetry(std::size_t maxAttempts, std::chrono::milliseconds initialDelay);
+
+    /**
+     * @brief Sets the handler called after every finished or failed chunk.
+     * @param handler The progress handler.
+     */
+    void setProgressHandler(ProgressHandler handler);
+
+    /**
+     * @brief Downloads the jobs, all sessions work until the queue is empty.
+     * @param jobs The history to download.
+     * @return The final progress, jobs that could not be written to the store are counted in failedJobs.
+     */
+    boost::asio::awaitable<DownloadProgress> run(const std::vector<HistoryJob> &jobs);
+
+  private:
+    struct Chunk
+    {
+        std::size_t job;
+        TimeRange range;
+        std::size_t attempts;
+    };
+
+    // Candles of one job, merged into the store when its last chunk is done.
+    struct JobResult
+    {
+        std::vector<Candle> candles;
+        std::vector<TimeRange> fetched;
+        int digits = 0;
+        std::size_t pendingChunks = 0;
+    };
+
+    // Body of run(), executed on a strand together with the workers.
+    boost::asio::awaitable<DownloadProgress> download(const std::vector<HistoryJob> &jobs);
+
+    // Takes chunks from the queue until it is empty or the session is closed.
+    boost::asio::awaitable<void> work(XStationClient &session, const std::vector<HistoryJob> &jobs);
+
+    // Puts a chunk back into the queue, or counts it as failed after the last attempt.
+    void retry(Chunk chunk, const std::vector<HistoryJob> &jobs);
+
+    // Counts a done chunk and merges its job when it was the last one.
+    void finishChunk(const Chunk &chunk, const std::vector<HistoryJob> &jobs);
+
+    std::vector<XStationClient *> m_sessions;
+    CandleStore &m_store;
+
+    std::size_t m_chunkCandles;
+    std::size_t m_maxAttempts;
+    std::chrono::milliseconds m_initialDelay;
+    ProgressHandler m_progressHandler;
+
+    // State of the running download, only touched on the strand of run().
+    std::deque<Chunk> m_queue;
+    std::vector<JobResult> m_results;
+    DownloadProgress m_progress;
+    std::size_t m_activeWorkers;
+};
+
+} // namespace xapi
@@ -5,10 +5,12 @@
  * @brief Declaration of the Connection interface.
  */
 
+#include "Command.hpp"
 #include <boost/asio.hpp>
 #include <boost/asio/cancellation_signal.hpp>
 #include <boost/json.hpp>
 #include <boost/url.hpp>
+#include <string_view>
 
 namespace xapi
 {
@@ -36,11 +38,11 @@ class IConnection
 
     /**
      * @brief Makes an asynchronous request to the server.
-     * @param command The command to send as a JSON value.
+     * @param command The command to send.
      * @return An awaitable void.
      * @throw xapi::exception::ConnectionClosed if the request fails.
      */
-    virtual boost::asio::awaitable<void> makeRequest(const boost::json::object &command) = 0;
+    virtual boost::asio::awaitable<void> makeRequest(const Command &command) = 0;
 
     /**
      * @brief Waits for a response from the server.
@@ -48,6 +50,29 @@ class IConnection
      * @throw xapi::exception::ConnectionClosed if the response fails.
      */
     virtual boost::asio::awaitable<boost::json::object> waitResponse() = 0;
+
+    /**
+     * @brief Waits for a message from the server without parsing it.
+     * @return An awaitable view of the raw message, valid until the next message is read.
+     * @throw xapi::exception::ConnectionClosed if the read fails.
+     */
+    virtual boost::asio::awaitable<std::string_view> waitFrame() = 0;
+
+    /**
+     * @brief Sends a request to the server and waits for the response that belongs to it.
+     *
+     * The default implementation calls makeRequest() and waitResponse() back-to-back,
+     * so only one request can be in flight at a time.
+     * @param command The command to send.
+     * @return An awaitable boost::json::object with response from the server.
+     * @throw xapi::exception::ConnectionClosed if the request fails.
+     */
+    virtual boost::asio::awaitable<boost::json::object> request(const Command &command)
+    {
+        co_await makeRequest(command);
+        auto result = co_await waitResponse();
+        co_return result;
+    }
 };
 
 } // namespace internals
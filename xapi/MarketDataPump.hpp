@@ -0,0 +1,170 @@
+#pragma once
+
+/**
+ * @file MarketDataPump.hpp
+ * @brief Defines the MarketDataPump class publishing ticks and candles into a ring.
+ *
+ * This file contains the definition of the MarketDataPump class, which reads messages from
+ * XStationClientStream on the I/O thread and hands the parsed tick and candle records over
+ * to strategy threads through a SpscRing or a BroadcastRing.
+ */
+
+#include "Exceptions.hpp"
+#include "RingBuffer.hpp"
+#include "StreamDispatcher.hpp"
+#include "StreamRecordParser.hpp"
+#include "StreamRecords.hpp"
+#include "XStationClientStream.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+namespace xapi
+{
+
+/**
+ * @class MarketDataPump
+ * @brief Reads the stream and publishes tick and candle records into a lock-free ring.
+ *
+ * The pump does no work per record beyond parsing and one copy into the ring, so the socket
+ * keeps being drained while consumers on other threads poll the ring. When the ring is full
+ * the record is dropped and counted, the I/O thread never waits for a consumer. Other records
+ * are skipped without being parsed.
+ *
+ * Example: `SpscRing<MarketRecord> ring(4096); MarketDataPump pump(stream, ring);`
+ * @tparam Ring SpscRing<MarketRecord> or BroadcastRing<MarketRecord>.
+ * @tparam Stream XStationClientStream or DirectXStationClientStream.
+ */
+template <typename Ring, typename Stream = XStationClientStream> class MarketDataPump final
+{
+  public:
+    MarketDataPump() = delete;
+
+    MarketDataPump(const MarketDataPump &) = delete;
+    MarketDataPump &operator=(const MarketDataPump &) = delete;
+
+    /**
+     * @brief Constructs a new MarketDataPump object.
+     * @param stream The opened stream to read messages from, must outlive the pump.
+     * @param ring The ring to publish into, must outlive the pump.
+     */
+    MarketDataPump(Stream &stream, Ring &ring)
+        : m_stream(stream), m_ring(ring), m_recordParser(), m_record(), m_published(0), m_dropped(0), m_skipped(0),
+          m_running(false)
+    {
+    }
+
+    /**
+     * @brief Reads and publishes messages until stop() is called or the connection fails.
+     * @return An awaitable void.
+     * @throw xapi::exception::ConnectionClosed if the connection fails or a message is not valid JSON.
+     */
+    boost::asio::awaitable<void> run()
+    {
+        m_running = true;
+        while (m_running)
+        {
+            const std::string_view frame = co_await m_stream.listenRaw();
+            try
+            {
+                publish(frame);
+            }
+            catch (const boost::system::system_error &e)
+            {
+                m_running = false;
+                throw exception::ConnectionClosed(e.what());
+            }
+        }
+    }
+
+    /**
+     * @brief Stops run() after the message being published.
+     */
+    void stop() noexcept
+    {
+        m_running = false;
+    }
+
+    /**
+     * @brief Parses a single message and publishes it if it is a tick or a candle.
+     * @param frame The raw message received from the streaming server.
+     * @return true if a record was pushed into the ring, false if it was skipped or dropped.
+     * @throw boost::system::system_error if the message is not valid JSON.
+     */
+    bool publish(std::string_view frame)
+    {
+        const auto index = internals::StreamRecordParser::recordIndex(StreamDispatcher::scanCommand(frame));
+        if (index != m_tickIndex && index != m_candleIndex)
+        {
+            increment(m_skipped);
+            return false;
+        }
+
+        if (!m_recordParser.parse(frame, m_record))
+        {
+            increment(m_skipped);
+            return false;
+        }
+
+        const bool pushed = std::holds_alternative<TickRecord>(m_record)
+                                ? m_ring.tryPush(MarketRecord(std::get<TickRecord>(m_record)))
+                                : m_ring.tryPush(MarketRecord(std::get<CandleRecord>(m_record)));
+        increment(pushed ? m_published : m_dropped);
+        return pushed;
+    }
+
+    /**
+     * @brief Gets the number of records pushed into the ring, can be read from any thread.
+     * @return Number of published records.
+     */
+    std::uint64_t published() const noexcept
+    {
+        return m_published.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the number of records dropped because the ring was full, can be read from any thread.
+     * @return Number of dropped records.
+     */
+    std::uint64_t dropped() const noexcept
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the number of messages that were not ticks or candles.
+     * @return Number of skipped messages.
+     */
+    std::uint64_t skipped() const noexcept
+    {
+        return m_skipped.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr std::size_t m_tickIndex = 0;
+    static constexpr std::size_t m_candleIndex = 1;
+
+    static_assert(std::is_same_v<std::variant_alternative_t<m_tickIndex, StreamRecord>, TickRecord>);
+    static_assert(std::is_same_v<std::variant_alternative_t<m_candleIndex, StreamRecord>, CandleRecord>);
+
+    // The counters have a single writer, a plain store avoids a locked instruction.
+    static void increment(std::atomic<std::uint64_t> &counter) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    Stream &m_stream;
+    Ring &m_ring;
+
+    internals::StreamRecordParser m_recordParser;
+
+    // Record reused for every message.
+    StreamRecord m_record;
+
+    std::atomic<std::uint64_t> m_published;
+    std::atomic<std::uint64_t> m_dropped;
+    std::atomic<std::uint64_t> m_skipped;
+    bool m_running;
+};
+
+} // namespace xapi
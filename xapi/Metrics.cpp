@@ -0,0 +1,168 @@
+#include "Metrics.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace xapi
+{
+
+void LatencyHistogram::record(std::chrono::nanoseconds value) noexcept
+{
+    const auto micros = std::chrono::duration_cast<Duration>(value).count();
+    const std::uint64_t v = micros > 0 ? static_cast<std::uint64_t>(micros) : 0;
+
+    ++m_counts[bucketIndex(v)];
+    m_min = m_count == 0 ? v : std::min(m_min, v);
+    m_max = std::max(m_max, v);
+    m_sum += v;
+    ++m_count;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) noexcept
+{
+    if (other.m_count == 0)
+    {
+        return;
+    }
+
+    for (std::size_t i = 0; i < m_bucketCount; ++i)
+    {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_min = m_count == 0 ? other.m_min : std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+    m_sum += other.m_sum;
+    m_count += other.m_count;
+}
+
+void LatencyHistogram::reset() noexcept
+{
+    *this = LatencyHistogram();
+}
+
+std::uint64_t LatencyHistogram::count() const noexcept
+{
+    return m_count;
+}
+
+LatencyHistogram::Duration LatencyHistogram::min() const noexcept
+{
+    return Duration(m_min);
+}
+
+LatencyHistogram::Duration LatencyHistogram::max() const noexcept
+{
+    return Duration(m_max);
+}
+
+LatencyHistogram::Duration LatencyHistogram::mean() const noexcept
+{
+    return Duration(m_count == 0 ? 0 : m_sum / m_count);
+}
+
+LatencyHistogram::Duration LatencyHistogram::percentile(double percentile) const noexcept
+{
+    if (m_count == 0)
+    {
+        return Duration(0);
+    }
+
+    const double clamped = std::clamp(percentile, 0.0, 100.0);
+    const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * m_count)));
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < m_bucketCount; ++i)
+    {
+        seen += m_counts[i];
+        if (seen >= rank)
+        {
+            // The last bucket also holds the values above the histogram range.
+            return Duration(i + 1 == m_bucketCount ? m_max : std::clamp(bucketUpperBound(i), m_min, m_max));
+        }
+    }
+    return Duration(m_max);
+}
+
+std::size_t LatencyHistogram::bucketIndex(std::uint64_t value) noexcept
+{
+    if (value < m_subBuckets)
+    {
+        return static_cast<std::size_t>(value);
+    }
+
+    // The top m_subBucketBits + 1 bits of the value select the bucket.
+    const unsigned shift = std::min<unsigned>(std::bit_width(value) - 1 - m_subBucketBits, m_maxShift);
+    const std::uint64_t subBucket = std::min<std::uint64_t>(value >> shift, 2 * m_subBuckets - 1) - m_subBuckets;
+    return static_cast<std::size_t>((shift + 1) * m_subBuckets + subBucket);
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index) noexcept
+{
+    if (index < m_subBuckets)
+    {
+        return index;
+    }
+
+    const std::uint64_t shift = index / m_subBuckets - 1;
+    const std::uint64_t subBucket = index % m_subBuckets;
+    return ((m_subBuckets + subBucket + 1) << shift) - 1;
+}
+
+namespace internals
+{
+
+void MetricsRecorder::recordRequest(std::string_view command, Clock::duration queueWait, Clock::duration roundTrip,
+                                    Clock::duration parse)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_commands.find(command);
+    if (it == m_commands.end())
+    {
+        it = m_commands.emplace(std::string(command), CommandMetrics()).first;
+    }
+    it->second.queueWait.record(queueWait);
+    it->second.roundTrip.record(roundTrip);
+    it->second.parse.record(parse);
+}
+
+void MetricsRecorder::recordSent(std::size_t bytes) noexcept
+{
+    m_messagesSent.fetch_add(1, std::memory_order_relaxed);
+    m_bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void MetricsRecorder::recordReceived(std::size_t bytes) noexcept
+{
+    m_messagesReceived.fetch_add(1, std::memory_order_relaxed);
+    m_bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+MetricsSnapshot MetricsRecorder::snapshot() const
+{
+    MetricsSnapshot snapshot;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        snapshot.commands = m_commands;
+    }
+    snapshot.messagesSent = m_messagesSent.load(std::memory_order_relaxed);
+    snapshot.bytesSent = m_bytesSent.load(std::memory_order_relaxed);
+    snapshot.messagesReceived = m_messagesReceived.load(std::memory_order_relaxed);
+    snapshot.bytesReceived = m_bytesReceived.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void MetricsRecorder::reset()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commands.clear();
+    }
+    m_messagesSent.store(0, std::memory_order_relaxed);
+    m_bytesSent.store(0, std::memory_order_relaxed);
+    m_messagesReceived.store(0, std::memory_order_relaxed);
+    m_bytesReceived.store(0, std::memory_order_relaxed);
+}
+
+} // namespace internals
+} // namespace xapi
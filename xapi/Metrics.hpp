@@ -0,0 +1,163 @@
+#pragma once
+
+/**
+ * @file Metrics.hpp
+ * @brief Defines the latency histogram and the request metrics of a client.
+ *
+ * This file contains the definition of the LatencyHistogram class, the metrics snapshot
+ * returned by XStationClient::metrics() and the MetricsRecorder class filling it.
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace xapi
+{
+
+/**
+ * @class LatencyHistogram
+ * @brief HDR-style histogram of durations with microsecond resolution.
+ *
+ * Values are counted in log-linear buckets, 16 per power of two, so every recorded value is
+ * kept with a relative error below 1/16, from 1 microsecond up to about 19 hours.
+ * Recording is constant time and does not allocate.
+ */
+class LatencyHistogram final
+{
+  public:
+    using Duration = std::chrono::microseconds;
+
+    /**
+     * @brief Records a duration, negative durations are recorded as zero.
+     * @param value The duration.
+     */
+    void record(std::chrono::nanoseconds value) noexcept;
+
+    /**
+     * @brief Adds the values recorded by another histogram.
+     * @param other The histogram to add.
+     */
+    void merge(const LatencyHistogram &other) noexcept;
+
+    void reset() noexcept;
+
+    std::uint64_t count() const noexcept;
+
+    Duration min() const noexcept;
+
+    Duration max() const noexcept;
+
+    Duration mean() const noexcept;
+
+    /**
+     * @brief Gets the value below which the given percentage of recorded values falls.
+     * @param percentile The percentile, from 0.0 to 100.0.
+     * @return The highest value equivalent to the percentile bucket, zero if nothing was recorded.
+     */
+    Duration percentile(double percentile) const noexcept;
+
+  private:
+    static constexpr unsigned m_subBucketBits = 4;
+    static constexpr std::uint64_t m_subBuckets = 1u << m_subBucketBits;
+    static constexpr unsigned m_maxShift = 32;
+    static constexpr std::size_t m_bucketCount = (m_maxShift + 2) * m_subBuckets;
+
+    std::array<std::uint64_t, m_bucketCount> m_counts{};
+    std::uint64_t m_count = 0;
+    std::uint64_t m_sum = 0;
+    std::uint64_t m_min = 0;
+    std::uint64_t m_max = 0;
+
+    static std::size_t bucketIndex(std::uint64_t value) noexcept;
+
+    static std::uint64_t bucketUpperBound(std::size_t index) noexcept;
+};
+
+/**
+ * @brief Latencies of one command, recorded for requests that got a response.
+ */
+struct CommandMetrics
+{
+    // From the request call to the start of the write, waiting for the write slot and the rate limiter.
+    LatencyHistogram queueWait;
+
+    // From the start of the write until the response message is received.
+    LatencyHistogram roundTrip;
+
+    // Parsing of the response message.
+    LatencyHistogram parse;
+};
+
+/**
+ * @brief Copy of the metrics of a client at one point in time.
+ */
+struct MetricsSnapshot
+{
+    // Metrics by command name.
+    std::map<std::string, CommandMetrics, std::less<>> commands;
+
+    std::uint64_t messagesSent = 0;
+    std::uint64_t bytesSent = 0;
+    std::uint64_t messagesReceived = 0;
+    std::uint64_t bytesReceived = 0;
+};
+
+namespace internals
+{
+
+/**
+ * @class MetricsRecorder
+ * @brief Collects the request latencies and the traffic counters of a connection.
+ *
+ * Can be shared by the connections of a client, so that the metrics survive a reconnect.
+ */
+class MetricsRecorder final
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Records the latencies of a request.
+     * @param command The command name.
+     * @param queueWait Time waiting for the write slot and the rate limiter.
+     * @param roundTrip Time from the start of the write until the response was received.
+     * @param parse Time parsing the response.
+     */
+    void recordRequest(std::string_view command, Clock::duration queueWait, Clock::duration roundTrip,
+                       Clock::duration parse);
+
+    void recordSent(std::size_t bytes) noexcept;
+
+    void recordReceived(std::size_t bytes) noexcept;
+
+    /**
+     * @brief Copies the current metrics.
+     * @return The metrics snapshot.
+     */
+    MetricsSnapshot snapshot() const;
+
+    /**
+     * @brief Clears all metrics.
+     */
+    void reset();
+
+  private:
+    // Guards m_commands only, the counters are atomic.
+    mutable std::mutex m_mutex;
+
+    std::map<std::string, CommandMetrics, std::less<>> m_commands;
+
+    std::atomic<std::uint64_t> m_messagesSent{0};
+    std::atomic<std::uint64_t> m_bytesSent{0};
+    std::atomic<std::uint64_t> m_messagesReceived{0};
+    std::atomic<std::uint64_t> m_bytesReceived{0};
+};
+
+} // namespace internals
+} // namespace xapi
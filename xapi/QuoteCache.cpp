@@ -0,0 +1,204 @@
+#include "QuoteCache.hpp"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+namespace xapi
+{
+
+QuoteCache::QuoteCache(std::size_t maxSymbols, std::size_t depth, bool seqlock)
+    : m_maxSymbols(maxSymbols), m_depth(std::max<std::size_t>(depth, 1)), m_seqlock(seqlock),
+      m_headers(std::make_unique<Header[]>(maxSymbols)), m_levels(std::make_unique<Level[]>(maxSymbols * m_depth)),
+      m_names(std::make_unique<SymbolName[]>(maxSymbols)), m_mutex(), m_ids(), m_symbolCount(0)
+{
+    m_ids.reserve(maxSymbols);
+}
+
+std::optional<SymbolId> QuoteCache::intern(std::string_view symbol)
+{
+    const SymbolName name(symbol);
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        const auto it = m_ids.find(name);
+        if (it != m_ids.end())
+        {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    const auto it = m_ids.find(name);
+    if (it != m_ids.end())
+    {
+        return it->second;
+    }
+
+    const std::size_t count = m_symbolCount.load(std::memory_order_relaxed);
+    if (count >= m_maxSymbols)
+    {
+        return std::nullopt;
+    }
+
+    const auto id = static_cast<SymbolId>(count);
+    m_names[id] = name;
+    m_ids.emplace(name, id);
+    m_symbolCount.store(count + 1, std::memory_order_release);
+    return id;
+}
+
+std::optional<SymbolId> QuoteCache::find(std::string_view symbol) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    const auto it = m_ids.find(SymbolName(symbol));
+    if (it == m_ids.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+SymbolName QuoteCache::symbol(SymbolId id) const noexcept
+{
+    if (id >= m_symbolCount.load(std::memory_order_acquire))
+    {
+        return SymbolName();
+    }
+    return m_names[id];
+}
+
+bool QuoteCache::update(const TickRecord &tick)
+{
+    if (tick.level < 0 || static_cast<std::size_t>(tick.level) >= m_depth)
+    {
+        return false;
+    }
+
+    const auto id = intern(tick.symbol);
+    if (!id)
+    {
+        return false;
+    }
+    return update(*id, tick);
+}
+
+bool QuoteCache::update(SymbolId id, const TickRecord &tick)
+{
+    if (tick.level < 0 || static_cast<std::size_t>(tick.level) >= m_depth ||
+        id >= m_symbolCount.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    Header &header = m_headers[id];
+    Level &level = m_levels[id * m_depth + static_cast<std::size_t>(tick.level)];
+
+    const std::uint64_t sequence = header.sequence.load(std::memory_order_relaxed);
+    if (m_seqlock)
+    {
+        header.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    level.bid.store(tick.bid, std::memory_order_relaxed);
+    level.ask.store(tick.ask, std::memory_order_relaxed);
+    level.bidVolume.store(tick.bidVolume, std::memory_order_relaxed);
+    level.askVolume.store(tick.askVolume, std::memory_order_relaxed);
+    level.timestamp.store(tick.timestamp, std::memory_order_relaxed);
+
+    const auto levels = static_cast<std::uint32_t>(tick.level + 1);
+    if (header.levels.load(std::memory_order_relaxed) < levels)
+    {
+        header.levels.store(levels, std::memory_order_release);
+    }
+
+    if (m_seqlock)
+    {
+        header.sequence.store(sequence + 2, std::memory_order_release);
+    }
+    return true;
+}
+
+bool QuoteCache::quote(SymbolId id, QuoteLevel &quote, std::size_t level) const noexcept
+{
+    if (id >= m_symbolCount.load(std::memory_order_acquire) || level >= m_depth)
+    {
+        return false;
+    }
+
+    QuoteLevel copy;
+    if (readConsistent(id, level, std::span<QuoteLevel>(&copy, 1)) == 0)
+    {
+        return false;
+    }
+    quote = copy;
+    return true;
+}
+
+std::size_t QuoteCache::book(SymbolId id, std::span<QuoteLevel> levels) const noexcept
+{
+    if (id >= m_symbolCount.load(std::memory_order_acquire))
+    {
+        return 0;
+    }
+    return readConsistent(id, 0, levels.first(std::min(levels.size(), m_depth)));
+}
+
+std::size_t QuoteCache::depth() const noexcept
+{
+    return m_depth;
+}
+
+std::size_t QuoteCache::symbolCount() const noexcept
+{
+    return m_symbolCount.load(std::memory_order_acquire);
+}
+
+std::size_t QuoteCache::read(SymbolId id, std::size_t first, std::span<QuoteLevel> levels) const noexcept
+{
+    const std::size_t received = m_headers[id].levels.load(std::memory_order_acquire);
+    const std::size_t count = received > first ? std::min(levels.size(), received - first) : 0;
+
+    const Level *level = &m_levels[id * m_depth + first];
+    for (std::size_t i = 0; i < count; ++i, ++level)
+    {
+        levels[i].bid = level->bid.load(std::memory_order_relaxed);
+        levels[i].ask = level->ask.load(std::memory_order_relaxed);
+        levels[i].bidVolume = level->bidVolume.load(std::memory_order_relaxed);
+        levels[i].askVolume = level->askVolume.load(std::memory_order_relaxed);
+        levels[i].timestamp = level->timestamp.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+std::size_t QuoteCache::readConsistent(SymbolId id, std::size_t first, std::span<QuoteLevel> levels) const noexcept
+{
+    if (!m_seqlock)
+    {
+        return read(id, first, levels);
+    }
+
+    const std::atomic<std::uint64_t> &sequence = m_headers[id].sequence;
+    while (true)
+    {
+        const std::uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            continue;
+        }
+
+        const std::size_t count = read(id, first, levels);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before)
+        {
+            return count;
+        }
+    }
+}
+
+std::size_t QuoteCache::SymbolHash::operator()(const SymbolName &symbol) const noexcept
+{
+    return std::hash<std::string_view>()(symbol.view());
+}
+
+} // namespace xapi
@@ -0,0 +1,178 @@
+#pragma once
+
+/**
+ * @file QuoteCache.hpp
+ * @brief Defines the QuoteCache class holding the current depth of book of each symbol.
+ *
+ * This file contains the definition of the QuoteCache class, which is updated in place from
+ * streamed ticks and read lock-free by symbol ID from any thread.
+ */
+
+#include "RingBuffer.hpp"
+#include "StreamRecords.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+
+namespace xapi
+{
+
+// Interned symbol, the index of the symbol in a QuoteCache.
+using SymbolId = std::uint32_t;
+
+/**
+ * @brief Prices of one depth level of a symbol.
+ */
+struct QuoteLevel
+{
+    double bid = 0.0;
+    double ask = 0.0;
+    std::int64_t bidVolume = 0;
+    std::int64_t askVolume = 0;
+    std::int64_t timestamp = 0;
+};
+
+/**
+ * @class QuoteCache
+ * @brief Cache of the latest bid and ask of every depth level of every symbol.
+ *
+ * Symbols are interned to dense IDs, and all books are allocated up front by the constructor:
+ * the levels of one symbol are stored next to each other and every symbol header is on its own
+ * cache line. update() writes a tick in place and must be called from one thread, usually from
+ * a StreamDispatcher handler on the I/O thread. Reads by ID are lock-free and can be done from
+ * any number of threads.
+ *
+ * With the seqlock enabled, a reader retries until it gets a copy of the book that was not
+ * being written, so a snapshot is always one consistent state of the symbol. Without it the
+ * writer is cheaper, but a read racing an update may mix fields of two ticks.
+ */
+class QuoteCache final
+{
+  public:
+    QuoteCache(const QuoteCache &) = delete;
+    QuoteCache &operator=(const QuoteCache &) = delete;
+
+    /**
+     * @brief Constructs a new QuoteCache object.
+     * @param maxSymbols Maximal number of symbols.
+     * @param depth Number of levels kept per symbol, ticks of deeper levels are ignored.
+     * @param seqlock If true, readers get consistent snapshots of a symbol.
+     */
+    explicit QuoteCache(std::size_t maxSymbols = 1024, std::size_t depth = 5, bool seqlock = true);
+
+    /**
+     * @brief Gets the ID of a symbol, registering it if needed.
+     * @param symbol The symbol name.
+     * @return The symbol ID, or std::nullopt if the cache is full.
+     */
+    std::optional<SymbolId> intern(std::string_view symbol);
+
+    /**
+     * @brief Gets the ID of a registered symbol.
+     * @param symbol The symbol name.
+     * @return The symbol ID, or std::nullopt if the symbol is not registered.
+     */
+    std::optional<SymbolId> find(std::string_view symbol) const;
+
+    /**
+     * @brief Gets the name of a registered symbol.
+     * @param id The symbol ID.
+     * @return The symbol name, empty if the ID is not registered.
+     */
+    SymbolName symbol(SymbolId id) const noexcept;
+
+    /**
+     * @brief Writes a tick into the book of its symbol, called from a single thread.
+     * @param tick The received tick.
+     * @return false if the cache is full or the level is not kept.
+     */
+    bool update(const TickRecord &tick);
+
+    /**
+     * @brief Writes a tick into the book of an interned symbol, called from a single thread.
+     *
+     * Skips the lookup of the symbol name done by update(tick), for a caller that interned the
+     * symbol once when it subscribed. The symbol of the tick is not checked against the ID.
+     * @param id The symbol ID.
+     * @param tick The received tick.
+     * @return false if the ID is not registered or the level is not kept.
+     */
+    bool update(SymbolId id, const TickRecord &tick);
+
+    /**
+     * @brief Reads one level of a symbol.
+     * @param id The symbol ID.
+     * @param quote Receives the prices.
+     * @param level The depth level, 0 for the best price.
+     * @return false if no tick was received for the level, quote is not changed.
+     */
+    bool quote(SymbolId id, QuoteLevel &quote, std::size_t level = 0) const noexcept;
+
+    /**
+     * @brief Reads all levels of a symbol at once.
+     * @param id The symbol ID.
+     * @param levels Receives the levels, starting from the best price.
+     * @return Number of copied levels, limited by the size of levels.
+     */
+    std::size_t book(SymbolId id, std::span<QuoteLevel> levels) const noexcept;
+
+    std::size_t depth() const noexcept;
+
+    std::size_t symbolCount() const noexcept;
+
+  private:
+    struct Level
+    {
+        std::atomic<double> bid{0.0};
+        std::atomic<double> ask{0.0};
+        std::atomic<std::int64_t> bidVolume{0};
+        std::atomic<std::int64_t> askVolume{0};
+        std::atomic<std::int64_t> timestamp{0};
+    };
+
+    struct alignas(internals::cacheLineSize) Header
+    {
+        // Odd while the book is being written.
+        std::atomic<std::uint64_t> sequence{0};
+
+        // Highest received level plus one.
+        std::atomic<std::uint32_t> levels{0};
+    };
+
+    struct SymbolHash
+    {
+        std::size_t operator()(const SymbolName &symbol) const noexcept;
+    };
+
+    // Copies levels without the seqlock, returns the number of levels received.
+    std::size_t read(SymbolId id, std::size_t first, std::span<QuoteLevel> levels) const noexcept;
+
+    // Copies levels, retrying while the book is written when the seqlock is enabled.
+    std::size_t readConsistent(SymbolId id, std::size_t first, std::span<QuoteLevel> levels) const noexcept;
+
+    const std::size_t m_maxSymbols;
+    const std::size_t m_depth;
+    const bool m_seqlock;
+
+    const std::unique_ptr<Header[]> m_headers;
+
+    // Levels of symbol id are at [id * m_depth, (id + 1) * m_depth).
+    const std::unique_ptr<Level[]> m_levels;
+
+    const std::unique_ptr<SymbolName[]> m_names;
+
+    // Guards m_ids only.
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<SymbolName, SymbolId, SymbolHash> m_ids;
+
+    // Number of registered symbols, published after their name is written.
+    std::atomic<std::size_t> m_symbolCount;
+};
+
+} // namespace xapi
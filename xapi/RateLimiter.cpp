@@ -0,0 +1,97 @@
+#include "RateLimiter.hpp"
+#include <algorithm>
+
+namespace xapi
+{
+namespace internals
+{
+
+namespace
+{
+
+// xAPI drops the connection after more than maxShortGaps gaps shorter than minimumGap in a row.
+constexpr std::chrono::milliseconds minimumGap(200);
+constexpr std::size_t maxShortGaps = 5;
+
+} // namespace
+
+RateLimiter::RateLimiter(std::size_t burstSize, double refillRate)
+    : m_burstSize(static_cast<double>(std::max<std::size_t>(burstSize, 1))), m_refillRate(std::max(refillRate, 0.001)),
+      m_tokens(m_burstSize), m_lastRefill(Clock::now()), m_lastSend(), m_shortGaps(0)
+{
+}
+
+void RateLimiter::configure(std::size_t burstSize, double refillRate)
+{
+    const std::lock_guard lock(m_mutex);
+    refill(Clock::now());
+    m_burstSize = static_cast<double>(std::max<std::size_t>(burstSize, 1));
+    m_refillRate = std::max(refillRate, 0.001);
+    m_tokens = std::min(m_tokens, m_burstSize);
+}
+
+boost::asio::awaitable<void> RateLimiter::acquire()
+{
+    const auto delay = reserve(Clock::now());
+    if (delay > Clock::duration::zero())
+    {
+        boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor);
+        timer.expires_after(delay);
+        co_await timer.async_wait(boost::asio::use_awaitable);
+    }
+}
+
+RateLimiter::Clock::duration RateLimiter::reserve(Clock::time_point now)
+{
+    const std::lock_guard lock(m_mutex);
+    refill(now);
+    m_tokens -= 1.0;
+    Clock::time_point sendAt = now;
+    if (m_tokens < 0.0)
+    {
+        const std::chrono::duration<double> delay(-m_tokens / m_refillRate);
+        sendAt += std::chrono::ceil<Clock::duration>(delay);
+    }
+
+    // Requests are sent in the order they were reserved, after a delayed one too
+    sendAt = std::max(sendAt, m_lastSend);
+    if (sendAt - m_lastSend < minimumGap)
+    {
+        if (m_shortGaps == maxShortGaps)
+        {
+            sendAt = m_lastSend + minimumGap;
+            m_shortGaps = 0;
+        }
+        else
+        {
+            ++m_shortGaps;
+        }
+    }
+    else
+    {
+        m_shortGaps = 0;
+    }
+    m_lastSend = sendAt;
+    return sendAt - now;
+}
+
+double RateLimiter::availableTokens(Clock::time_point now)
+{
+    const std::lock_guard lock(m_mutex);
+    refill(now);
+    return m_tokens;
+}
+
+void RateLimiter::refill(Clock::time_point now)
+{
+    if (now <= m_lastRefill)
+    {
+        return;
+    }
+    const std::chrono::duration<double> elapsed = now - m_lastRefill;
+    m_tokens = std::min(m_burstSize, m_tokens + elapsed.count() * m_refillRate);
+    m_lastRefill = now;
+}
+
+} // namespace internals
+} // namespace xapi
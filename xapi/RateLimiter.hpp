@@ -0,0 +1,110 @@
+#pragma once
+
+/**
+ * @file RateLimiter.hpp
+ * @brief Defines the RateLimiter class used to pace requests sent to the server.
+ *
+ * This file contains the definition of the RateLimiter class, a token bucket that
+ * can be shared between several connections of one account.
+ */
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+namespace xapi
+{
+namespace internals
+{
+
+/**
+ * @class RateLimiter
+ * @brief Token bucket limiting the rate of outgoing requests.
+ *
+ * The bucket holds up to burstSize tokens and is refilled with refillRate tokens per second.
+ * Every request takes one token. When the bucket is empty, the request is delayed until
+ * its token is refilled, so requests are sent in the order they were made.
+ *
+ * xAPI allows requests to be sent more often than every 200 ms, but drops the connection
+ * when it happens 6 times in a row. The limiter counts the gaps shorter than 200 ms in a row
+ * and delays the request that would make the 6th one, whatever the bucket parameters.
+ *
+ * The limiter is thread-safe, connections sharing it may run on different threads.
+ */
+class RateLimiter final
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    RateLimiter(const RateLimiter &other) = delete;
+    RateLimiter &operator=(const RateLimiter &other) = delete;
+
+    /**
+     * @brief Constructs a new RateLimiter object with a full bucket.
+     * @param burstSize Maximum number of requests that can be sent without delay.
+     * @param refillRate Number of tokens added to the bucket per second.
+     */
+    explicit RateLimiter(std::size_t burstSize = 5, double refillRate = 5.0);
+
+    /**
+     * @brief Changes the bucket parameters, keeping the tokens already available.
+     * @param burstSize Maximum number of requests that can be sent without delay.
+     * @param refillRate Number of tokens added to the bucket per second.
+     * @return void.
+     */
+    void configure(std::size_t burstSize, double refillRate);
+
+    /**
+     * @brief Takes one token, waiting for it to be refilled if the bucket is empty.
+     * @return An awaitable void.
+     */
+    boost::asio::awaitable<void> acquire();
+
+    /**
+     * @brief Takes one token and returns how long the caller has to wait before using it.
+     * @param now The current time.
+     * @return Zero if the request can be sent now, otherwise the time until its token is refilled
+     * or until it no longer follows 5 short gaps in a row.
+     */
+    Clock::duration reserve(Clock::time_point now);
+
+    /**
+     * @brief Gets the number of tokens available at the given time.
+     * @param now The current time.
+     * @return Number of tokens, negative if requests are already waiting for refill.
+     */
+    double availableTokens(Clock::time_point now);
+
+  private:
+    /**
+     * @brief Adds tokens refilled since the last update.
+     * @param now The current time.
+     * @return void.
+     */
+    void refill(Clock::time_point now);
+
+    // Guards the bucket, the connections sharing the limiter run on their own strands.
+    std::mutex m_mutex;
+
+    // Maximum number of tokens in the bucket.
+    double m_burstSize;
+
+    // Tokens added per second.
+    double m_refillRate;
+
+    // Tokens currently in the bucket, negative when requests wait for refill.
+    double m_tokens;
+
+    // Time of the last refill.
+    Clock::time_point m_lastRefill;
+
+    // Time the last reserved request is sent at.
+    Clock::time_point m_lastSend;
+
+    // Number of gaps shorter than the minimum gap in a row before the last reserved request.
+    std::size_t m_shortGaps;
+};
+
+} // namespace internals
+} // namespace xapi
@@ -0,0 +1,167 @@
+#include "ReplayConnection.hpp"
+#include "Exceptions.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace xapi
+{
+namespace internals
+{
+
+namespace
+{
+
+std::system_error systemError(const char *what, const std::filesystem::path &file)
+{
+    return std::system_error(errno, std::generic_category(), std::string(what) + " " + file.string());
+}
+
+} // namespace
+
+ReplayConnection::ReplayConnection(boost::asio::io_context &ioContext, const std::filesystem::path &journal,
+                                   ReplayPace pace)
+    : m_timer(ioContext), m_pace(pace), m_data(nullptr), m_size(0), m_offset(sizeof(JournalHeader)),
+      m_firstReceivedAt(0), m_startedAt(), m_replayed(0), m_requests(0)
+{
+    const int fd = ::open(journal.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw systemError("Cannot open journal", journal);
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0)
+    {
+        const auto error = systemError("Cannot stat journal", journal);
+        ::close(fd);
+        throw error;
+    }
+
+    const auto size = static_cast<std::size_t>(status.st_size);
+    if (size < sizeof(JournalHeader))
+    {
+        ::close(fd);
+        throw std::runtime_error("Journal is truncated: " + journal.string());
+    }
+
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        throw systemError("Cannot map journal", journal);
+    }
+    m_data = static_cast<const std::byte *>(data);
+    m_size = size;
+
+    JournalHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    if (header.magic != journalMagic || header.formatVersion != journalFormatVersion)
+    {
+        ::munmap(const_cast<std::byte *>(m_data), m_size);
+        throw std::runtime_error("Not a journal of this version: " + journal.string());
+    }
+    rewind();
+}
+
+ReplayConnection::~ReplayConnection()
+{
+    ::munmap(const_cast<std::byte *>(m_data), m_size);
+}
+
+boost::asio::awaitable<void> ReplayConnection::connect(const boost::url &)
+{
+    rewind();
+    co_return;
+}
+
+boost::asio::awaitable<void> ReplayConnection::disconnect()
+{
+    m_timer.cancel();
+    co_return;
+}
+
+boost::asio::awaitable<void> ReplayConnection::makeRequest(const Command &)
+{
+    ++m_requests;
+    co_return;
+}
+
+boost::asio::awaitable<boost::json::object> ReplayConnection::waitResponse()
+{
+    const std::string_view frame = co_await waitFrame();
+
+    boost::system::error_code ec;
+    boost::json::value value = boost::json::parse(frame, ec);
+    if (ec || !value.is_object())
+    {
+        throw exception::ConnectionClosed("Journal message is not a JSON object");
+    }
+    co_return std::move(value.as_object());
+}
+
+boost::asio::awaitable<std::string_view> ReplayConnection::waitFrame()
+{
+    if (m_offset == m_size)
+    {
+        throw exception::ConnectionClosed("End of journal");
+    }
+    if (m_size - m_offset < journalRecordHeaderSize)
+    {
+        throw exception::ConnectionClosed("Journal is truncated");
+    }
+
+    std::int64_t receivedAt = 0;
+    std::uint32_t size = 0;
+    std::memcpy(&receivedAt, m_data + m_offset, sizeof(receivedAt));
+    std::memcpy(&size, m_data + m_offset + sizeof(receivedAt), sizeof(size));
+    if (m_size - m_offset - journalRecordHeaderSize < size)
+    {
+        throw exception::ConnectionClosed("Journal is truncated");
+    }
+
+    if (m_pace == ReplayPace::Recorded)
+    {
+        m_timer.expires_at(m_startedAt + std::chrono::nanoseconds(receivedAt - m_firstReceivedAt));
+        boost::system::error_code ec;
+        co_await m_timer.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            throw exception::ConnectionClosed("Replay stopped");
+        }
+    }
+
+    const auto *frame = reinterpret_cast<const char *>(m_data + m_offset + journalRecordHeaderSize);
+    m_offset += journalRecordHeaderSize + size;
+    ++m_replayed;
+    co_return std::string_view(frame, size);
+}
+
+void ReplayConnection::rewind() noexcept
+{
+    m_offset = sizeof(JournalHeader);
+    m_replayed = 0;
+    m_startedAt = std::chrono::steady_clock::now();
+    if (m_size >= m_offset + sizeof(std::int64_t))
+    {
+        std::memcpy(&m_firstReceivedAt, m_data + m_offset, sizeof(std::int64_t));
+    }
+}
+
+std::size_t ReplayConnection::replayed() const noexcept
+{
+    return m_replayed;
+}
+
+std::size_t ReplayConnection::requests() const noexcept
+{
+    return m_requests;
+}
+
+} // namespace internals
+} // namespace xapi
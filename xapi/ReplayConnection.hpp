@@ -0,0 +1,120 @@
+#pragma once
+
+/**
+ * @file ReplayConnection.hpp
+ * @brief Defines the ReplayConnection class playing back a recorded journal.
+ *
+ * This file contains the definition of the ReplayConnection class, an IConnection that
+ * returns the messages of a SessionRecorder journal instead of reading from a server.
+ */
+
+#include "IConnection.hpp"
+#include "SessionRecorder.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace xapi
+{
+namespace internals
+{
+
+/**
+ * @brief How fast a journal is played back.
+ */
+enum class ReplayPace
+{
+    // Messages are returned with the delays they were received with.
+    Recorded,
+    // Messages are returned as soon as they are read.
+    Unpaced
+};
+
+/**
+ * @class ReplayConnection
+ * @brief Plays back a journal written by SessionRecorder, for repeatable tests and benchmarks.
+ *
+ * The journal is mapped into memory, waitFrame() returns views into the mapping without
+ * copying. connect() starts the playback from the first message, requests are accepted and
+ * dropped. Once all messages are returned, reads throw xapi::exception::ConnectionClosed as
+ * a closed server connection does.
+ */
+class ReplayConnection final : public IConnection
+{
+  public:
+    ReplayConnection(const ReplayConnection &) = delete;
+    ReplayConnection &operator=(const ReplayConnection &) = delete;
+
+    /**
+     * @brief Constructs a new ReplayConnection object.
+     * @param ioContext The IO context for the playback timer.
+     * @param journal The journal file.
+     * @param pace How fast the messages are returned.
+     * @throw std::system_error if the file cannot be opened or mapped.
+     * @throw std::runtime_error if the file is not a journal of this version.
+     */
+    ReplayConnection(boost::asio::io_context &ioContext, const std::filesystem::path &journal,
+                     ReplayPace pace = ReplayPace::Unpaced);
+
+    ~ReplayConnection() override;
+
+    /**
+     * @brief Starts the playback from the first message.
+     * @param url Not used.
+     * @return An awaitable void.
+     */
+    boost::asio::awaitable<void> connect(const boost::url &url) override;
+
+    boost::asio::awaitable<void> disconnect() override;
+
+    /**
+     * @brief Drops the request, the journal already holds the responses.
+     * @param command Not used.
+     * @return An awaitable void.
+     */
+    boost::asio::awaitable<void> makeRequest(const Command &command) override;
+
+    /**
+     * @brief Returns the next message parsed.
+     * @return An awaitable boost::json::object with the message.
+     * @throw xapi::exception::ConnectionClosed at the end of the journal or if the message is not valid JSON.
+     */
+    boost::asio::awaitable<boost::json::object> waitResponse() override;
+
+    /**
+     * @brief Returns the next message, waiting for its recorded time when paced.
+     * @return An awaitable view of the message, valid as long as the connection.
+     * @throw xapi::exception::ConnectionClosed at the end of the journal or if the journal is truncated.
+     */
+    boost::asio::awaitable<std::string_view> waitFrame() override;
+
+    // Number of messages returned since connect().
+    std::size_t replayed() const noexcept;
+
+    // Number of requests dropped.
+    std::size_t requests() const noexcept;
+
+  private:
+    // Moves back to the first message and restarts the playback clock.
+    void rewind() noexcept;
+
+    boost::asio::steady_timer m_timer;
+    const ReplayPace m_pace;
+
+    const std::byte *m_data;
+    std::size_t m_size;
+
+    // Offset of the next record.
+    std::size_t m_offset;
+
+    // Receive time of the first message and when the playback started, for pacing.
+    std::int64_t m_firstReceivedAt;
+    std::chrono::steady_clock::time_point m_startedAt;
+
+    std::size_t m_replayed;
+    std::size_t m_requests;
+};
+
+} // namespace internals
+} // namespace xapi
@@ -0,0 +1,271 @@
+#pragma once
+
+/**
+ * @file RingBuffer.hpp
+ * @brief Defines the lock-free rings handing records from the I/O thread to other threads.
+ *
+ * This file contains the definition of the SpscRing class, a single producer single consumer
+ * queue, and the BroadcastRing class, a disruptor-style ring read by several consumers.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+namespace xapi
+{
+
+namespace internals
+{
+
+// Counters written by different threads are kept on separate cache lines.
+inline constexpr std::size_t cacheLineSize = 64;
+
+inline std::size_t ringCapacity(std::size_t capacity)
+{
+    if (capacity == 0 || capacity > (std::size_t{1} << (sizeof(std::size_t) * 8 - 2)))
+    {
+        throw std::invalid_argument("Ring capacity out of range");
+    }
+    return std::bit_ceil(capacity);
+}
+
+} // namespace internals
+
+/**
+ * @class SpscRing
+ * @brief Bounded lock-free queue with one producer thread and one consumer thread.
+ *
+ * All slots are allocated by the constructor, tryPush() and tryPop() never allocate, block or
+ * take a lock. Each side keeps a cached copy of the other side's index, so the shared indexes
+ * are only read again when the ring looks full or empty.
+ * @tparam T The element type, trivially copyable.
+ */
+template <typename T> class SpscRing final
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing elements must be trivially copyable");
+
+  public:
+    SpscRing() = delete;
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    /**
+     * @brief Constructs a new SpscRing object.
+     * @param capacity Minimal number of elements, rounded up to a power of two.
+     * @throw std::invalid_argument if the capacity is zero or too large.
+     */
+    explicit SpscRing(std::size_t capacity)
+        : m_mask(internals::ringCapacity(capacity) - 1), m_slots(std::make_unique<T[]>(m_mask + 1))
+    {
+    }
+
+    /**
+     * @brief Appends an element, called by the producer thread only.
+     * @param value The element.
+     * @return false if the ring is full, the element is not added.
+     */
+    bool tryPush(const T &value) noexcept
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead > m_mask)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead > m_mask)
+            {
+                return false;
+            }
+        }
+
+        m_slots[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element, called by the consumer thread only.
+     * @param value Receives the element.
+     * @return false if the ring is empty, value is not changed.
+     */
+    bool tryPop(T &value) noexcept
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail)
+            {
+                return false;
+            }
+        }
+
+        value = m_slots[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+    /**
+     * @brief Gets the number of elements, exact only when called by the producer or consumer.
+     * @return Number of elements in the ring.
+     */
+    std::size_t size() const noexcept
+    {
+        const std::size_t head = m_head.load(std::memory_order_acquire);
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+  private:
+    const std::size_t m_mask;
+    const std::unique_ptr<T[]> m_slots;
+
+    // Written by the consumer.
+    alignas(internals::cacheLineSize) std::atomic<std::size_t> m_head{0};
+    std::size_t m_cachedTail = 0;
+
+    // Written by the producer.
+    alignas(internals::cacheLineSize) std::atomic<std::size_t> m_tail{0};
+    std::size_t m_cachedHead = 0;
+};
+
+/**
+ * @class BroadcastRing
+ * @brief Lock-free ring with one producer thread, every element is read by all consumers.
+ *
+ * Works like the LMAX disruptor: the producer publishes elements by moving a cursor, and every
+ * consumer polls the ring with its own sequence, on its own cache line. The producer does not
+ * overwrite an element before the slowest consumer has read it, tryPush() fails instead.
+ * @tparam T The element type, trivially copyable.
+ */
+template <typename T> class BroadcastRing final
+{
+    static_assert(std::is_trivially_copyable_v<T>, "BroadcastRing elements must be trivially copyable");
+
+  public:
+    BroadcastRing() = delete;
+
+    BroadcastRing(const BroadcastRing &) = delete;
+    BroadcastRing &operator=(const BroadcastRing &) = delete;
+
+    /**
+     * @brief Constructs a new BroadcastRing object.
+     * @param capacity Minimal number of elements, rounded up to a power of two.
+     * @param consumers Number of consumers, each polls with its index from 0 to consumers - 1.
+     * @throw std::invalid_argument if the capacity is out of range or there is no consumer.
+     */
+    BroadcastRing(std::size_t capacity, std::size_t consumers)
+        : m_mask(internals::ringCapacity(capacity) - 1), m_slots(std::make_unique<T[]>(m_mask + 1)),
+          m_consumerCount(consumers), m_consumers(std::make_unique<Sequence[]>(consumers))
+    {
+        if (consumers == 0)
+        {
+            throw std::invalid_argument("BroadcastRing needs at least one consumer");
+        }
+    }
+
+    /**
+     * @brief Publishes an element to all consumers, called by the producer thread only.
+     * @param value The element.
+     * @return false if the slowest consumer is a full ring behind, the element is not published.
+     */
+    bool tryPush(const T &value) noexcept
+    {
+        const std::uint64_t sequence = m_cursor.load(std::memory_order_relaxed);
+        if (sequence - m_cachedMinimum > m_mask)
+        {
+            m_cachedMinimum = minimumSequence();
+            if (sequence - m_cachedMinimum > m_mask)
+            {
+                return false;
+            }
+        }
+
+        m_slots[sequence & m_mask] = value;
+        m_cursor.store(sequence + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Reads the next element of a consumer, called by that consumer's thread only.
+     * @param consumer The consumer index.
+     * @param value Receives the element.
+     * @return false if the consumer has read all published elements, value is not changed.
+     */
+    bool tryPop(std::size_t consumer, T &value) noexcept
+    {
+        std::atomic<std::uint64_t> &next = m_consumers[consumer].value;
+        const std::uint64_t sequence = next.load(std::memory_order_relaxed);
+        if (sequence == m_cursor.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        value = m_slots[sequence & m_mask];
+        next.store(sequence + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+    std::size_t consumers() const noexcept
+    {
+        return m_consumerCount;
+    }
+
+    /**
+     * @brief Gets the number of elements published and not yet read by a consumer.
+     * @param consumer The consumer index.
+     * @return Number of pending elements.
+     */
+    std::size_t pending(std::size_t consumer) const noexcept
+    {
+        const std::uint64_t next = m_consumers[consumer].value.load(std::memory_order_acquire);
+        return static_cast<std::size_t>(m_cursor.load(std::memory_order_acquire) - next);
+    }
+
+  private:
+    struct alignas(internals::cacheLineSize) Sequence
+    {
+        std::atomic<std::uint64_t> value{0};
+    };
+
+    std::uint64_t minimumSequence() const noexcept
+    {
+        std::uint64_t minimum = m_consumers[0].value.load(std::memory_order_acquire);
+        for (std::size_t i = 1; i < m_consumerCount; ++i)
+        {
+            minimum = std::min(minimum, m_consumers[i].value.load(std::memory_order_acquire));
+        }
+        return minimum;
+    }
+
+    const std::size_t m_mask;
+    const std::unique_ptr<T[]> m_slots;
+    const std::size_t m_consumerCount;
+    const std::unique_ptr<Sequence[]> m_consumers;
+
+    // Written by the producer, the number of published elements.
+    alignas(internals::cacheLineSize) std::atomic<std::uint64_t> m_cursor{0};
+    std::uint64_t m_cachedMinimum = 0;
+};
+
+} // namespace xapi
@@ -0,0 +1,70 @@
+#include "SessionRecorder.hpp"
+#include <cerrno>
+#include <system_error>
+
+namespace xapi
+{
+
+namespace
+{
+
+constexpr std::size_t outputBufferSize = 1 << 20;
+
+} // namespace
+
+SessionRecorder::SessionRecorder(const std::filesystem::path &file)
+    : m_mutex(), m_buffer(std::make_unique<char[]>(outputBufferSize)), m_output(), m_frames(0)
+{
+    // The buffer has to be set before the file is opened.
+    m_output.rdbuf()->pubsetbuf(m_buffer.get(), outputBufferSize);
+    m_output.open(file, std::ios::binary | std::ios::trunc);
+    if (!m_output)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot create journal " + file.string());
+    }
+
+    const JournalHeader header{internals::journalMagic, internals::journalFormatVersion, 0};
+    m_output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    flush();
+}
+
+void SessionRecorder::record(std::string_view frame, Clock::time_point receivedAt)
+{
+    const std::int64_t time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(receivedAt.time_since_epoch()).count();
+    const auto size = static_cast<std::uint32_t>(frame.size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_output)
+    {
+        return;
+    }
+    m_output.write(reinterpret_cast<const char *>(&time), sizeof(time));
+    m_output.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    m_output.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+    ++m_frames;
+}
+
+void SessionRecorder::flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_output.flush();
+}
+
+std::size_t SessionRecorder::frames() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_frames;
+}
+
+bool SessionRecorder::good() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_output.good();
+}
+
+} // namespace xapi
@@ -0,0 +1,98 @@
+#pragma once
+
+/**
+ * @file SessionRecorder.hpp
+ * @brief Defines the SessionRecorder class writing received messages to a binary journal.
+ *
+ * This file contains the definition of the journal format and of the SessionRecorder class,
+ * which appends every message received by a Connection to a file for later replay.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+namespace xapi
+{
+
+/**
+ * @brief Header at the start of a journal file.
+ *
+ * It is followed by one record per message: the receive time in nanoseconds since epoch
+ * as std::int64_t, the message size as std::uint32_t, then the message bytes.
+ * Integers are stored in the byte order of the recording machine.
+ */
+struct JournalHeader
+{
+    std::array<char, 8> magic;
+    std::uint32_t formatVersion;
+    std::uint32_t reserved;
+};
+
+namespace internals
+{
+constexpr std::array<char, 8> journalMagic = {'X', 'A', 'P', 'I', 'J', 'R', 'N', '\0'};
+constexpr std::uint32_t journalFormatVersion = 1;
+
+// Size of the time and size fields before every message.
+constexpr std::size_t journalRecordHeaderSize = sizeof(std::int64_t) + sizeof(std::uint32_t);
+} // namespace internals
+
+/**
+ * @class SessionRecorder
+ * @brief Appends received messages with their receive time to a journal file.
+ *
+ * Set it on a connection with Connection::setRecorder() or XStationClientStream::setRecorder().
+ * Messages are buffered and written in large blocks, a write error stops the recording without
+ * failing the connection. One recorder can be shared by several connections, all methods are
+ * thread-safe. ReplayConnection plays the journal back.
+ */
+class SessionRecorder final
+{
+  public:
+    using Clock = std::chrono::system_clock;
+
+    SessionRecorder(const SessionRecorder &) = delete;
+    SessionRecorder &operator=(const SessionRecorder &) = delete;
+
+    /**
+     * @brief Creates a journal file, replacing an existing one.
+     * @param file The journal file.
+     * @throw std::system_error if the file cannot be created.
+     */
+    explicit SessionRecorder(const std::filesystem::path &file);
+
+    ~SessionRecorder();
+
+    /**
+     * @brief Appends a message to the journal.
+     * @param frame The message as received.
+     * @param receivedAt The receive time.
+     */
+    void record(std::string_view frame, Clock::time_point receivedAt = Clock::now());
+
+    /**
+     * @brief Writes the buffered messages to the file.
+     */
+    void flush();
+
+    // Number of recorded messages.
+    std::size_t frames() const;
+
+    // false after a write error, later messages are not recorded.
+    bool good() const;
+
+  private:
+    mutable std::mutex m_mutex;
+    std::unique_ptr<char[]> m_buffer;
+    std::ofstream m_output;
+    std::size_t m_frames;
+};
+
+} // namespace xapi
@@ -0,0 +1,163 @@
+#include "StreamDispatcher.hpp"
+#include "Exceptions.hpp"
+
+namespace xapi
+{
+
+namespace
+{
+
+constexpr std::size_t arenaBufferSize = 64 * 1024;
+
+} // namespace
+
+template <typename Stream>
+BasicStreamDispatcher<Stream>::BasicStreamDispatcher(Stream &stream)
+    : m_stream(stream), m_recordHandlers(), m_jsonHandlers(), m_recordParser(), m_jsonParser(),
+      m_arenaBuffer(std::make_unique<unsigned char[]>(arenaBufferSize)), m_arena(m_arenaBuffer.get(), arenaBufferSize),
+      m_record(),
+      m_skippedMessages(0), m_running(false)
+{
+}
+
+template <typename Stream>
+void BasicStreamDispatcher<Stream>::on(const std::string &command, JsonHandler handler)
+{
+    m_jsonHandlers[command] = std::move(handler);
+}
+
+template <typename Stream>
+void BasicStreamDispatcher<Stream>::remove(std::string_view command)
+{
+    const auto index = internals::StreamRecordParser::recordIndex(command);
+    if (index != std::variant_npos)
+    {
+        m_recordHandlers[index] = nullptr;
+    }
+
+    const auto it = m_jsonHandlers.find(command);
+    if (it != m_jsonHandlers.end())
+    {
+        m_jsonHandlers.erase(it);
+    }
+}
+
+template <typename Stream>
+boost::asio::awaitable<void> BasicStreamDispatcher<Stream>::run()
+{
+    m_running = true;
+    while (m_running)
+    {
+        const std::string_view frame = co_await m_stream.listenRaw();
+        try
+        {
+            dispatch(frame);
+        }
+        catch (const boost::system::system_error &e)
+        {
+            m_running = false;
+            throw exception::ConnectionClosed(e.what());
+        }
+    }
+}
+
+template <typename Stream>
+void BasicStreamDispatcher<Stream>::stop() noexcept
+{
+    m_running = false;
+}
+
+template <typename Stream>
+bool BasicStreamDispatcher<Stream>::dispatch(std::string_view frame)
+{
+    const std::string_view command = scanCommand(frame);
+
+    const auto index = internals::StreamRecordParser::recordIndex(command);
+    if (index != std::variant_npos && m_recordHandlers[index])
+    {
+        if (m_recordParser.parse(frame, m_record))
+        {
+            m_recordHandlers[m_record.index()](m_record);
+            return true;
+        }
+        ++m_skippedMessages;
+        return false;
+    }
+
+    const auto it = m_jsonHandlers.find(command);
+    if (it == m_jsonHandlers.end() || !it->second)
+    {
+        ++m_skippedMessages;
+        return false;
+    }
+
+    // The object passed to the previous handler is no longer used
+    m_arena.release();
+    m_jsonParser.reset(&m_arena);
+    boost::system::error_code ec;
+    m_jsonParser.write(frame.data(), frame.size(), ec);
+    if (!ec)
+    {
+        m_jsonParser.finish(ec);
+    }
+    if (ec)
+    {
+        throw boost::system::system_error(ec);
+    }
+
+    const boost::json::value message = m_jsonParser.release();
+    it->second(message.as_object());
+    return true;
+}
+
+template <typename Stream>
+std::uint64_t BasicStreamDispatcher<Stream>::skippedMessages() const noexcept
+{
+    return m_skippedMessages;
+}
+
+template <typename Stream>
+std::string_view BasicStreamDispatcher<Stream>::scanCommand(std::string_view frame) noexcept
+{
+    static constexpr std::string_view commandKey = "\"command\"";
+
+    const auto keyPosition = frame.find(commandKey);
+    if (keyPosition == std::string_view::npos)
+    {
+        return {};
+    }
+
+    std::size_t position = keyPosition + commandKey.size();
+    const auto skipWhitespace = [&frame, &position]() {
+        while (position < frame.size() &&
+               (frame[position] == ' ' || frame[position] == '\t' || frame[position] == '\n' || frame[position] == '\r'))
+        {
+            ++position;
+        }
+    };
+
+    skipWhitespace();
+    if (position >= frame.size() || frame[position] != ':')
+    {
+        return {};
+    }
+    ++position;
+    skipWhitespace();
+    if (position >= frame.size() || frame[position] != '"')
+    {
+        return {};
+    }
+    ++position;
+
+    const auto end = frame.find('"', position);
+    if (end == std::string_view::npos)
+    {
+        return {};
+    }
+    return frame.substr(position, end - position);
+}
+
+template class BasicStreamDispatcher<XStationClientStream>;
+template class BasicStreamDispatcher<DirectXStationClientStream>;
+
+} // namespace xapi
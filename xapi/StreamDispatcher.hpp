@@ -0,0 +1,170 @@
+#pragma once
+
+/**
+ * @file StreamDispatcher.hpp
+ * @brief Defines the BasicStreamDispatcher class routing streaming messages to handlers.
+ *
+ * This file contains the definition of the BasicStreamDispatcher class, which reads messages
+ * from a client stream and calls the handler registered for their command, and of its
+ * StreamDispatcher and DirectStreamDispatcher variants.
+ */
+
+#include "StreamRecordParser.hpp"
+#include "StreamRecords.hpp"
+#include "XStationClientStream.hpp"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace xapi
+{
+
+/**
+ * @class BasicStreamDispatcher
+ * @brief Routes streaming messages to handlers registered per command.
+ *
+ * The command of every message is found by a scan of the raw message, before any parsing.
+ * Messages with a typed handler are parsed straight into their record, messages with a
+ * JSON handler are parsed into boost::json::object, and all other messages are skipped
+ * without being parsed.
+ *
+ * Once the handlers are registered and the buffers have grown to the largest message, dispatching
+ * does not allocate: typed messages are parsed into a reused record and JSON messages into an
+ * arena that is reset on every message.
+ * @tparam Stream XStationClientStream or DirectXStationClientStream.
+ */
+template <typename Stream> class BasicStreamDispatcher final
+{
+  public:
+    using JsonHandler = std::function<void(const boost::json::object &)>;
+
+    BasicStreamDispatcher() = delete;
+
+    BasicStreamDispatcher(const BasicStreamDispatcher &) = delete;
+    BasicStreamDispatcher &operator=(const BasicStreamDispatcher &) = delete;
+
+    /**
+     * @brief Constructs a new BasicStreamDispatcher object.
+     * @param stream The opened stream to read messages from, must outlive the dispatcher.
+     */
+    explicit BasicStreamDispatcher(Stream &stream);
+
+    /**
+     * @brief Registers a handler for a typed record, replacing the previous one.
+     *
+     * Example: `dispatcher.on<TickRecord>([](const TickRecord &tick) { ... });`
+     * @tparam Record One of the StreamRecord alternatives.
+     * @param handler Called with the parsed record.
+     */
+    template <typename Record, typename Handler> void on(Handler handler)
+    {
+        m_recordHandlers[recordIndexOf<Record>()] = [handler = std::move(handler)](const StreamRecord &record) {
+            handler(std::get<Record>(record));
+        };
+    }
+
+    /**
+     * @brief Registers a handler receiving the message as JSON, replacing the previous one.
+     *
+     * Typed handlers take precedence over JSON handlers for the same command. The object passed
+     * to the handler is only valid during the call, copy it to keep it longer.
+     * @param command The command to handle, for example `candle`.
+     * @param handler Called with the whole parsed message.
+     */
+    void on(const std::string &command, JsonHandler handler);
+
+    /**
+     * @brief Removes the handlers registered for a command.
+     * @param command The command, for example `candle`.
+     */
+    void remove(std::string_view command);
+
+    /**
+     * @brief Reads and dispatches messages until stop() is called or the connection fails.
+     * @return An awaitable void.
+     * @throw xapi::exception::ConnectionClosed if the connection fails or a message is not valid JSON.
+     */
+    boost::asio::awaitable<void> run();
+
+    /**
+     * @brief Stops run() after the message being handled.
+     */
+    void stop() noexcept;
+
+    /**
+     * @brief Dispatches a single message.
+     * @param frame The raw message received from the streaming server.
+     * @return true if a handler was called, false if the message was skipped.
+     * @throw boost::system::system_error if the message is not valid JSON.
+     */
+    bool dispatch(std::string_view frame);
+
+    /**
+     * @brief Gets the number of messages skipped without parsing.
+     * @return Number of skipped messages.
+     */
+    std::uint64_t skippedMessages() const noexcept;
+
+    /**
+     * @brief Finds the value of the `command` member without parsing the message.
+     * @param frame The raw message.
+     * @return The command, or an empty view if it was not found.
+     */
+    static std::string_view scanCommand(std::string_view frame) noexcept;
+
+  private:
+    template <typename Record, std::size_t Index = 0> static constexpr std::size_t recordIndexOf()
+    {
+        static_assert(Index < std::variant_size_v<StreamRecord>, "Record is not a StreamRecord alternative");
+        if constexpr (std::is_same_v<Record, std::variant_alternative_t<Index, StreamRecord>>)
+        {
+            return Index;
+        }
+        else
+        {
+            return recordIndexOf<Record, Index + 1>();
+        }
+    }
+
+    Stream &m_stream;
+
+    // Typed handlers indexed by StreamRecord alternative.
+    std::array<std::function<void(const StreamRecord &)>, std::variant_size_v<StreamRecord>> m_recordHandlers;
+
+    // JSON handlers by command.
+    std::map<std::string, JsonHandler, std::less<>> m_jsonHandlers;
+
+    internals::StreamRecordParser m_recordParser;
+    boost::json::stream_parser m_jsonParser;
+
+    // Initial block of the arena, so that typical messages are parsed without touching the heap.
+    std::unique_ptr<unsigned char[]> m_arenaBuffer;
+
+    // Arena for messages passed to JSON handlers, reset on every message.
+    boost::json::monotonic_resource m_arena;
+
+    // Record reused for every typed message.
+    StreamRecord m_record;
+
+    std::uint64_t m_skippedMessages;
+    bool m_running;
+};
+
+/**
+ * @brief Dispatcher reading from XStationClientStream.
+ */
+using StreamDispatcher = BasicStreamDispatcher<XStationClientStream>;
+
+/**
+ * @brief Dispatcher reading from DirectXStationClientStream.
+ */
+using DirectStreamDispatcher = BasicStreamDispatcher<DirectXStationClientStream>;
+
+extern template class BasicStreamDispatcher<XStationClientStream>;
+extern template class BasicStreamDispatcher<DirectXStationClientStream>;
+
+} // namespace xapi
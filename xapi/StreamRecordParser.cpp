@@ -0,0 +1,723 @@
+#include "StreamRecordParser.hpp"
+#include <array>
+#include <boost/json/basic_parser_impl.hpp>
+#include <string>
+
+namespace xapi
+{
+namespace internals
+{
+
+namespace
+{
+
+/**
+ * @brief Scalar value of a member, strings are only valid during the callback.
+ */
+struct FieldValue
+{
+    enum class Kind
+    {
+        Null,
+        Integer,
+        Double,
+        Bool,
+        String
+    };
+
+    Kind kind = Kind::Null;
+    std::int64_t integer = 0;
+    double number = 0.0;
+    bool boolean = false;
+    std::string_view string;
+
+    double asDouble() const noexcept
+    {
+        if (kind == Kind::Integer)
+        {
+            return static_cast<double>(integer);
+        }
+        return kind == Kind::Double ? number : 0.0;
+    }
+
+    std::int64_t asInteger() const noexcept
+    {
+        if (kind == Kind::Double)
+        {
+            return static_cast<std::int64_t>(number);
+        }
+        return kind == Kind::Integer ? integer : 0;
+    }
+
+    int asInt() const noexcept
+    {
+        return static_cast<int>(asInteger());
+    }
+
+    bool asBool() const noexcept
+    {
+        return kind == Kind::Bool && boolean;
+    }
+
+    std::string_view asString() const noexcept
+    {
+        return kind == Kind::String ? string : std::string_view();
+    }
+};
+
+// Strings are moved out and back, so that they keep their capacity.
+template <typename Record, typename... Strings> void resetKeepingStrings(Record &record, Strings... strings)
+{
+    std::array<std::string, sizeof...(Strings)> kept{std::move(record.*strings)...};
+    record = Record();
+    std::size_t i = 0;
+    ((record.*strings = std::move(kept[i]), (record.*strings).clear(), ++i), ...);
+}
+
+template <typename Record> void resetRecord(Record &record)
+{
+    record = Record();
+}
+
+void resetRecord(TradeRecord &record)
+{
+    resetKeepingStrings(record, &TradeRecord::comment, &TradeRecord::customComment, &TradeRecord::state);
+}
+
+void resetRecord(TradeStatusRecord &record)
+{
+    resetKeepingStrings(record, &TradeStatusRecord::customComment, &TradeStatusRecord::message);
+}
+
+void resetRecord(NewsRecord &record)
+{
+    resetKeepingStrings(record, &NewsRecord::body, &NewsRecord::key, &NewsRecord::title);
+}
+
+void emplaceRecord(StreamRecord &record, std::size_t index)
+{
+    if (index != std::variant_npos && record.index() == index)
+    {
+        // Same record type as the previous message, reset in place instead of destroying it
+        std::visit([](auto &alternative) { resetRecord(alternative); }, record);
+        return;
+    }
+
+    switch (index)
+    {
+    case 0:
+        record.emplace<TickRecord>();
+        break;
+    case 1:
+        record.emplace<CandleRecord>();
+        break;
+    case 2:
+        record.emplace<BalanceRecord>();
+        break;
+    case 3:
+        record.emplace<TradeRecord>();
+        break;
+    case 4:
+        record.emplace<TradeStatusRecord>();
+        break;
+    case 5:
+        record.emplace<ProfitRecord>();
+        break;
+    case 6:
+        record.emplace<NewsRecord>();
+        break;
+    case 7:
+        record.emplace<KeepAliveRecord>();
+        break;
+    default:
+        break;
+    }
+}
+
+void assignField(TickRecord &record, std::string_view key, const FieldValue &value)
+{
+    if (key == "ask")
+    {
+        record.ask = value.asDouble();
+    }
+    else if (key == "bid")
+    {
+        record.bid = value.asDouble();
+    }
+    else if (key == "symbol")
+    {
+        record.symbol.assign(value.asString());
+    }
+    else if (key == "timestamp")
+    {
+        record.timestamp = value.asInteger();
+    }
+    else if (key == "askVolume")
+    {
+        record.askVolume = value.asInteger();
+    }
+    else if (key == "bidVolume")
+    {
+        record.bidVolume = value.asInteger();
+    }
+    else if (key == "high")
+    {
+        record.high = value.asDouble();
+    }
+    else if (key == "low")
+    {
+        record.low = value.asDouble();
+    }
+    else if (key == "level")
+    {
+        record.level = value.asInt();
+    }
+    else if (key == "quoteId")
+    {
+        record.quoteId = value.asInt();
+    }
+    else if (key == "spreadRaw")
+    {
+        record.spreadRaw = value.asDouble();
+    }
+    else if (key == "spreadTable")
+    {
+        record.spreadTable = value.asDouble();
+    }
+}
+
+void assignField(CandleRecord &record, std::string_view key, const FieldValue &value)
+{
+    if (key == "close")
+    {
+        record.close = value.asDouble();
+    }
+    else if (key == "ctm")
+    {
+        record.ctm = value.asInteger();
+    }
+    else if (key == "high")
+    {
+        record.high = value.asDouble();
+    }
+    else if (key == "low")
+    {
+        record.low = value.asDouble();
+    }
+    else if (key == "open")
+    {
+        record.open = value.asDouble();
+    }
+    else if (key == "quoteId")
+    {
+        record.quoteId = value.asInt();
+    }
+    else if (key == "symbol")
+    {
+        record.symbol.assign(value.asString());
+    }
+    else if (key == "vol")
+    {
+        record.vol = value.asDouble();
+    }
+}
+
+void assignField(BalanceRecord &record, std::string_view key, const FieldValue &value)
+{
+    if (key == "balance")
+    {
+        record.balance = value.asDouble();
+    }
+    else if (key == "credit")
+    {
+        record.credit = value.asDouble();
+    }
+    else if (key == "equity")
+    {
+        record.equity = value.asDouble();
+    }
+    else if (key == "margin")
+    {
+        record.margin = value.asDouble();
+    }
+    else if (key == "marginFree")
+    {
+        record.marginFree = value.asDouble();
+    }
+    else if (key == "marginLevel")
+    {
+        record.marginLevel = value.asDouble();
+    }
+}
+
+void assignField(TradeRecord &record, std::string_view key, const FieldValue &value)
+{
+    if (key == "close_price")
+    {
+        record.closePrice = value.asDouble();
+    }
+    else if (key == "close_time")
+    {
+        record.closeTime = value.asInteger();
+    }
+    else if (key == "closed")
+    {
+        record.closed = value.asBool();
+    }
+    else if (key == "cmd")
+    {
+        record.cmd = value.asInt();
+    }
+    else if (key == "comment")
+    {
+        record.comment.assign(value.asString());
+    }
+    else if (key == "commission")
+    {
+        record.commission = value.asDouble();
+    }
+    else if (key == "customComment")
+    {
+        record.customComment.assign(value.asString());
+    }
+    else if (key == "digits")
+    {
+        record.digits = value.asInt();
+    }
+    else if (key == "expiration")
+    {
+        record.expiration = value.asInteger();
+    }
+    else if (key == "margin_rate")
+    {
+        record.marginRate = value.asDouble();
+    }
+    else if (key == "offset")
+    {
+        record.offset = value.asInt();
+    }
+    else if (key == "open_price")
+    {
+        record.openPrice = value.asDouble();
+    }
+    else if (key == "open_time")
+    {
+        record.openTime = value.asInteger();
+    }
+    else if (key == "order")
+    {
+        record.order = value.asInteger();
+    }
+    else if (key == "order2")
+    {
+        record.order2 = value.asInteger();
+    }
+    else if (key == "position")
+    {
+        record.position = value.asInteger();
+    }
+    else if (key == "profit")
+    {
+        record.profit = value.asDouble();
+    }
+    else if (key == "sl")
+    {
+        record.sl = value.asDouble();
+    }
+    else if (key == "state")
+    {
+        record.state.assign(value.asString());
+    }
+    else if (key == "storage")
+    {
+        record.storage = value.asDouble();
+    }
+    else if (key == "symbol")
+    {
+        record.symbol.assign(value.asString());
+    }
+    else if (key == "tp")
+    {
+        record.tp = value.asDouble();
+    }
+    else if (key == "type")
+    {
+        record.type = value.asInt();
+    }
+    else if (key == "volume")
+    {
+        record.volume = value.asDouble();
+    }
+}
+
+void assignField(TradeStatusRecord &record, std::string_view key, const FieldValue &value)
+{
+    if (key == "customComment")
+    {
+        record.customComment.assign(value.asString());
+    }
+    else if (key == "message")
+    {
+        record.message.assign(value.asString());
+    }
+    else if (key == "order")
+    {
+        record.order = value.asInteger();
+    }
+    else if (key == "price")
+    {
+        record.price = value.asDouble();
+    }
+    else if (key == "requestStatus")
+    {
+        record.requestStatus = value.asInt();
+    }
+}
+
+void assignField(ProfitRecord &record, std::string_view key, const FieldValue &value)
+{
+    if (key == "order")
+    {
+        record.order = value.asInteger();
+    }
+    else if (key == "order2")
+    {
+        record.order2 = value.asInteger();
+    }
+    else if (key == "position")
+    {
+        record.position = value.asInteger();
+    }
+    else if (key == "profit")
+    {
+        record.profit = value.asDouble();
+    }
+}
+
+void assignField(NewsRecord &record, std::string_view key, const FieldValue &value)
+{
+    if (key == "body")
+    {
+        record.body.assign(value.asString());
+    }
+    else if (key == "key")
+    {
+        record.key.assign(value.asString());
+    }
+    else if (key == "time")
+    {
+        record.time = value.asInteger();
+    }
+    else if (key == "title")
+    {
+        record.title.assign(value.asString());
+    }
+}
+
+void assignField(KeepAliveRecord &record, std::string_view key, const FieldValue &value)
+{
+    if (key == "timestamp")
+    {
+        record.timestamp = value.asInteger();
+    }
+}
+
+} // namespace
+
+/**
+ * @brief boost::json::basic_parser handler filling a StreamRecord.
+ *
+ * Expects messages shaped as `{"command": "...", "data": {...}}`. Members of `data`
+ * are assigned as they are parsed, which requires `command` to come first. If it
+ * does not, the handler records the command and the message is parsed again.
+ */
+class StreamRecordParser::Handler
+{
+  public:
+    static constexpr std::size_t max_object_size = static_cast<std::size_t>(-1);
+    static constexpr std::size_t max_array_size = static_cast<std::size_t>(-1);
+    static constexpr std::size_t max_key_size = static_cast<std::size_t>(-1);
+    static constexpr std::size_t max_string_size = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief Prepares the handler for the next message.
+     * @param record The record to fill.
+     * @param index The record alternative if already known from a previous pass, npos otherwise.
+     */
+    void begin(StreamRecord &record, std::size_t index)
+    {
+        m_record = &record;
+        m_presetIndex = index;
+        m_index = index;
+        m_depth = 0;
+        m_inData = false;
+        m_dataBeforeCommand = false;
+        m_key.clear();
+        m_string.clear();
+        if (index != std::variant_npos)
+        {
+            emplaceRecord(record, index);
+        }
+    }
+
+    std::size_t recordIndex() const noexcept
+    {
+        return m_index;
+    }
+
+    bool dataBeforeCommand() const noexcept
+    {
+        return m_dataBeforeCommand;
+    }
+
+    bool on_document_begin(boost::json::error_code &)
+    {
+        return true;
+    }
+
+    bool on_document_end(boost::json::error_code &)
+    {
+        return true;
+    }
+
+    bool on_object_begin(boost::json::error_code &)
+    {
+        ++m_depth;
+        if (m_depth == 2 && m_topKey == "data")
+        {
+            m_inData = true;
+            m_dataBeforeCommand = m_index == std::variant_npos;
+        }
+        return true;
+    }
+
+    bool on_object_end(std::size_t, boost::json::error_code &)
+    {
+        if (m_depth == 2)
+        {
+            m_inData = false;
+        }
+        --m_depth;
+        return true;
+    }
+
+    bool on_array_begin(boost::json::error_code &)
+    {
+        ++m_depth;
+        return true;
+    }
+
+    bool on_array_end(std::size_t, boost::json::error_code &)
+    {
+        --m_depth;
+        return true;
+    }
+
+    bool on_key_part(boost::json::string_view s, std::size_t, boost::json::error_code &)
+    {
+        m_key.append(s.data(), s.size());
+        return true;
+    }
+
+    bool on_key(boost::json::string_view s, std::size_t, boost::json::error_code &)
+    {
+        m_key.append(s.data(), s.size());
+        if (m_depth == 1)
+        {
+            m_topKey.assign(m_key);
+        }
+        m_currentKey.swap(m_key);
+        m_key.clear();
+        return true;
+    }
+
+    bool on_string_part(boost::json::string_view s, std::size_t, boost::json::error_code &)
+    {
+        m_string.append(s.data(), s.size());
+        return true;
+    }
+
+    bool on_string(boost::json::string_view s, std::size_t, boost::json::error_code &)
+    {
+        m_string.append(s.data(), s.size());
+        FieldValue value;
+        value.kind = FieldValue::Kind::String;
+        value.string = m_string;
+        onValue(value);
+        m_string.clear();
+        return true;
+    }
+
+    bool on_number_part(boost::json::string_view, boost::json::error_code &)
+    {
+        return true;
+    }
+
+    bool on_int64(std::int64_t i, boost::json::string_view, boost::json::error_code &)
+    {
+        FieldValue value;
+        value.kind = FieldValue::Kind::Integer;
+        value.integer = i;
+        onValue(value);
+        return true;
+    }
+
+    bool on_uint64(std::uint64_t u, boost::json::string_view, boost::json::error_code &)
+    {
+        FieldValue value;
+        value.kind = FieldValue::Kind::Integer;
+        value.integer = static_cast<std::int64_t>(u);
+        onValue(value);
+        return true;
+    }
+
+    bool on_double(double d, boost::json::string_view, boost::json::error_code &)
+    {
+        FieldValue value;
+        value.kind = FieldValue::Kind::Double;
+        value.number = d;
+        onValue(value);
+        return true;
+    }
+
+    bool on_bool(bool b, boost::json::error_code &)
+    {
+        FieldValue value;
+        value.kind = FieldValue::Kind::Bool;
+        value.boolean = b;
+        onValue(value);
+        return true;
+    }
+
+    bool on_null(boost::json::error_code &)
+    {
+        onValue(FieldValue());
+        return true;
+    }
+
+    bool on_comment_part(boost::json::string_view, boost::json::error_code &)
+    {
+        return true;
+    }
+
+    bool on_comment(boost::json::string_view, boost::json::error_code &)
+    {
+        return true;
+    }
+
+  private:
+    void onValue(const FieldValue &value)
+    {
+        if (m_depth == 1 && m_currentKey == "command")
+        {
+            if (m_presetIndex == std::variant_npos)
+            {
+                m_index = StreamRecordParser::recordIndex(value.asString());
+                emplaceRecord(*m_record, m_index);
+            }
+        }
+        else if (m_depth == 2 && m_inData && m_index != std::variant_npos)
+        {
+            std::visit([this, &value](auto &record) { assignField(record, m_currentKey, value); }, *m_record);
+        }
+    }
+
+    StreamRecord *m_record = nullptr;
+    std::size_t m_presetIndex = std::variant_npos;
+    std::size_t m_index = std::variant_npos;
+    int m_depth = 0;
+    bool m_inData = false;
+    bool m_dataBeforeCommand = false;
+
+    // Buffers are reused between messages to avoid allocations.
+    std::string m_key;
+    std::string m_currentKey;
+    std::string m_topKey;
+    std::string m_string;
+};
+
+struct StreamRecordParser::Impl
+{
+    Impl() : parser(boost::json::parse_options())
+    {
+    }
+
+    boost::json::basic_parser<Handler> parser;
+};
+
+StreamRecordParser::StreamRecordParser() : m_impl(std::make_unique<Impl>())
+{
+}
+
+StreamRecordParser::StreamRecordParser(StreamRecordParser &&other) noexcept = default;
+
+StreamRecordParser &StreamRecordParser::operator=(StreamRecordParser &&other) noexcept = default;
+
+StreamRecordParser::~StreamRecordParser() = default;
+
+std::size_t StreamRecordParser::recordIndex(std::string_view command) noexcept
+{
+    if (command == "tickPrices")
+    {
+        return 0;
+    }
+    if (command == "candle")
+    {
+        return 1;
+    }
+    if (command == "balance")
+    {
+        return 2;
+    }
+    if (command == "trade")
+    {
+        return 3;
+    }
+    if (command == "tradeStatus")
+    {
+        return 4;
+    }
+    if (command == "profit")
+    {
+        return 5;
+    }
+    if (command == "news")
+    {
+        return 6;
+    }
+    if (command == "keepAlive")
+    {
+        return 7;
+    }
+    return std::variant_npos;
+}
+
+bool StreamRecordParser::parse(std::string_view frame, StreamRecord &record)
+{
+    auto &parser = m_impl->parser;
+    auto &handler = parser.handler();
+
+    const auto run = [&parser, frame]() {
+        parser.reset();
+        boost::json::error_code ec;
+        parser.write_some(false, frame.data(), frame.size(), ec);
+        if (ec)
+        {
+            throw boost::system::system_error(ec);
+        }
+    };
+
+    handler.begin(record, std::variant_npos);
+    run();
+
+    if (handler.dataBeforeCommand() && handler.recordIndex() != std::variant_npos)
+    {
+        // The command came after data, parse again now that the record type is known
+        handler.begin(record, handler.recordIndex());
+        run();
+    }
+    return handler.recordIndex() != std::variant_npos;
+}
+
+} // namespace internals
+} // namespace xapi
@@ -0,0 +1,64 @@
+#pragma once
+
+/**
+ * @file StreamRecordParser.hpp
+ * @brief Defines the StreamRecordParser class for parsing streaming messages into typed records.
+ *
+ * This file contains the definition of the StreamRecordParser class, which fills records
+ * from StreamRecords.hpp straight from the message bytes, without building a JSON DOM.
+ */
+
+#include "StreamRecords.hpp"
+#include <memory>
+#include <string_view>
+
+namespace xapi
+{
+namespace internals
+{
+
+/**
+ * @class StreamRecordParser
+ * @brief SAX style parser of streaming messages into StreamRecord.
+ *
+ * The parser keeps its internal buffers between messages, so after the first few
+ * messages tick and candle records are parsed without allocating.
+ */
+class StreamRecordParser final
+{
+  public:
+    StreamRecordParser();
+
+    StreamRecordParser(const StreamRecordParser &other) = delete;
+    StreamRecordParser &operator=(const StreamRecordParser &other) = delete;
+
+    StreamRecordParser(StreamRecordParser &&other) noexcept;
+    StreamRecordParser &operator=(StreamRecordParser &&other) noexcept;
+
+    ~StreamRecordParser();
+
+    /**
+     * @brief Parses a streaming message into a record.
+     * @param frame The message received from the streaming server.
+     * @param record The record to fill, the alternative is chosen from the `command` member.
+     * @return true if the message is a known streaming record, false otherwise.
+     * @throw boost::system::system_error if the message is not valid JSON.
+     */
+    bool parse(std::string_view frame, StreamRecord &record);
+
+    /**
+     * @brief Gets the StreamRecord alternative used for a streaming command.
+     * @param command The value of the `command` member, for example `tickPrices`.
+     * @return Index of the StreamRecord alternative, std::variant_npos if the command is unknown.
+     */
+    static std::size_t recordIndex(std::string_view command) noexcept;
+
+  private:
+    class Handler;
+    struct Impl;
+
+    std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace internals
+} // namespace xapi
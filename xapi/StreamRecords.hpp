@@ -0,0 +1,217 @@
+#pragma once
+
+/**
+ * @file StreamRecords.hpp
+ * @brief Defines typed records for the messages received from the streaming server.
+ *
+ * This file contains the definition of the records filled from streaming messages,
+ * so that consumers do not have to walk boost::json::object for every message.
+ * Field names follow the xAPI streaming documentation. Null values are left at zero.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+namespace xapi
+{
+
+/**
+ * @class ShortString
+ * @brief Fixed capacity string stored inline, used to keep records trivially copyable.
+ *
+ * Values longer than the capacity are truncated.
+ */
+template <std::size_t Capacity> class ShortString
+{
+    static_assert(Capacity > 0 && Capacity < 256, "ShortString capacity must fit in one byte");
+
+  public:
+    constexpr ShortString() noexcept = default;
+
+    ShortString(std::string_view value) noexcept
+    {
+        assign(value);
+    }
+
+    void assign(std::string_view value) noexcept
+    {
+        m_size = static_cast<std::uint8_t>(std::min(value.size(), Capacity));
+        std::memcpy(m_data.data(), value.data(), m_size);
+    }
+
+    std::string_view view() const noexcept
+    {
+        return std::string_view(m_data.data(), m_size);
+    }
+
+    operator std::string_view() const noexcept
+    {
+        return view();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    friend bool operator==(const ShortString &lhs, const ShortString &rhs) noexcept
+    {
+        return lhs.view() == rhs.view();
+    }
+
+    friend bool operator==(const ShortString &lhs, std::string_view rhs) noexcept
+    {
+        return lhs.view() == rhs;
+    }
+
+  private:
+    std::array<char, Capacity> m_data{};
+    std::uint8_t m_size = 0;
+};
+
+// Symbol name as used in xAPI, for example `EURUSD` or `US100`.
+using SymbolName = ShortString<31>;
+
+/**
+ * @brief Tick prices received after getTickPrices subscription, command `tickPrices`.
+ */
+struct TickRecord
+{
+    double ask = 0.0;
+    std::int64_t askVolume = 0;
+    double bid = 0.0;
+    std::int64_t bidVolume = 0;
+    double high = 0.0;
+    int level = 0;
+    double low = 0.0;
+    int quoteId = 0;
+    double spreadRaw = 0.0;
+    double spreadTable = 0.0;
+    SymbolName symbol;
+    std::int64_t timestamp = 0;
+};
+
+/**
+ * @brief One minute candle received after getCandles subscription, command `candle`.
+ * ctmString is not stored, it is the same time as ctm.
+ */
+struct CandleRecord
+{
+    double close = 0.0;
+    std::int64_t ctm = 0;
+    double high = 0.0;
+    double low = 0.0;
+    double open = 0.0;
+    int quoteId = 0;
+    SymbolName symbol;
+    double vol = 0.0;
+};
+
+/**
+ * @brief Account indicators received after getBalance subscription, command `balance`.
+ */
+struct BalanceRecord
+{
+    double balance = 0.0;
+    double credit = 0.0;
+    double equity = 0.0;
+    double margin = 0.0;
+    double marginFree = 0.0;
+    double marginLevel = 0.0;
+};
+
+/**
+ * @brief Trade received after getTrades subscription, command `trade`.
+ */
+struct TradeRecord
+{
+    double closePrice = 0.0;
+    std::int64_t closeTime = 0;
+    bool closed = false;
+    int cmd = 0;
+    std::string comment;
+    double commission = 0.0;
+    std::string customComment;
+    int digits = 0;
+    std::int64_t expiration = 0;
+    double marginRate = 0.0;
+    int offset = 0;
+    double openPrice = 0.0;
+    std::int64_t openTime = 0;
+    std::int64_t order = 0;
+    std::int64_t order2 = 0;
+    std::int64_t position = 0;
+    double profit = 0.0;
+    double sl = 0.0;
+    std::string state;
+    double storage = 0.0;
+    SymbolName symbol;
+    double tp = 0.0;
+    int type = 0;
+    double volume = 0.0;
+};
+
+/**
+ * @brief Trade status received after getTradeStatus subscription, command `tradeStatus`.
+ */
+struct TradeStatusRecord
+{
+    std::string customComment;
+    std::string message;
+    std::int64_t order = 0;
+    double price = 0.0;
+    int requestStatus = 0;
+};
+
+/**
+ * @brief Profit of a trade received after getProfits subscription, command `profit`.
+ */
+struct ProfitRecord
+{
+    std::int64_t order = 0;
+    std::int64_t order2 = 0;
+    std::int64_t position = 0;
+    double profit = 0.0;
+};
+
+/**
+ * @brief News received after getNews subscription, command `news`.
+ */
+struct NewsRecord
+{
+    std::string body;
+    std::string key;
+    std::int64_t time = 0;
+    std::string title;
+};
+
+/**
+ * @brief Keep alive message received after getKeepAlive subscription, command `keepAlive`.
+ */
+struct KeepAliveRecord
+{
+    std::int64_t timestamp = 0;
+};
+
+// Any record received from the streaming server.
+using StreamRecord = std::variant<TickRecord, CandleRecord, BalanceRecord, TradeRecord, TradeStatusRecord, ProfitRecord,
+                                  NewsRecord, KeepAliveRecord>;
+
+// Fixed-size market data record, trivially copyable so it can be handed over through a ring.
+using MarketRecord = std::variant<TickRecord, CandleRecord>;
+
+static_assert(std::is_trivially_copyable_v<MarketRecord>, "MarketRecord must be trivially copyable");
+
+} // namespace xapi
@@ -0,0 +1,57 @@
+#include "SubscriptionRegistry.hpp"
+#include <algorithm>
+
+namespace xapi
+{
+namespace internals
+{
+
+Subscription::Subscription(std::string command, std::string symbol, int minArrivalTime, int maxLevel)
+    : command(std::move(command)), symbol(std::move(symbol)), minArrivalTime(minArrivalTime), maxLevel(maxLevel)
+{
+}
+
+void SubscriptionRegistry::add(Subscription subscription)
+{
+    const auto it = std::find_if(m_subscriptions.begin(), m_subscriptions.end(), [&subscription](const Subscription &s) {
+        return s.command == subscription.command && s.symbol == subscription.symbol;
+    });
+
+    if (it != m_subscriptions.end())
+    {
+        *it = std::move(subscription);
+    }
+    else
+    {
+        m_subscriptions.push_back(std::move(subscription));
+    }
+}
+
+void SubscriptionRegistry::remove(std::string_view command, std::string_view symbol)
+{
+    std::erase_if(m_subscriptions,
+                  [command, symbol](const Subscription &s) { return s.command == command && s.symbol == symbol; });
+}
+
+const std::vector<Subscription> &SubscriptionRegistry::subscriptions() const noexcept
+{
+    return m_subscriptions;
+}
+
+std::size_t SubscriptionRegistry::size() const noexcept
+{
+    return m_subscriptions.size();
+}
+
+bool SubscriptionRegistry::empty() const noexcept
+{
+    return m_subscriptions.empty();
+}
+
+void SubscriptionRegistry::clear() noexcept
+{
+    m_subscriptions.clear();
+}
+
+} // namespace internals
+} // namespace xapi
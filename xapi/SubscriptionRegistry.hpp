@@ -0,0 +1,75 @@
+#pragma once
+
+/**
+ * @file SubscriptionRegistry.hpp
+ * @brief Defines the SubscriptionRegistry class keeping track of active stream subscriptions.
+ *
+ * This file contains the definition of the SubscriptionRegistry class, used to replay
+ * subscriptions after the streaming connection is re-established.
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xapi
+{
+namespace internals
+{
+
+/**
+ * @brief Active stream subscription, described by the command that started it.
+ */
+struct Subscription
+{
+    explicit Subscription(std::string command, std::string symbol = {}, int minArrivalTime = 0, int maxLevel = 0);
+
+    // Subscription command, for example `getTickPrices`.
+    std::string command;
+
+    // Symbol for per-symbol subscriptions, empty otherwise.
+    std::string symbol;
+
+    // getTickPrices arguments.
+    int minArrivalTime;
+    int maxLevel;
+};
+
+/**
+ * @class SubscriptionRegistry
+ * @brief Keeps the subscriptions that are currently active, in the order they were made.
+ */
+class SubscriptionRegistry final
+{
+  public:
+    /**
+     * @brief Adds a subscription, replacing the one with the same command and symbol.
+     * @param subscription The subscription to add.
+     */
+    void add(Subscription subscription);
+
+    /**
+     * @brief Removes a subscription.
+     * @param command The subscription command, for example `getTickPrices`.
+     * @param symbol The symbol, empty for subscriptions without symbol.
+     */
+    void remove(std::string_view command, std::string_view symbol = {});
+
+    /**
+     * @brief Gets the active subscriptions.
+     * @return The subscriptions in the order they were made.
+     */
+    const std::vector<Subscription> &subscriptions() const noexcept;
+
+    std::size_t size() const noexcept;
+
+    bool empty() const noexcept;
+
+    void clear() noexcept;
+
+  private:
+    std::vector<Subscription> m_subscriptions;
+};
+
+} // namespace internals
+} // namespace xapi
@@ -0,0 +1,396 @@
+#include "SymbolCatalog.hpp"
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+namespace xapi
+{
+
+struct SymbolCatalog::Header
+{
+    std::array<char, 8> magic;
+    std::uint32_t formatVersion;
+    std::uint32_t recordSize;
+    std::uint64_t count;
+    std::uint64_t bucketCount;
+    std::int64_t validatedAt;
+    ShortString<23> serverVersion;
+};
+
+namespace
+{
+
+constexpr std::array<char, 8> catalogMagic = {'X', 'A', 'P', 'I', 'S', 'Y', 'M', '\0'};
+constexpr std::uint32_t catalogFormatVersion = 1;
+
+static_assert(std::is_trivially_copyable_v<SymbolInfo>, "SymbolInfo is written to the file as is");
+static_assert(sizeof(SymbolInfo) % alignof(SymbolInfo) == 0);
+
+std::system_error systemError(const std::string &what, const std::filesystem::path &file)
+{
+    return std::system_error(errno, std::generic_category(), what + " " + file.string());
+}
+
+// Number format of a member varies between servers, null is read as zero.
+template <typename Number> Number readNumber(const boost::json::object &record, std::string_view key)
+{
+    const auto *value = record.if_contains(key);
+    if (value == nullptr || value->is_null())
+    {
+        return Number{};
+    }
+
+    boost::system::error_code ec;
+    const auto number = value->to_number<Number>(ec);
+    return ec ? static_cast<Number>(value->is_double() ? value->get_double() : 0) : number;
+}
+
+bool readBool(const boost::json::object &record, std::string_view key)
+{
+    const auto *value = record.if_contains(key);
+    return value != nullptr && value->is_bool() && value->get_bool();
+}
+
+std::string_view readString(const boost::json::object &record, std::string_view key)
+{
+    const auto *value = record.if_contains(key);
+    if (value == nullptr || !value->is_string())
+    {
+        return {};
+    }
+    const auto &string = value->get_string();
+    return std::string_view(string.data(), string.size());
+}
+
+// A size larger than the capacity, in a corrupt file, would make view() read past the string.
+template <std::size_t Capacity> bool fitsCapacity(const ShortString<Capacity> &string) noexcept
+{
+    return string.size() <= Capacity;
+}
+
+bool hasValidStrings(const SymbolInfo &info) noexcept
+{
+    return fitsCapacity(info.symbol) && fitsCapacity(info.categoryName) && fitsCapacity(info.currency) &&
+           fitsCapacity(info.currencyProfit) && fitsCapacity(info.groupName) && fitsCapacity(info.description);
+}
+
+SymbolInfo parseSymbol(const boost::json::object &record)
+{
+    SymbolInfo info;
+    info.contractSize = readNumber<std::int64_t>(record, "contractSize");
+    info.expiration = readNumber<std::int64_t>(record, "expiration");
+    info.instantMaxVolume = readNumber<std::int64_t>(record, "instantMaxVolume");
+    info.leverage = readNumber<double>(record, "leverage");
+    info.lotMax = readNumber<double>(record, "lotMax");
+    info.lotMin = readNumber<double>(record, "lotMin");
+    info.lotStep = readNumber<double>(record, "lotStep");
+    info.swapLong = readNumber<double>(record, "swapLong");
+    info.swapShort = readNumber<double>(record, "swapShort");
+    info.tickSize = readNumber<double>(record, "tickSize");
+    info.tickValue = readNumber<double>(record, "tickValue");
+    info.initialMargin = readNumber<int>(record, "initialMargin");
+    info.marginMode = readNumber<int>(record, "marginMode");
+    info.pipsPrecision = readNumber<int>(record, "pipsPrecision");
+    info.precision = readNumber<int>(record, "precision");
+    info.profitMode = readNumber<int>(record, "profitMode");
+    info.stopsLevel = readNumber<int>(record, "stopsLevel");
+    info.type = readNumber<int>(record, "type");
+    info.longOnly = readBool(record, "longOnly");
+    info.shortSelling = readBool(record, "shortSelling");
+    info.swapEnable = readBool(record, "swapEnable");
+    info.trailingEnabled = readBool(record, "trailingEnabled");
+    info.symbol = readString(record, "symbol");
+    info.categoryName = readString(record, "categoryName");
+    info.currency = readString(record, "currency");
+    info.currencyProfit = readString(record, "currencyProfit");
+    info.groupName = readString(record, "groupName");
+    info.description = readString(record, "description");
+    return info;
+}
+
+} // namespace
+
+SymbolCatalog::SymbolCatalog() noexcept : m_buffer(), m_data(nullptr), m_size(0), m_mapped(false)
+{
+}
+
+SymbolCatalog::SymbolCatalog(SymbolCatalog &&other) noexcept
+    : m_buffer(std::move(other.m_buffer)), m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)), m_mapped(std::exchange(other.m_mapped, false))
+{
+}
+
+SymbolCatalog &SymbolCatalog::operator=(SymbolCatalog &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (m_mapped)
+        {
+            ::munmap(const_cast<std::byte *>(m_data), m_size);
+        }
+        m_buffer = std::move(other.m_buffer);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_mapped = std::exchange(other.m_mapped, false);
+    }
+    return *this;
+}
+
+SymbolCatalog::~SymbolCatalog()
+{
+    if (m_mapped)
+    {
+        ::munmap(const_cast<std::byte *>(m_data), m_size);
+    }
+}
+
+SymbolCatalog SymbolCatalog::build(const boost::json::array &symbols, std::string_view serverVersion,
+                                   Clock::time_point validatedAt)
+{
+    // At most half of the buckets are used, so probe sequences stay short.
+    const std::uint64_t count = symbols.size();
+    const std::uint64_t bucketCount = std::bit_ceil(std::max<std::uint64_t>(count * 2, 8));
+
+    SymbolCatalog catalog;
+    catalog.m_buffer.resize(sizeof(Header) + count * sizeof(SymbolInfo) + bucketCount * sizeof(std::uint32_t));
+    catalog.m_data = catalog.m_buffer.data();
+    catalog.m_size = catalog.m_buffer.size();
+
+    static_assert(sizeof(Header) == 64, "Records must start on an 8 byte boundary");
+
+    Header header{};
+    header.magic = catalogMagic;
+    header.formatVersion = catalogFormatVersion;
+    header.recordSize = sizeof(SymbolInfo);
+    header.count = count;
+    header.bucketCount = bucketCount;
+    header.validatedAt = std::chrono::duration_cast<std::chrono::seconds>(validatedAt.time_since_epoch()).count();
+    header.serverVersion = serverVersion;
+    std::memcpy(catalog.m_buffer.data(), &header, sizeof(Header));
+
+    std::byte *records = catalog.m_buffer.data() + sizeof(Header);
+    auto *buckets = reinterpret_cast<std::uint32_t *>(records + count * sizeof(SymbolInfo));
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        const auto *record = symbols[i].if_object();
+        if (record == nullptr)
+        {
+            throw std::invalid_argument("Symbol record is not an object");
+        }
+
+        const SymbolInfo info = parseSymbol(*record);
+        if (info.symbol.empty())
+        {
+            throw std::invalid_argument("Symbol record without symbol");
+        }
+        std::memcpy(records + i * sizeof(SymbolInfo), &info, sizeof(SymbolInfo));
+
+        // Buckets hold the record index plus one, zero is an empty bucket.
+        std::uint64_t bucket = hash(info.symbol) & (bucketCount - 1);
+        while (buckets[bucket] != 0)
+        {
+            bucket = (bucket + 1) & (bucketCount - 1);
+        }
+        buckets[bucket] = static_cast<std::uint32_t>(i + 1);
+    }
+
+    return catalog;
+}
+
+SymbolCatalog SymbolCatalog::load(const std::filesystem::path &file)
+{
+    const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw systemError("Cannot open symbol catalog", file);
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0)
+    {
+        const auto error = systemError("Cannot stat symbol catalog", file);
+        ::close(fd);
+        throw error;
+    }
+
+    const auto size = static_cast<std::size_t>(status.st_size);
+    if (size < sizeof(Header))
+    {
+        ::close(fd);
+        throw std::runtime_error("Symbol catalog is truncated: " + file.string());
+    }
+
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        throw systemError("Cannot map symbol catalog", file);
+    }
+
+    SymbolCatalog catalog;
+    catalog.m_data = static_cast<const std::byte *>(data);
+    catalog.m_size = size;
+    catalog.m_mapped = true;
+
+    // The file is shared with other processes, nothing in it is trusted before it is checked
+    const Header &header = catalog.header();
+    const std::size_t payload = size - sizeof(Header);
+    bool valid = header.magic == catalogMagic && header.formatVersion == catalogFormatVersion &&
+                 header.recordSize == sizeof(SymbolInfo) && std::has_single_bit(header.bucketCount) &&
+                 header.bucketCount > header.count && header.count <= payload / sizeof(SymbolInfo) &&
+                 fitsCapacity(header.serverVersion);
+    if (valid)
+    {
+        // Cannot overflow, the records fit in the payload
+        const std::size_t bucketBytes = payload - header.count * sizeof(SymbolInfo);
+        valid = bucketBytes % sizeof(std::uint32_t) == 0 && header.bucketCount == bucketBytes / sizeof(std::uint32_t);
+    }
+    if (valid)
+    {
+        // find() indexes the records with the entries and probes until an empty bucket
+        bool hasEmptyBucket = false;
+        for (const std::uint32_t entry : catalog.buckets())
+        {
+            valid = valid && entry <= header.count;
+            hasEmptyBucket = hasEmptyBucket || entry == 0;
+        }
+        valid = valid && hasEmptyBucket;
+    }
+    if (valid)
+    {
+        for (const SymbolInfo &info : catalog.symbols())
+        {
+            valid = valid && hasValidStrings(info);
+        }
+    }
+    if (!valid)
+    {
+        throw std::runtime_error("Not a symbol catalog of this version: " + file.string());
+    }
+    return catalog;
+}
+
+void SymbolCatalog::save(const std::filesystem::path &file) const
+{
+    // Processes that mapped the previous file keep reading it until they unmap it.
+    std::filesystem::path temporary = file;
+    temporary += ".tmp" + std::to_string(::getpid());
+
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char *>(m_data), static_cast<std::streamsize>(m_size));
+        output.flush();
+        if (!output)
+        {
+            const auto error = systemError("Cannot write symbol catalog", temporary);
+            output.close();
+            std::filesystem::remove(temporary);
+            throw error;
+        }
+    }
+
+    std::filesystem::rename(temporary, file);
+}
+
+void SymbolCatalog::touch(const std::filesystem::path &file, Clock::time_point validatedAt)
+{
+    const std::int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(validatedAt.time_since_epoch()).count();
+
+    std::fstream stream(file, std::ios::binary | std::ios::in | std::ios::out);
+    stream.seekp(offsetof(Header, validatedAt));
+    stream.write(reinterpret_cast<const char *>(&seconds), sizeof(seconds));
+    stream.flush();
+    if (!stream)
+    {
+        throw systemError("Cannot update symbol catalog", file);
+    }
+}
+
+const SymbolInfo *SymbolCatalog::find(std::string_view symbol) const noexcept
+{
+    if (m_data == nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto table = buckets();
+    const auto records = symbols();
+    std::uint64_t bucket = hash(symbol) & (table.size() - 1);
+    while (table[bucket] != 0)
+    {
+        const SymbolInfo &info = records[table[bucket] - 1];
+        if (info.symbol == symbol)
+        {
+            return &info;
+        }
+        bucket = (bucket + 1) & (table.size() - 1);
+    }
+    return nullptr;
+}
+
+std::span<const SymbolInfo> SymbolCatalog::symbols() const noexcept
+{
+    if (m_data == nullptr)
+    {
+        return {};
+    }
+    return std::span<const SymbolInfo>(reinterpret_cast<const SymbolInfo *>(m_data + sizeof(Header)),
+                                       header().count);
+}
+
+std::size_t SymbolCatalog::size() const noexcept
+{
+    return m_data == nullptr ? 0 : header().count;
+}
+
+std::string_view SymbolCatalog::serverVersion() const noexcept
+{
+    return m_data == nullptr ? std::string_view() : header().serverVersion.view();
+}
+
+SymbolCatalog::Clock::time_point SymbolCatalog::validatedAt() const noexcept
+{
+    return m_data == nullptr ? Clock::time_point() : Clock::time_point(std::chrono::seconds(header().validatedAt));
+}
+
+bool SymbolCatalog::isMapped() const noexcept
+{
+    return m_mapped;
+}
+
+const SymbolCatalog::Header &SymbolCatalog::header() const noexcept
+{
+    return *reinterpret_cast<const Header *>(m_data);
+}
+
+std::span<const std::uint32_t> SymbolCatalog::buckets() const noexcept
+{
+    const Header &catalogHeader = header();
+    return std::span<const std::uint32_t>(
+        reinterpret_cast<const std::uint32_t *>(m_data + sizeof(Header) + catalogHeader.count * sizeof(SymbolInfo)),
+        catalogHeader.bucketCount);
+}
+
+std::uint64_t SymbolCatalog::hash(std::string_view symbol) noexcept
+{
+    // FNV-1a, stable between processes and builds.
+    std::uint64_t value = 14695981039346656037ull;
+    for (const char c : symbol)
+    {
+        value ^= static_cast<unsigned char>(c);
+        value *= 1099511628211ull;
+    }
+    return value;
+}
+
+} // namespace xapi
@@ -0,0 +1,158 @@
+#pragma once
+
+/**
+ * @file SymbolCatalog.hpp
+ * @brief Defines the SymbolCatalog class, a compact binary table of all symbols.
+ *
+ * This file contains the definition of the SymbolInfo record and the SymbolCatalog class,
+ * which is built from the getAllSymbols response and persisted to a memory-mapped file.
+ */
+
+#include "StreamRecords.hpp"
+#include <boost/json.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace xapi
+{
+
+/**
+ * @brief Symbol record of the getAllSymbols response, stored with a fixed size.
+ * Prices are not stored, they are outdated as soon as the catalog is saved.
+ */
+struct SymbolInfo
+{
+    std::int64_t contractSize = 0;
+    std::int64_t expiration = 0;
+    std::int64_t instantMaxVolume = 0;
+    double leverage = 0.0;
+    double lotMax = 0.0;
+    double lotMin = 0.0;
+    double lotStep = 0.0;
+    double swapLong = 0.0;
+    double swapShort = 0.0;
+    double tickSize = 0.0;
+    double tickValue = 0.0;
+    int initialMargin = 0;
+    int marginMode = 0;
+    int pipsPrecision = 0;
+    int precision = 0;
+    int profitMode = 0;
+    int stopsLevel = 0;
+    int type = 0;
+    bool longOnly = false;
+    bool shortSelling = false;
+    bool swapEnable = false;
+    bool trailingEnabled = false;
+    SymbolName symbol;
+    ShortString<15> categoryName;
+    ShortString<7> currency;
+    ShortString<7> currencyProfit;
+    ShortString<31> groupName;
+    ShortString<95> description;
+};
+
+/**
+ * @class SymbolCatalog
+ * @brief Read-only table of SymbolInfo records with a hash index by symbol name.
+ *
+ * The catalog is one contiguous block: a header, the records, then an open addressing index.
+ * The same block is written to disk by save() and mapped back by load(), so loading does no
+ * parsing and the pages are shared by all processes mapping the same file.
+ *
+ * XStationClient::getSymbolCatalog() keeps the file up to date with the server.
+ */
+class SymbolCatalog final
+{
+  public:
+    using Clock = std::chrono::system_clock;
+
+    /**
+     * @brief Constructs an empty catalog.
+     */
+    SymbolCatalog() noexcept;
+
+    SymbolCatalog(const SymbolCatalog &) = delete;
+    SymbolCatalog &operator=(const SymbolCatalog &) = delete;
+
+    SymbolCatalog(SymbolCatalog &&other) noexcept;
+    SymbolCatalog &operator=(SymbolCatalog &&other) noexcept;
+
+    ~SymbolCatalog();
+
+    /**
+     * @brief Builds a catalog in memory from the symbol records.
+     * @param symbols The `returnData` array of the getAllSymbols response.
+     * @param serverVersion The version returned by getVersion, truncated to 23 characters.
+     * @param validatedAt Time the records were received from the server.
+     * @return The catalog.
+     * @throw std::invalid_argument if a record is not an object or has no symbol.
+     */
+    static SymbolCatalog build(const boost::json::array &symbols, std::string_view serverVersion,
+                               Clock::time_point validatedAt = Clock::now());
+
+    /**
+     * @brief Maps a catalog file into memory.
+     * @param file The file written by save().
+     * @return The catalog, valid until it is destroyed, even if the file is replaced.
+     * @throw std::system_error if the file cannot be opened or mapped.
+     * @throw std::runtime_error if the file is not a catalog of this version.
+     */
+    static SymbolCatalog load(const std::filesystem::path &file);
+
+    /**
+     * @brief Writes the catalog to a file, replacing it atomically.
+     * @param file The destination file.
+     * @throw std::system_error if the file cannot be written.
+     */
+    void save(const std::filesystem::path &file) const;
+
+    /**
+     * @brief Updates the validation time stored in a catalog file.
+     * @param file The catalog file.
+     * @param validatedAt The new validation time.
+     * @throw std::system_error if the file cannot be written.
+     */
+    static void touch(const std::filesystem::path &file, Clock::time_point validatedAt = Clock::now());
+
+    /**
+     * @brief Finds a symbol by name.
+     * @param symbol The symbol name.
+     * @return The record, or nullptr if the symbol is not in the catalog.
+     */
+    const SymbolInfo *find(std::string_view symbol) const noexcept;
+
+    std::span<const SymbolInfo> symbols() const noexcept;
+
+    std::size_t size() const noexcept;
+
+    std::string_view serverVersion() const noexcept;
+
+    Clock::time_point validatedAt() const noexcept;
+
+    // true if the catalog is mapped from a file, false if it is built in memory.
+    bool isMapped() const noexcept;
+
+  private:
+    struct Header;
+
+    const Header &header() const noexcept;
+
+    std::span<const std::uint32_t> buckets() const noexcept;
+
+    static std::uint64_t hash(std::string_view symbol) noexcept;
+
+    // Owned block of a built catalog, empty when mapped.
+    std::vector<std::byte> m_buffer;
+
+    const std::byte *m_data;
+    std::size_t m_size;
+    bool m_mapped;
+};
+
+} // namespace xapi
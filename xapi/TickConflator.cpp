@@ -0,0 +1,144 @@
+#include "TickConflator.hpp"
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace xapi
+{
+
+TickConflator::TickConflator(std::size_t maxEntries)
+    : m_maxEntries(maxEntries), m_mutex(), m_buckets(std::bit_ceil(std::max<std::size_t>(maxEntries * 2, 8)), 0),
+      m_entries(), m_dirty(), m_updates(0), m_conflated(0), m_rejected(0)
+{
+    m_entries.reserve(maxEntries);
+    m_dirty.reserve(maxEntries);
+}
+
+bool TickConflator::update(const TickRecord &tick)
+{
+    const Key key{tick.symbol, tick.level};
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::size_t &bucket = m_buckets[findBucket(key)];
+    if (bucket == 0)
+    {
+        if (m_entries.size() >= m_maxEntries)
+        {
+            ++m_rejected;
+            return false;
+        }
+        m_entries.emplace_back();
+        bucket = m_entries.size();
+    }
+
+    const std::size_t index = bucket - 1;
+    Entry &entry = m_entries[index];
+    entry.tick = tick;
+    if (entry.dirty)
+    {
+        ++m_conflated;
+    }
+    else
+    {
+        entry.dirty = true;
+        m_dirty.push_back(index);
+    }
+    ++m_updates;
+    return true;
+}
+
+std::size_t TickConflator::poll(std::vector<TickRecord> &ticks)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (const std::size_t index : m_dirty)
+    {
+        Entry &entry = m_entries[index];
+        ticks.push_back(entry.tick);
+        entry.dirty = false;
+    }
+
+    const std::size_t count = m_dirty.size();
+    m_dirty.clear();
+    return count;
+}
+
+std::optional<TickRecord> TickConflator::latest(std::string_view symbol, int level) const
+{
+    const Key key{SymbolName(symbol), level};
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const std::size_t bucket = m_buckets[findBucket(key)];
+    if (bucket == 0)
+    {
+        return std::nullopt;
+    }
+    return m_entries[bucket - 1].tick;
+}
+
+std::size_t TickConflator::dirtyCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dirty.size();
+}
+
+std::size_t TickConflator::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+std::uint64_t TickConflator::updates() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_updates;
+}
+
+std::uint64_t TickConflator::conflated() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_conflated;
+}
+
+std::uint64_t TickConflator::rejected() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rejected;
+}
+
+void TickConflator::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::fill(m_buckets.begin(), m_buckets.end(), 0);
+    m_entries.clear();
+    m_dirty.clear();
+    m_updates = 0;
+    m_conflated = 0;
+    m_rejected = 0;
+}
+
+std::size_t TickConflator::findBucket(const Key &key) const noexcept
+{
+    const std::size_t mask = m_buckets.size() - 1;
+    std::size_t bucket = KeyHash()(key) & mask;
+    while (m_buckets[bucket] != 0)
+    {
+        const TickRecord &tick = m_entries[m_buckets[bucket] - 1].tick;
+        if (tick.symbol == key.symbol && tick.level == key.level)
+        {
+            break;
+        }
+        bucket = (bucket + 1) & mask;
+    }
+    return bucket;
+}
+
+std::size_t TickConflator::KeyHash::operator()(const Key &key) const noexcept
+{
+    const std::size_t hash = std::hash<std::string_view>()(key.symbol.view());
+    return hash ^ (std::hash<int>()(key.level) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+}
+
+} // namespace xapi
@@ -0,0 +1,137 @@
+#pragma once
+
+/**
+ * @file TickConflator.hpp
+ * @brief Defines the TickConflator class keeping the latest tick per symbol and level.
+ *
+ * This file contains the definition of the TickConflator class, which lets a slow consumer
+ * poll only the ticks that changed since its last poll instead of every streamed tick.
+ */
+
+#include "StreamRecords.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace xapi
+{
+
+/**
+ * @class TickConflator
+ * @brief Conflates streamed ticks, only the latest tick of each symbol and level is kept.
+ *
+ * update() is called for every received tick, usually from a StreamDispatcher handler on the
+ * I/O thread. A tick replacing one that was not polled yet is counted as conflated. poll()
+ * returns the ticks updated since the previous poll, in the order their symbol and level first
+ * became dirty, so a consumer falling behind skips stale prices instead of queueing them.
+ *
+ * Memory is bounded by the number of entries given to the constructor, ticks of new symbols
+ * or levels above that limit are rejected. The entries and their open-addressing index are
+ * allocated by the constructor, so update() and poll() do not allocate, apart from poll()
+ * growing the vector it is given. All methods are thread-safe: they take a mutex held only
+ * while ticks are copied, so a poll briefly delays update() on the I/O thread.
+ */
+class TickConflator final
+{
+  public:
+    TickConflator(const TickConflator &) = delete;
+    TickConflator &operator=(const TickConflator &) = delete;
+
+    /**
+     * @brief Constructs a new TickConflator object.
+     * @param maxEntries Maximal number of symbol and level pairs, their memory is allocated up front.
+     */
+    explicit TickConflator(std::size_t maxEntries = 4096);
+
+    /**
+     * @brief Stores a tick as the latest one of its symbol and level.
+     * @param tick The received tick.
+     * @return false if the tick was rejected because the entry limit is reached.
+     */
+    bool update(const TickRecord &tick);
+
+    /**
+     * @brief Moves the ticks updated since the previous poll into a vector.
+     * @param ticks Receives the ticks, they are appended so the vector can be reused between polls.
+     * @return Number of appended ticks.
+     */
+    std::size_t poll(std::vector<TickRecord> &ticks);
+
+    /**
+     * @brief Gets the latest tick of a symbol and level, polled or not.
+     * @param symbol The symbol name.
+     * @param level The price level, 0 for the best price.
+     * @return The tick, or std::nullopt if none was received.
+     */
+    std::optional<TickRecord> latest(std::string_view symbol, int level = 0) const;
+
+    /**
+     * @brief Gets the number of symbol and level pairs with a tick not polled yet.
+     * @return Number of dirty entries.
+     */
+    std::size_t dirtyCount() const;
+
+    /**
+     * @brief Gets the number of symbol and level pairs received so far.
+     * @return Number of entries.
+     */
+    std::size_t size() const;
+
+    // Number of accepted ticks.
+    std::uint64_t updates() const;
+
+    // Number of ticks that replaced a tick before it was polled.
+    std::uint64_t conflated() const;
+
+    // Number of ticks rejected because the entry limit was reached.
+    std::uint64_t rejected() const;
+
+    /**
+     * @brief Removes all ticks and resets the counters.
+     */
+    void clear();
+
+  private:
+    struct Key
+    {
+        SymbolName symbol;
+        int level = 0;
+
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const noexcept;
+    };
+
+    struct Entry
+    {
+        TickRecord tick;
+        bool dirty = false;
+    };
+
+    // Bucket of the index holding the entry of a key, or the empty bucket where it would be added.
+    std::size_t findBucket(const Key &key) const noexcept;
+
+    const std::size_t m_maxEntries;
+
+    mutable std::mutex m_mutex;
+
+    // Open-addressing index of the entries, an entry index plus one or 0 if empty. At least half of
+    // the buckets stay empty, so probing always ends.
+    std::vector<std::size_t> m_buckets;
+
+    std::vector<Entry> m_entries;
+
+    // Indexes of the dirty entries, in the order they became dirty.
+    std::vector<std::size_t> m_dirty;
+
+    std::uint64_t m_updates;
+    std::uint64_t m_conflated;
+    std::uint64_t m_rejected;
+};
+
+} // namespace xapi
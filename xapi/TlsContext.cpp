@@ -0,0 +1,100 @@
+#include "TlsContext.hpp"
+
+namespace xapi
+{
+namespace internals
+{
+
+namespace
+{
+
+// boost::asio::ssl::context uses the SSL_CTX app data for its verify callback, so use own slot.
+int contextIndex()
+{
+    static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+} // namespace
+
+TlsContext::TlsContext() : m_context(boost::asio::ssl::context::tlsv13_client), m_mutex(), m_sessions()
+{
+    SSL_CTX *ctx = m_context.native_handle();
+    SSL_CTX_set_ex_data(ctx, contextIndex(), this);
+
+    // Sessions are kept by this object only, OpenSSL's internal cache is of no use for clients.
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, &TlsContext::onNewSession);
+}
+
+TlsContext::~TlsContext()
+{
+    clear();
+}
+
+boost::asio::ssl::context &TlsContext::context() noexcept
+{
+    return m_context;
+}
+
+bool TlsContext::resumeSession(SSL *ssl, std::string_view host)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto it = m_sessions.find(host);
+    if (it == m_sessions.end())
+    {
+        return false;
+    }
+    return SSL_set_session(ssl, it->second) == 1;
+}
+
+std::size_t TlsContext::cachedSessions() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sessions.size();
+}
+
+void TlsContext::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto &[host, session] : m_sessions)
+    {
+        SSL_SESSION_free(session);
+    }
+    m_sessions.clear();
+}
+
+int TlsContext::onNewSession(SSL *ssl, SSL_SESSION *session)
+{
+    auto *self = static_cast<TlsContext *>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), contextIndex()));
+    const char *host = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+    if (self == nullptr || host == nullptr)
+    {
+        return 0;
+    }
+
+    // Returning 1 takes over the reference to the session.
+    self->storeSession(host, session);
+    return 1;
+}
+
+void TlsContext::storeSession(std::string_view host, SSL_SESSION *session)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto it = m_sessions.find(host);
+    if (it != m_sessions.end())
+    {
+        SSL_SESSION_free(it->second);
+        it->second = session;
+    }
+    else
+    {
+        m_sessions.emplace(std::string(host), session);
+    }
+}
+
+} // namespace internals
+} // namespace xapi
@@ -0,0 +1,83 @@
+#pragma once
+
+/**
+ * @file TlsContext.hpp
+ * @brief Defines the TlsContext class sharing TLS configuration and sessions between connections.
+ *
+ * This file contains the definition of the TlsContext class, which owns the SSL context used by
+ * connections and caches TLS sessions per host, so that later connections resume them.
+ */
+
+#include <boost/asio/ssl.hpp>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace xapi
+{
+namespace internals
+{
+
+/**
+ * @class TlsContext
+ * @brief SSL context with a client-side TLS session cache keyed by server name.
+ *
+ * Sessions (TLS 1.3 tickets) received on one connection are offered on the next connection
+ * to the same host, which then completes an abbreviated handshake without certificate
+ * exchange. Falls back to a full handshake when the server does not accept the session.
+ */
+class TlsContext final
+{
+  public:
+    TlsContext();
+
+    // The SSL context keeps a pointer to this object.
+    TlsContext(const TlsContext &) = delete;
+    TlsContext &operator=(const TlsContext &) = delete;
+    TlsContext(TlsContext &&) = delete;
+    TlsContext &operator=(TlsContext &&) = delete;
+
+    ~TlsContext();
+
+    /**
+     * @brief Gets the SSL context to create streams with.
+     * @return The SSL context.
+     */
+    boost::asio::ssl::context &context() noexcept;
+
+    /**
+     * @brief Offers the cached session of the host to a stream, to be called before the handshake.
+     * @param ssl The native handle of the stream, with the server name already set.
+     * @param host The server name.
+     * @return True if a cached session was offered.
+     */
+    bool resumeSession(SSL *ssl, std::string_view host);
+
+    /**
+     * @brief Gets the number of hosts with a cached session.
+     * @return The number of cached sessions.
+     */
+    std::size_t cachedSessions() const;
+
+    /**
+     * @brief Drops all cached sessions.
+     */
+    void clear();
+
+  private:
+    boost::asio::ssl::context m_context;
+
+    mutable std::mutex m_mutex;
+
+    // Latest session received from each host, one reference owned by the cache.
+    std::map<std::string, SSL_SESSION *, std::less<>> m_sessions;
+
+    // Called by OpenSSL when a connection receives a new session.
+    static int onNewSession(SSL *ssl, SSL_SESSION *session);
+
+    void storeSession(std::string_view host, SSL_SESSION *session);
+};
+
+} // namespace internals
+} // namespace xapi
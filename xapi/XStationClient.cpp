@@ -1,46 +1,82 @@
 #include "XStationClient.hpp"
+#include "ChartParser.hpp"
 #include "Exceptions.hpp"
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <boost/asio/experimental/awaitable_operators.hpp>
 
 namespace xapi
 {
 
-const std::unordered_set<std::string> XStationClient::m_knownAccountTypes = {"demo", "real"};
+template <typename ConnectionType>
+const std::unordered_set<std::string> BasicXStationClient<ConnectionType>::m_knownAccountTypes = {"demo", "real"};
+
+template <typename ConnectionType>
+BasicXStationClient<ConnectionType>::BasicXStationClient(boost::asio::io_context &ioContext,
+                                                         const std::string &accountId, const std::string &password,
+                                                         const std::string &accountType)
+    : m_ioContext(ioContext), m_strand(boost::asio::make_strand(ioContext)),
+      m_rateLimiter(std::make_shared<internals::RateLimiter>()),
+      m_tlsContext(std::make_shared<internals::TlsContext>()),
+      m_metrics(std::make_shared<internals::MetricsRecorder>()),
+      m_connection(std::make_unique<internals::Connection>(m_strand, m_rateLimiter, m_tlsContext, m_metrics)),
+      m_accountId(accountId), m_password(password), m_accountType(accountType), m_serverUrl("wss://ws.xtb.com"),
+      m_safeMode(true), m_streamSessionId(""), m_recorder()
+{
+}
 
-XStationClient::XStationClient(boost::asio::io_context &ioContext, const std::string &accountId,
-                               const std::string &password, const std::string &accountType)
-    : m_ioContext(ioContext), m_connection(std::make_unique<internals::Connection>(ioContext)), m_accountId(accountId), m_password(password),
-      m_accountType(accountType), m_safeMode(true), m_streamSessionId("")
+template <typename ConnectionType>
+BasicXStationClient<ConnectionType>::BasicXStationClient(boost::asio::io_context &ioContext,
+                                                         const boost::json::object &accountCredentials)
+    : BasicXStationClient(ioContext,
+                          std::string(accountCredentials.at("accountId").as_string()),
+                          std::string(accountCredentials.at("password").as_string()),
+                          std::string(accountCredentials.at("accountType").as_string()))
 {
 }
 
-XStationClient::XStationClient(boost::asio::io_context &ioContext, const boost::json::object &accountCredentials)
-    : XStationClient(ioContext,
-                     std::string(accountCredentials.at("accountId").as_string()),
-                     std::string(accountCredentials.at("password").as_string()),
-                     std::string(accountCredentials.at("accountType").as_string()))
+template <typename ConnectionType>
+BasicXStationClient<ConnectionType>::BasicXStationClient(boost::asio::io_context &ioContext,
+                                                         std::unique_ptr<ConnectionType> connection)
+    : m_ioContext(ioContext), m_strand(boost::asio::make_strand(ioContext)),
+      m_rateLimiter(std::make_shared<internals::RateLimiter>()),
+      m_tlsContext(std::make_shared<internals::TlsContext>()),
+      m_metrics(std::make_shared<internals::MetricsRecorder>()),
+      m_connection(std::move(connection)),
+      m_accountId(), m_password(), m_accountType("demo"), m_serverUrl("wss://ws.xtb.com"),
+      m_safeMode(true), m_streamSessionId(""), m_recorder()
 {
 }
 
-boost::asio::awaitable<void> XStationClient::login() {
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClient<ConnectionType>::login()
+{
+    if (!runsOnStrand(co_await boost::asio::this_coro::executor))
+    {
+        co_return co_await boost::asio::co_spawn(m_strand, login(), boost::asio::use_awaitable);
+    }
     validateAccountType(m_accountType);
 
-    const boost::url socketUrl = boost::urls::format("wss://ws.xtb.com/{}", m_accountType);
+    boost::url socketUrl(m_serverUrl);
+    socketUrl.set_path("/" + m_accountType);
     co_await m_connection->connect(socketUrl);
 
-    boost::json::object command = {
-        {"command", "login"},
-        {"arguments", {
-            {"userId", m_accountId},
-            {"password", m_password}
-        }}
-    };
+    internals::Command command("login");
+    command.beginObject("arguments")
+        .add("userId", m_accountId)
+        .add("password", m_password)
+        .endObject();
     auto result = co_await request(command);
 
-    if (!result.contains("status") && !result.contains("streamSessionId")) {
+    if (!result.contains("status") && !result.contains("streamSessionId"))
+    {
         throw exception::LoginFailed("Invalid response from the server");
     }
 
     if (result["status"].as_bool() != true)
+
     {
         throw exception::LoginFailed(boost::json::serialize(result));
     }
@@ -48,284 +84,419 @@ boost::asio::awaitable<void> XStationClient::login() {
     m_streamSessionId = result["streamSessionId"].as_string();
 }
 
-boost::asio::awaitable<void> XStationClient::logout() {
-    boost::json::object command = {
-        {"command", "logout"}
-    };
+template <typename ConnectionType>
+boost::asio::awaitable<BasicXStationClientStream<ConnectionType>> BasicXStationClient<ConnectionType>::loginWithStream()
+{
+    using namespace boost::asio::experimental::awaitable_operators;
+
+    validateAccountType(m_accountType);
+
+    // The stream server does not need the session ID to accept the connection, only the commands do.
+    BasicXStationClientStream<ConnectionType> stream = getClientStream();
+    std::exception_ptr error;
+    try
+    {
+        co_await (login() && stream.open());
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    if (error)
+    {
+        // Either connection may be open already, the failing operation cancelled the other one
+        co_await stream.close();
+        co_await boost::asio::co_spawn(m_strand, m_connection->disconnect(), boost::asio::use_awaitable);
+        std::rethrow_exception(error);
+    }
+
+    stream.setStreamSessionId(m_streamSessionId);
+    co_return stream;
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClient<ConnectionType>::logout()
+{
+    if (!runsOnStrand(co_await boost::asio::this_coro::executor))
+    {
+        co_return co_await boost::asio::co_spawn(m_strand, logout(), boost::asio::use_awaitable);
+    }
+    const internals::Command command("logout");
     co_await request(command);
     co_await m_connection->disconnect();
-
 }
 
-void XStationClient::setSafeMode(bool safeMode) {
+template <typename ConnectionType>
+void BasicXStationClient<ConnectionType>::setSafeMode(bool safeMode)
+{
     m_safeMode = safeMode;
 }
 
-XStationClientStream XStationClient::getClientStream() const {
-    XStationClientStream stream(m_ioContext, m_accountType, m_streamSessionId);
+template <typename ConnectionType>
+void BasicXStationClient<ConnectionType>::setServerUrl(const std::string &serverUrl)
+{
+    m_serverUrl = serverUrl;
+}
+
+template <typename ConnectionType>
+MetricsSnapshot BasicXStationClient<ConnectionType>::metrics() const
+{
+    return m_metrics->snapshot();
+}
+
+template <typename ConnectionType>
+void BasicXStationClient<ConnectionType>::resetMetrics()
+{
+    m_metrics->reset();
+}
+
+template <typename ConnectionType>
+void BasicXStationClient<ConnectionType>::setRateLimit(std::size_t burstSize, double requestsPerSecond)
+{
+    m_rateLimiter->configure(burstSize, requestsPerSecond);
+}
+
+template <typename ConnectionType>
+void BasicXStationClient<ConnectionType>::setRecorder(std::shared_ptr<SessionRecorder> recorder)
+{
+    m_recorder = std::move(recorder);
+    configureConnection();
+}
+
+template <typename ConnectionType>
+BasicXStationClientStream<ConnectionType> BasicXStationClient<ConnectionType>::getClientStream()
+{
+    BasicXStationClientStream<ConnectionType> stream(m_ioContext, m_accountType, m_streamSessionId, m_rateLimiter,
+                                                     m_tlsContext);
+    stream.setServerUrl(m_serverUrl);
+    // The stream runs on its own strand, the session is refreshed on the client strand.
+    stream.setSessionRefresher(
+        [this]() { return boost::asio::co_spawn(m_strand, refreshStreamSession(), boost::asio::use_awaitable); });
     return stream;
 }
 
+template <typename ConnectionType>
+const internals::Connection::Strand &BasicXStationClient<ConnectionType>::executor() const noexcept
+{
+    return m_strand;
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<SymbolCatalog> BasicXStationClient<ConnectionType>::getSymbolCatalog(
+    const std::filesystem::path &file, std::chrono::seconds maxAge)
+{
+    std::optional<SymbolCatalog> cached;
+    try
+    {
+        cached.emplace(SymbolCatalog::load(file));
+    }
+    catch (const std::exception &)
+    {
+        // Missing or written by another version, downloaded again below.
+    }
+
+    const auto now = SymbolCatalog::Clock::now();
+    if (cached && now - cached->validatedAt() < maxAge)
+    {
+        co_return std::move(*cached);
+    }
+
+    const auto versionResponse = co_await getVersion();
+    std::string version;
+    const auto *versionData = versionResponse.if_contains("returnData");
+    if (versionData && versionData->is_object() && versionData->as_object().contains("version") &&
+        versionData->as_object().at("version").is_string())
+    {
+        version = versionData->as_object().at("version").as_string().c_str();
+    }
+
+    // Only the stored part of the version is compared.
+    if (cached && !version.empty() && cached->serverVersion() == std::string_view(version).substr(0, 23))
+    {
+        SymbolCatalog::touch(file, now);
+        co_return std::move(*cached);
+    }
+
+    const auto symbolsResponse = co_await getAllSymbols();
+    const auto *symbols = symbolsResponse.if_contains("returnData");
+    if (symbols == nullptr || !symbols->is_array())
+    {
+        throw std::runtime_error("getAllSymbols did not return the symbols");
+    }
+
+    SymbolCatalog::build(symbols->as_array(), version, now).save(file);
+    co_return SymbolCatalog::load(file);
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<std::vector<Candle>> BasicXStationClient<ConnectionType>::getCachedChartRange(
+    CandleStore &store, const std::string &symbol, std::int64_t start, std::int64_t end, PeriodCode period)
+{
+    const std::int64_t periodMs = static_cast<std::int64_t>(period) * 60'000;
+    const std::int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch())
+                                 .count();
+
+    std::vector<Candle> candles;
+    for (const TimeRange &window : store.missing(symbol, period, TimeRange{start, end}))
+    {
+        const auto result = co_await getChartRangeRequest(symbol, window.start, window.end, period, 0);
+
+        candles.clear();
+        const int digits = internals::parseChart(result, candles);
+        store.merge(symbol, period, TimeRange{window.start, std::min(window.end, now - periodMs)}, candles, digits);
+    }
+
+    co_return store.read(symbol, period, TimeRange{start, end});
+}
 
-boost::asio::awaitable<boost::json::object> XStationClient::getAllSymbols()
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getAllSymbols()
 {
-    boost::json::object command = {
-        {"command", "getAllSymbols"}
-    };   
+    const internals::Command command("getAllSymbols");
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getCalendar()
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getCalendar()
 {
-    boost::json::object command = {
-        {"command", "getCalendar"}
-    };
+    const internals::Command command("getCalendar");
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getChartLastRequest(const std::string &symbol, const std::int64_t start,
-                                                                PeriodCode period)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getChartLastRequest(
+    const std::string &symbol, const std::int64_t start, PeriodCode period)
 {
-    boost::json::object command = {
-        {"command", "getChartLastRequest"},
-        {"arguments", {
-            {"info", {
-                {"period", static_cast<int>(period)},
-                {"start", start},
-                {"symbol", symbol}
-            }}
-        }}
-    };
+    internals::Command command("getChartLastRequest");
+    command.beginObject("arguments")
+        .beginObject("info")
+            .add("period", static_cast<int>(period))
+            .add("start", start)
+            .add("symbol", symbol)
+        .endObject()
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getChartRangeRequest(const std::string &symbol, std::int64_t start, std::int64_t end,
-                                                                 PeriodCode period, int ticks)
-{
-    boost::json::object command = {
-        {"command", "getChartRangeRequest"},
-        {"arguments", {
-            {"info", {
-                {"end", end},
-                {"period", static_cast<int>(period)},
-                {"start", start},
-                {"symbol", symbol},
-                {"ticks", ticks}
-            }}
-        }}
-    };
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getChartRangeRequest(
+    const std::string &symbol, std::int64_t start, std::int64_t end, PeriodCode period, int ticks)
+{
+    internals::Command command("getChartRangeRequest");
+    command.beginObject("arguments")
+        .beginObject("info")
+            .add("end", end)
+            .add("period", static_cast<int>(period))
+            .add("start", start)
+            .add("symbol", symbol)
+            .add("ticks", ticks)
+        .endObject()
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getCommissionDef(const std::string &symbol, float volume)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getCommissionDef(
+    const std::string &symbol, float volume)
 {
-    boost::json::object command = {
-        {"command", "getCommissionDef"},
-        {"arguments", {
-            {"symbol", symbol},
-            {"volume", volume}
-        }}
-    };
+    internals::Command command("getCommissionDef");
+    command.beginObject("arguments")
+        .add("symbol", symbol)
+        .add("volume", volume)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getCurrentUserData()
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getCurrentUserData()
 {
-    boost::json::object command = {
-        {"command", "getCurrentUserData"}
-    };
+    const internals::Command command("getCurrentUserData");
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getIbsHistory(std::int64_t start, std::int64_t end)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getIbsHistory(
+    std::int64_t start, std::int64_t end)
 {
-    boost::json::object command = {
-        {"command", "getIbsHistory"},
-        {"arguments", {
-            {"start", start},
-            {"end", end}
-        }}
-    };
+    internals::Command command("getIbsHistory");
+    command.beginObject("arguments")
+        .add("start", start)
+        .add("end", end)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getMarginLevel()
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getMarginLevel()
 {
-    boost::json::object command = {
-        {"command", "getMarginLevel"}
-    };
+    const internals::Command command("getMarginLevel");
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getMarginTrade(const std::string &symbol, float volume)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getMarginTrade(
+    const std::string &symbol, float volume)
 {
-    boost::json::object command = {
-        {"command", "getMarginTrade"},
-        {"arguments", {
-            {"symbol", symbol},
-            {"volume", volume}
-        }}
-    };
+    internals::Command command("getMarginTrade");
+    command.beginObject("arguments")
+        .add("symbol", symbol)
+        .add("volume", volume)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getNews(std::int64_t start, std::int64_t end)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getNews(
+    std::int64_t start, std::int64_t end)
 {
-    boost::json::object command = {
-        {"command", "getNews"},
-        {"arguments", {
-            {"start", start},
-            {"end", end}
-        }}
-    };
+    internals::Command command("getNews");
+    command.beginObject("arguments")
+        .add("start", start)
+        .add("end", end)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getProfitCalculation(const std::string &symbol, int cmd, float openPrice,
-                                                                 float closePrice, float volume)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getProfitCalculation(
+    const std::string &symbol, int cmd, float openPrice, float closePrice, float volume)
 {
-    boost::json::object command = {
-        {"command", "getProfitCalculation"},
-        {"arguments", {
-            {"symbol", symbol},
-            {"cmd", cmd},
-            {"openPrice", openPrice},
-            {"closePrice", closePrice},
-            {"volume", volume}
-        }}
-    };
+    internals::Command command("getProfitCalculation");
+    command.beginObject("arguments")
+        .add("symbol", symbol)
+        .add("cmd", cmd)
+        .add("openPrice", openPrice)
+        .add("closePrice", closePrice)
+        .add("volume", volume)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getServerTime()
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getServerTime()
 {
-    boost::json::object command = {
-        {"command", "getServerTime"}
-    };
+    const internals::Command command("getServerTime");
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getStepRules()
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getStepRules()
 {
-    boost::json::object command = {
-        {"command", "getStepRules"}
-    };
+    const internals::Command command("getStepRules");
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getSymbol(const std::string &symbol)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getSymbol(const std::string &symbol)
 {
-    boost::json::object command = {
-        {"command", "getSymbol"},
-        {"arguments", {
-            {"symbol", symbol}
-        }}
-    };
+    internals::Command command("getSymbol");
+    command.beginObject("arguments")
+        .add("symbol", symbol)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getTickPrices(const std::vector<std::string> &symbols, std::int64_t timestamp,
-                                                          int level)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getTickPrices(
+    const std::vector<std::string> &symbols, std::int64_t timestamp, int level)
 {
-    boost::json::object command = {
-        {"command", "getTickPrices"},
-        {"arguments", {
-            {"symbols", boost::json::array(symbols.begin(), symbols.end())},
-            {"timestamp", timestamp},
-            {"level", level}
-        }}
-    };
+    internals::Command command("getTickPrices");
+    command.beginObject("arguments")
+        .add("symbols", symbols)
+        .add("timestamp", timestamp)
+        .add("level", level)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getTradeRecords(const std::vector<int> &orders)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getTradeRecords(
+    const std::vector<int> &orders)
 {
-    boost::json::object command = {
-        {"command", "getTradeRecords"},
-        {"arguments", {
-            {"orders", boost::json::array(orders.begin(), orders.end())}
-        }}
-    };
+    internals::Command command("getTradeRecords");
+    command.beginObject("arguments")
+        .add("orders", orders)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getTrades(bool openedOnly)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getTrades(bool openedOnly)
 {
-    boost::json::object command = {
-        {"command", "getTrades"},
-        {"arguments", {
-            {"openedOnly", openedOnly}
-        }}
-    };
+    internals::Command command("getTrades");
+    command.beginObject("arguments")
+        .add("openedOnly", openedOnly)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getTradesHistory(std::int64_t start, std::int64_t end)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getTradesHistory(
+    std::int64_t start, std::int64_t end)
 {
-    boost::json::object command = {
-        {"command", "getTradesHistory"},
-        {"arguments", {
-            {"start", start},
-            {"end", end}
-        }}
-    };
+    internals::Command command("getTradesHistory");
+    command.beginObject("arguments")
+        .add("start", start)
+        .add("end", end)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getTradingHours(const std::vector<std::string> &symbols)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getTradingHours(
+    const std::vector<std::string> &symbols)
 {
-    boost::json::object command = {
-        {"command", "getTradingHours"},
-        {"arguments", {
-            {"symbols", boost::json::array(symbols.begin(), symbols.end())}
-        }}
-    };
+    internals::Command command("getTradingHours");
+    command.beginObject("arguments")
+        .add("symbols", symbols)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::getVersion()
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::getVersion()
 {
-    boost::json::object command = {
-        {"command", "getVersion"}
-    };
+    const internals::Command command("getVersion");
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::ping()
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::ping()
 {
-    boost::json::object command = {
-        {"command", "ping"}
-    };
+    const internals::Command command("ping");
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::tradeTransaction(const std::string &symbol, TradeCmd cmd, TradeType type,
-                                                             float price, float volume, float sl, float tp, int order,
-                                                             std::int64_t expiration, int offset,
-                                                             const std::string &customComment)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::tradeTransaction(
+    const std::string &symbol, TradeCmd cmd, TradeType type, float price, float volume, float sl, float tp, int order,
+    std::int64_t expiration, int offset, const std::string &customComment)
 {
-    if (m_safeMode) {
+    if (m_safeMode)
+    {
         boost::json::object response = {
             {"status", false},
             {"errorCode", "N/A"},
@@ -334,49 +505,102 @@ boost::asio::awaitable<boost::json::object> XStationClient::tradeTransaction(con
         co_return response;
     }
 
-    boost::json::object command = {
-        {"command", "tradeTransaction"},
-        {"arguments", {
-            {"tradeTransInfo", {
-                {"cmd", static_cast<int>(cmd)},
-                {"customComment", customComment},
-                {"expiration", expiration},
-                {"offset", offset},
-                {"order", order},
-                {"price", price},
-                {"sl", sl},
-                {"symbol", symbol},
-                {"tp", tp},
-                {"type", static_cast<int>(type)},
-                {"volume", volume}
-            }}
-        }}
-    };
+    internals::Command command("tradeTransaction");
+    command.beginObject("arguments")
+        .beginObject("tradeTransInfo")
+            .add("cmd", static_cast<int>(cmd))
+            .add("customComment", customComment)
+            .add("expiration", expiration)
+            .add("offset", offset)
+            .add("order", order)
+            .add("price", price)
+            .add("sl", sl)
+            .add("symbol", symbol)
+            .add("tp", tp)
+            .add("type", static_cast<int>(type))
+            .add("volume", volume)
+        .endObject()
+        .endObject();
 
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::tradeTransactionStatus(int order)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::tradeTransactionStatus(int order)
 {
-    boost::json::object command = {
-        {"command", "tradeTransactionStatus"},
-        {"arguments", {
-            {"order", order}
-        }}
-    };
+    internals::Command command("tradeTransactionStatus");
+    command.beginObject("arguments")
+        .add("order", order)
+        .endObject();
     auto result = co_await request(command);
     co_return result;
 }
 
-boost::asio::awaitable<boost::json::object> XStationClient::request(const boost::json::object &command)
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClient<ConnectionType>::request(
+    const internals::Command &command)
 {
-    co_await m_connection->makeRequest(command);
-    auto result = co_await m_connection->waitResponse();
-    co_return result;
+    // m_connection is replaced on the strand when the session is refreshed, so it is only read there
+    if (!runsOnStrand(co_await boost::asio::this_coro::executor))
+    {
+        co_return co_await boost::asio::co_spawn(m_strand, request(command), boost::asio::use_awaitable);
+    }
+    co_return co_await m_connection->request(command);
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<std::string> BasicXStationClient<ConnectionType>::refreshStreamSession()
+{
+    bool sessionValid = false;
+    try
+    {
+        auto result = co_await ping();
+        sessionValid = result.contains("status") && result["status"].as_bool();
+    }
+    catch (const exception::ConnectionClosed &)
+    {
+        sessionValid = false;
+    }
+
+    if (!sessionValid)
+    {
+        // The old connection cannot be reused once closed, log in on a new one. Requests still in
+        // flight on the old one fail, it is destroyed once disconnect() has waited for them.
+        std::unique_ptr<ConnectionType> retired = std::exchange(
+            m_connection, std::make_unique<internals::Connection>(m_strand, m_rateLimiter, m_tlsContext, m_metrics));
+        configureConnection();
+        try
+        {
+            co_await retired->disconnect();
+        }
+        catch (const exception::ConnectionClosed &)
+        {
+            // Already closed
+        }
+        co_await login();
+    }
+    co_return m_streamSessionId;
+}
+
+template <typename ConnectionType>
+void BasicXStationClient<ConnectionType>::configureConnection()
+{
+    if (auto *connection = dynamic_cast<internals::Connection *>(m_connection.get()))
+    {
+        connection->setRecorder(m_recorder);
+    }
+}
+
+template <typename ConnectionType>
+bool BasicXStationClient<ConnectionType>::runsOnStrand(const boost::asio::any_io_executor &executor) const noexcept
+{
+    const auto *strand = executor.target<internals::Connection::Strand>();
+    return strand != nullptr && *strand == m_strand;
 }
 
-void XStationClient::validateAccountType(const std::string &accountType)
+template <typename ConnectionType>
+void BasicXStationClient<ConnectionType>::validateAccountType(const std::string &accountType)
 {
     if (m_knownAccountTypes.find(accountType) == m_knownAccountTypes.end())
     {
@@ -385,4 +609,7 @@ void XStationClient::validateAccountType(const std::string &accountType)
     }
 }
 
+template class BasicXStationClient<internals::IConnection>;
+template class BasicXStationClient<internals::Connection>;
+
 } // namespace xapi
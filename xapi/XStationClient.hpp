@@ -4,11 +4,14 @@
  * @file XStationClient.hpp
  * @brief Defines the XStationClient class for retrieving trading data.
  *
- * This file contains the definition of the XStationClient class, which encapsulates
- * operations for retrieving trading data from xAPI.
+ * This file contains the definition of the BasicXStationClient class template, which encapsulates
+ * operations for retrieving trading data from xAPI, and its XStationClient and DirectXStationClient
+ * variants.
  */
 
+#include "CandleStore.hpp"
 #include "Connection.hpp"
+#include "SymbolCatalog.hpp"
 #include "XStationClientStream.hpp"
 #include "Enums.hpp"
 #include <unordered_set>
@@ -19,8 +22,10 @@
 class XStationClientTest;
 #define TEST_FRIENDS \
     friend class XStationClientTest; \
+    friend class HistoryDownloaderTest; \
     FRIEND_TEST(XStationClientTest, login_ok); \
     FRIEND_TEST(XStationClientTest, login_invalid_account_type); \
+    FRIEND_TEST(XStationClientTest, loginWithStream_invalid_account_type); \
     FRIEND_TEST(XStationClientTest, login_account_credentials_null); \
     FRIEND_TEST(XStationClientTest, login_invalid_return_from_the_server);
 #else
@@ -33,23 +38,26 @@ namespace xapi
 /**
  * @brief Encapsulates operations for retrieving trading data from xAPI.
  *
- * The XStationClient class provides a high-level interface for retrieving trading data
+ * The BasicXStationClient class provides a high-level interface for retrieving trading data
  * from xAPI. It is built on top of the Connection class, which handles the
- * low-level details of establishing and maintaining a connection.
+ * low-level details of establishing and maintaining a connection. ConnectionType is
+ * internals::IConnection, so that any connection can be used, or internals::Connection,
+ * so that requests call the connection without virtual dispatch.
+ * @tparam ConnectionType internals::IConnection or internals::Connection.
  */
-class XStationClient final
+template <typename ConnectionType> class BasicXStationClient final
 {
   public:
-    XStationClient() = delete;
+    BasicXStationClient() = delete;
 
-    XStationClient(const XStationClient &) = delete;
-    XStationClient &operator=(const XStationClient &) = delete;
+    BasicXStationClient(const BasicXStationClient &) = delete;
+    BasicXStationClient &operator=(const BasicXStationClient &) = delete;
 
-    XStationClient(XStationClient &&other) = default;
-    XStationClient &operator=(XStationClient &&other) = delete;
+    BasicXStationClient(BasicXStationClient &&other) = default;
+    BasicXStationClient &operator=(BasicXStationClient &&other) = delete;
 
     /**
-     * @brief Constructs a new XStationClient object.
+     * @brief Constructs a new BasicXStationClient object.
      * @param ioContext The IO context for asynchronous operations.
      * @param accountId The account ID to use for the client.
      * @param password The password to use for the client.
@@ -60,11 +68,11 @@ class XStationClient final
      *
      *      - `"real"` for a real money account.
      */
-    explicit XStationClient(boost::asio::io_context &ioContext, const std::string &accountId,
-                            const std::string &password, const std::string &accountType = "demo");
+    explicit BasicXStationClient(boost::asio::io_context &ioContext, const std::string &accountId,
+                                 const std::string &password, const std::string &accountType = "demo");
 
     /**
-     * @brief Constructs a new XStationClient object.
+     * @brief Constructs a new BasicXStationClient object.
      *
      * Initializes the client with the provided IO context and account credentials.
      *
@@ -79,9 +87,19 @@ class XStationClient final
      *    - `accountType`: The type of account. Possible values are: `"demo"` or `"real"`
      *
      */
-    explicit XStationClient(boost::asio::io_context &ioContext, const boost::json::object &accountCredentials);
+    explicit BasicXStationClient(boost::asio::io_context &ioContext, const boost::json::object &accountCredentials);
+
+    /**
+     * @brief Constructs a client sending its requests to a given connection, for example a ReplayConnection.
+     *
+     * The client has no credentials, login() only connects the connection and sends an empty login.
+     * Sessions refreshed for a client stream are opened on a new Connection.
+     * @param ioContext The IO context for asynchronous operations.
+     * @param connection The connection to send the requests to.
+     */
+    explicit BasicXStationClient(boost::asio::io_context &ioContext, std::unique_ptr<ConnectionType> connection);
     
-    ~XStationClient() = default;
+    ~BasicXStationClient() = default;
 
     /**
      * @brief Opens connection to the server and logs in.
@@ -91,6 +109,18 @@ class XStationClient final
      */
     boost::asio::awaitable<void> login();
 
+    /**
+     * @brief Logs in and opens the client stream at the same time.
+     *
+     * The stream connection is established concurrently with the login, so the two connection
+     * setups overlap. The stream gets the stream session ID once the login completes. If either
+     * fails, both connections are closed before the error is rethrown.
+     * @return An awaitable client stream, already open.
+     * @throw xapi::exception::ConnectionClosed if either connection fails.
+     * @throw xapi::exception::LoginFailed if the login fails.
+     */
+    boost::asio::awaitable<BasicXStationClientStream<ConnectionType>> loginWithStream();
+
     /**
      * @brief Logs out from the server and closes the connection(if not closed by server).
      * @return An awaitable void.
@@ -104,11 +134,98 @@ class XStationClient final
      */
     void setSafeMode(bool safeMode);
 
+    /**
+     * @brief Sets the server to connect to, for example a local mock server.
+     * @param serverUrl The server URL without path, by default `wss://ws.xtb.com`.
+     * The account type is appended as the path, for example `wss://ws.xtb.com/demo`.
+     */
+    void setServerUrl(const std::string &serverUrl);
+
+    /**
+     * @brief Gets the request metrics of the client.
+     *
+     * For every command, histograms of the time spent waiting for the rate limiter, of the round trip
+     * from the write until the response arrives and of the response parsing. Also the number of
+     * messages and bytes sent and received on the client connection.
+     * @return A copy of the current metrics.
+     */
+    MetricsSnapshot metrics() const;
+
+    /**
+     * @brief Clears the request metrics of the client.
+     */
+    void resetMetrics();
+
+    /**
+     * @brief Sets the request rate limit shared by this client and its client streams.
+     * @param burstSize Maximum number of requests that can be sent without delay.
+     * @param requestsPerSecond Sustained number of requests per second.
+     */
+    void setRateLimit(std::size_t burstSize, double requestsPerSecond);
+
+    /**
+     * @brief Records every message received by the client, also on the connection opened when
+     * the session is refreshed for a client stream. The connection reads on the client strand,
+     * so call it before login() or from a coroutine running on executor().
+     * @param recorder The journal recorder, null to stop recording.
+     */
+    void setRecorder(std::shared_ptr<SessionRecorder> recorder);
+
     /**
      * @brief Gets the client stream object.
-     * @return The XStationClientStream object.
+     *
+     * When the stream reconnects, it re-validates the session through this client, logging in
+     * again if the main connection dropped too. The client must outlive the stream.
+     * @return The client stream object.
+     */
+    BasicXStationClientStream<ConnectionType> getClientStream();
+
+    /**
+     * @brief Gets the strand the connections of the client run on.
+     *
+     * Requests can be made from any thread of the IO context. Coroutines spawned on this
+     * executor call the connection directly, other coroutines hop to the strand and back on
+     * every request. The client itself is not synchronized: login, logout and setters must not
+     * run concurrently with other calls.
+     * @return The strand.
+     */
+    const internals::Connection::Strand &executor() const noexcept;
+
+    /**
+     * @brief Gets the symbol catalog, from a local file while it is valid.
+     *
+     * A file validated less than maxAge ago is mapped without any request. An older file is
+     * revalidated with getVersion: if the server version is the same, only its validation time
+     * is renewed. Otherwise, or when there is no valid file, getAllSymbols is downloaded and the
+     * file is replaced.
+     * @param file The catalog file, can be shared by several processes.
+     * @param maxAge Time after which the file is revalidated.
+     * @return The catalog mapped from the file.
+     * @throw xapi::exception::ConnectionClosed if a request fails.
+     * @throw std::runtime_error if the server does not return the symbols.
+     * @throw std::system_error if the file cannot be written.
+     */
+    boost::asio::awaitable<SymbolCatalog> getSymbolCatalog(const std::filesystem::path &file,
+                                                           std::chrono::seconds maxAge = std::chrono::hours(24));
+
+    /**
+     * @brief Gets chart candles through a local candle store.
+     *
+     * Only the parts of the range missing from the store are requested with getChartRangeRequest,
+     * then the whole range is read from the store. The last period before now is not marked as
+     * fetched, since its candle may still change.
+     * @param store The candle store.
+     * @param symbol The symbol name.
+     * @param start Range start in milliseconds since epoch.
+     * @param end Range end in milliseconds since epoch, excluded.
+     * @param period The candle period.
+     * @return The candles ordered by time.
+     * @throw xapi::exception::ConnectionClosed if a request fails.
+     * @throw std::runtime_error if the server does not return the candles.
      */
-    XStationClientStream getClientStream() const;
+    boost::asio::awaitable<std::vector<Candle>> getCachedChartRange(CandleStore &store, const std::string &symbol,
+                                                                    std::int64_t start, std::int64_t end,
+                                                                    PeriodCode period);
 
     // Other methods omitted for brevity.
     // Description of the omitted methods: http://developers.xstore.pro/documentation/2.5.0#retrieving-trading-data
@@ -168,12 +285,28 @@ class XStationClient final
   private:
 
     boost::asio::io_context &m_ioContext;
-    std::unique_ptr<internals::IConnection> m_connection;
+
+    // Strand of the client connections, kept when a new connection replaces a dropped one.
+    internals::Connection::Strand m_strand;
+
+    // Rate limiter shared with the client streams of this account.
+    std::shared_ptr<internals::RateLimiter> m_rateLimiter;
+
+    // TLS context shared with the client streams, so that their connections resume the TLS session.
+    std::shared_ptr<internals::TlsContext> m_tlsContext;
+
+    // Request latencies and traffic of the client, kept across reconnects.
+    std::shared_ptr<internals::MetricsRecorder> m_metrics;
+
+    std::unique_ptr<ConnectionType> m_connection;
 
     const std::string m_accountId;
     const std::string m_password;
     const std::string m_accountType;
 
+    // The server URL without path.
+    std::string m_serverUrl;
+
     /**
      * Flag to indicate if the user operates in safe mode.
      */
@@ -181,15 +314,42 @@ class XStationClient final
 
     std::string m_streamSessionId;
 
+    // Journal of the received messages, set on every new connection.
+    std::shared_ptr<SessionRecorder> m_recorder;
+
     // Set of known account types.
     static const std::unordered_set<std::string> m_knownAccountTypes;
 
+    /**
+     * @brief Makes sure the session is valid, logging in again on a new connection if it is not.
+     * @return An awaitable std::string with the valid stream session ID.
+     * @throw xapi::exception::ConnectionClosed if the connection fails.
+     * @throw xapi::exception::LoginFailed if logging in again fails.
+     */
+    boost::asio::awaitable<std::string> refreshStreamSession();
+
+    /**
+     * @brief Applies the recorder to the current connection, if it is a Connection.
+     */
+    void configureConnection();
+
     /**
      * @brief Sends a request to the server and waits for response.
-     * @param command The command to send as a boost::json::object.
+     *
+     * Requests are correlated with their responses by customTag, so several coroutines
+     * can have requests in flight on the same client at once. Requests made from another
+     * executor are moved to the client strand.
+     * @param command The command to send.
      * @return An awaitable boost::json::object with the response from the server.
      */
-    boost::asio::awaitable<boost::json::object> request(const boost::json::object &command);
+    boost::asio::awaitable<boost::json::object> request(const internals::Command &command);
+
+    /**
+     * @brief Checks whether a coroutine runs on the client strand.
+     * @param executor The executor of the coroutine.
+     * @return True if the coroutine can use the connection directly.
+     */
+    bool runsOnStrand(const boost::asio::any_io_executor &executor) const noexcept;
 
     /**
      * @brief Validates the account type.
@@ -201,4 +361,17 @@ class XStationClient final
     TEST_FRIENDS
 };
 
+/**
+ * @brief Client reaching the connection through internals::IConnection, returns XStationClientStream.
+ */
+using XStationClient = BasicXStationClient<internals::IConnection>;
+
+/**
+ * @brief Client calling the WebSocket connection directly, returns DirectXStationClientStream.
+ */
+using DirectXStationClient = BasicXStationClient<internals::Connection>;
+
+extern template class BasicXStationClient<internals::IConnection>;
+extern template class BasicXStationClient<internals::Connection>;
+
 } // namespace xapi
@@ -1,179 +1,453 @@
 #include "XStationClientStream.hpp"
 #include "Exceptions.hpp"
+#include <algorithm>
 
 namespace xapi
 {
 
-XStationClientStream::XStationClientStream(boost::asio::io_context &ioContext, const std::string &accountType, const std::string& streamSessionId) 
-: m_connection(std::make_unique<internals::Connection>(ioContext)), m_streamUrl(boost::urls::format("wss://ws.xtb.com/{}Stream", accountType)), m_streamSessionId(streamSessionId)
+namespace
 {
+
+// Reads through ConnectionType, so that DirectXStationClientStream calls Connection without virtual dispatch.
+constexpr auto waitFrame = [](auto &connection) { return connection.waitFrame(); };
+constexpr auto waitResponse = [](auto &connection) { return connection.waitResponse(); };
+
+} // namespace
+
+template <typename ConnectionType>
+BasicXStationClientStream<ConnectionType>::BasicXStationClientStream(
+    boost::asio::io_context &ioContext, const std::string &accountType, const std::string &streamSessionId,
+    std::shared_ptr<internals::RateLimiter> rateLimiter, std::shared_ptr<internals::TlsContext> tlsContext)
+    : m_connection(), m_executor(), m_connectionFactory(), m_recordParser(), m_accountType(accountType),
+      m_streamUrl(boost::urls::format("wss://ws.xtb.com/{}Stream", accountType)),
+      m_streamSessionMember("streamSessionId", streamSessionId), m_subscriptions(), m_reconnectPolicy(),
+      m_sessionRefresher(), m_random(std::random_device{}()), m_reconnectCount(0), m_closed(false), m_recorder(),
+      m_arenaParsing(false)
+{
+    const auto strand = boost::asio::make_strand(ioContext);
+    m_executor = strand;
+    m_connectionFactory = [strand, rateLimiter,
+                           tlsContext = tlsContext ? tlsContext : std::make_shared<internals::TlsContext>()]() {
+        return std::make_unique<internals::Connection>(strand, rateLimiter, tlsContext);
+    };
+    m_connection = m_connectionFactory();
+}
+
+template <typename ConnectionType>
+BasicXStationClientStream<ConnectionType>::BasicXStationClientStream(std::unique_ptr<ConnectionType> connection)
+    : m_connection(std::move(connection)), m_executor(), m_connectionFactory(), m_recordParser(), m_accountType(),
+      m_streamUrl(), m_streamSessionMember("streamSessionId", ""), m_subscriptions(), m_reconnectPolicy(),
+      m_sessionRefresher(), m_random(std::random_device{}()), m_reconnectCount(0), m_closed(false), m_recorder(),
+      m_arenaParsing(false)
+{
+}
+
+template <typename ConnectionType>
+const boost::asio::any_io_executor &BasicXStationClientStream<ConnectionType>::executor() const noexcept
+{
+    return m_executor;
+}
+
+template <typename ConnectionType>
+bool BasicXStationClientStream<ConnectionType>::runsOnExecutor(
+    const boost::asio::any_io_executor &executor) const noexcept
+{
+    return !m_executor || executor == m_executor;
 }
 
-boost::asio::awaitable<void> XStationClientStream::open()
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::open()
 {
+    if (!runsOnExecutor(co_await boost::asio::this_coro::executor))
+    {
+        co_return co_await boost::asio::co_spawn(m_executor, open(), boost::asio::use_awaitable);
+    }
+    m_closed = false;
     co_await m_connection->connect(m_streamUrl);
 }
 
-boost::asio::awaitable<void> XStationClientStream::close()
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::close()
 {
+    if (!runsOnExecutor(co_await boost::asio::this_coro::executor))
+    {
+        co_return co_await boost::asio::co_spawn(m_executor, close(), boost::asio::use_awaitable);
+    }
+    m_closed = true;
     co_await m_connection->disconnect();
 }
 
-boost::asio::awaitable<boost::json::object> XStationClientStream::listen()
+template <typename ConnectionType>
+boost::asio::awaitable<boost::json::object> BasicXStationClientStream<ConnectionType>::listen()
 {
-    auto result = co_await m_connection->waitResponse();
+    auto result = co_await readWithReconnect(waitResponse);
     co_return result;
 }
 
-boost::asio::awaitable<void> XStationClientStream::getBalance()
+template <typename ConnectionType>
+boost::asio::awaitable<StreamRecord> BasicXStationClientStream<ConnectionType>::listenTyped()
 {
-    boost::json::object command = {
-        {"command", "getBalance"},
-        {"streamSessionId", m_streamSessionId}
-    };
-    co_await m_connection->makeRequest(command);
+    StreamRecord record;
+    while (true)
+    {
+        const std::string_view frame = co_await readWithReconnect(waitFrame);
+        if (parseRecord(frame, record))
+        {
+            co_return record;
+        }
+    }
 }
 
-boost::asio::awaitable<void> XStationClientStream::stopBalance()
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::listenTyped(StreamRecord &record)
 {
-    boost::json::object command = {
-        {"command", "stopBalance"}
-    };
-    co_await m_connection->makeRequest(command);
+    while (true)
+    {
+        const std::string_view frame = co_await readWithReconnect(waitFrame);
+        if (parseRecord(frame, record))
+        {
+            co_return;
+        }
+    }
 }
 
-boost::asio::awaitable<void> XStationClientStream::getCandles(const std::string &symbol)
+template <typename ConnectionType>
+bool BasicXStationClientStream<ConnectionType>::parseRecord(std::string_view frame, StreamRecord &record)
 {
-    boost::json::object command = {
-        {"command", "getCandles"},
-        {"streamSessionId", m_streamSessionId},
-        {"symbol", symbol}
-    };
-    co_await m_connection->makeRequest(command);
+    try
+    {
+        return m_recordParser.parse(frame, record);
+    }
+    catch (const boost::system::system_error &e)
+    {
+        throw exception::ConnectionClosed(e.what());
+    }
 }
 
-boost::asio::awaitable<void> XStationClientStream::stopCandles(const std::string &symbol)
+template <typename ConnectionType>
+boost::asio::awaitable<std::string_view> BasicXStationClientStream<ConnectionType>::listenRaw()
 {
-    boost::json::object command = {
-        {"command", "stopCandles"},
-        {"symbol", symbol}
-    };
-    co_await m_connection->makeRequest(command);
+    // Returns the read coroutine instead of awaiting it, one coroutine frame less per message
+    return readWithReconnect(waitFrame);
 }
 
-boost::asio::awaitable<void> XStationClientStream::getKeepAlive()
+template <typename ConnectionType>
+void BasicXStationClientStream<ConnectionType>::setServerUrl(const std::string &serverUrl)
 {
-    boost::json::object command = {
-        {"command", "getKeepAlive"},
-        {"streamSessionId", m_streamSessionId}
-    };
-    co_await m_connection->makeRequest(command);
+    m_streamUrl = boost::url(serverUrl);
+    m_streamUrl.set_path("/" + m_accountType + "Stream");
 }
 
-boost::asio::awaitable<void> XStationClientStream::stopKeepAlive()
+template <typename ConnectionType>
+void BasicXStationClientStream<ConnectionType>::setStreamSessionId(const std::string &streamSessionId)
 {
-    boost::json::object command = {
-        {"command", "stopKeepAlive"}
-    };
-    co_await m_connection->makeRequest(command);
+    m_streamSessionMember = internals::PrerenderedMember("streamSessionId", streamSessionId);
 }
 
-boost::asio::awaitable<void> XStationClientStream::getNews()
+template <typename ConnectionType>
+void BasicXStationClientStream<ConnectionType>::setReconnectPolicy(const ReconnectPolicy &policy)
 {
-    boost::json::object command = {
-        {"command", "getNews"},
-        {"streamSessionId", m_streamSessionId}
-    };
-    co_await m_connection->makeRequest(command);
+    m_reconnectPolicy = policy;
 }
 
-boost::asio::awaitable<void> XStationClientStream::stopNews()
+template <typename ConnectionType>
+void BasicXStationClientStream<ConnectionType>::setSessionRefresher(
+    std::function<boost::asio::awaitable<std::string>()> refresher)
 {
-    boost::json::object command = {
-        {"command", "stopNews"}
-    };
-    co_await m_connection->makeRequest(command);
+    m_sessionRefresher = std::move(refresher);
 }
 
-boost::asio::awaitable<void> XStationClientStream::getProfits()
+template <typename ConnectionType>
+std::size_t BasicXStationClientStream<ConnectionType>::reconnectCount() const noexcept
 {
-    boost::json::object command = {
-        {"command", "getProfits"},
-        {"streamSessionId", m_streamSessionId}
-    };
-    co_await m_connection->makeRequest(command);
+    return m_reconnectCount;
 }
 
-boost::asio::awaitable<void> XStationClientStream::stopProfits()
+template <typename ConnectionType>
+void BasicXStationClientStream<ConnectionType>::setRecorder(std::shared_ptr<SessionRecorder> recorder)
 {
-    boost::json::object command = {
-        {"command", "stopProfits"}
-    };
-    co_await m_connection->makeRequest(command);
+    m_recorder = std::move(recorder);
+    configureConnection();
 }
 
-boost::asio::awaitable<void> XStationClientStream::getTickPrices(const std::string &symbol, int minArrivalTime, int maxLevel)
+template <typename ConnectionType>
+void BasicXStationClientStream<ConnectionType>::setArenaParsing(bool enabled)
 {
-    boost::json::object command = {
-        {"command", "getTickPrices"},
-        {"streamSessionId", m_streamSessionId},
-        {"symbol", symbol},
-        {"minArrivalTime", minArrivalTime},
-        {"maxLevel", maxLevel}
-    };
-    co_await m_connection->makeRequest(command);
+    m_arenaParsing = enabled;
+    configureConnection();
 }
 
-boost::asio::awaitable<void> XStationClientStream::stopTickPrices(const std::string &symbol)
+template <typename ConnectionType>
+void BasicXStationClientStream<ConnectionType>::configureConnection()
 {
-    boost::json::object command = {
-        {"command", "stopTickPrices"},
-        {"symbol", symbol}
-    };
-    co_await m_connection->makeRequest(command);
+    if (auto *connection = dynamic_cast<internals::Connection *>(m_connection.get()))
+    {
+        connection->setRecorder(m_recorder);
+        connection->setArenaParsing(m_arenaParsing);
+    }
 }
 
-boost::asio::awaitable<void> XStationClientStream::getTrades()
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::getBalance()
 {
-    boost::json::object command = {
-        {"command", "getTrades"},
-        {"streamSessionId", m_streamSessionId}
-    };
-    co_await m_connection->makeRequest(command);
+    co_await subscribe(internals::Subscription("getBalance"));
 }
 
-boost::asio::awaitable<void> XStationClientStream::stopTrades()
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::stopBalance()
 {
-    boost::json::object command = {
-        {"command", "stopTrades"}
-    };
-    co_await m_connection->makeRequest(command);
+    co_await unsubscribe("stopBalance", "getBalance");
 }
 
-boost::asio::awaitable<void> XStationClientStream::getTradeStatus()
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::getCandles(const std::string &symbol)
 {
-    boost::json::object command = {
-        {"command", "getTradeStatus"},
-        {"streamSessionId", m_streamSessionId}
-    };
-    co_await m_connection->makeRequest(command);
+    co_await subscribe(internals::Subscription("getCandles", symbol));
 }
 
-boost::asio::awaitable<void> XStationClientStream::stopTradeStatus()
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::stopCandles(const std::string &symbol)
 {
-    boost::json::object command = {
-        {"command", "stopTradeStatus"}
-    };
-    co_await m_connection->makeRequest(command);
+    co_await unsubscribe("stopCandles", "getCandles", symbol);
 }
 
-boost::asio::awaitable<void> XStationClientStream::ping()
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::getKeepAlive()
 {
-    boost::json::object command = {
-        {"command", "ping"},
-        {"streamSessionId", m_streamSessionId}
-    };
+    co_await subscribe(internals::Subscription("getKeepAlive"));
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::stopKeepAlive()
+{
+    co_await unsubscribe("stopKeepAlive", "getKeepAlive");
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::getNews()
+{
+    co_await subscribe(internals::Subscription("getNews"));
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::stopNews()
+{
+    co_await unsubscribe("stopNews", "getNews");
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::getProfits()
+{
+    co_await subscribe(internals::Subscription("getProfits"));
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::stopProfits()
+{
+    co_await unsubscribe("stopProfits", "getProfits");
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::getTickPrices(
+    const std::string &symbol, int minArrivalTime, int maxLevel)
+{
+    co_await subscribe(internals::Subscription("getTickPrices", symbol, minArrivalTime, maxLevel));
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::stopTickPrices(const std::string &symbol)
+{
+    co_await unsubscribe("stopTickPrices", "getTickPrices", symbol);
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::getTrades()
+{
+    co_await subscribe(internals::Subscription("getTrades"));
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::stopTrades()
+{
+    co_await unsubscribe("stopTrades", "getTrades");
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::getTradeStatus()
+{
+    co_await subscribe(internals::Subscription("getTradeStatus"));
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::stopTradeStatus()
+{
+    co_await unsubscribe("stopTradeStatus", "getTradeStatus");
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::ping()
+{
+    if (!runsOnExecutor(co_await boost::asio::this_coro::executor))
+    {
+        co_return co_await boost::asio::co_spawn(m_executor, ping(), boost::asio::use_awaitable);
+    }
+    internals::Command command("ping");
+    command.add(m_streamSessionMember);
     co_await m_connection->makeRequest(command);
 }
 
+template <typename ConnectionType>
+template <typename Read>
+auto BasicXStationClientStream<ConnectionType>::readWithReconnect(Read read)
+    -> decltype(read(std::declval<ConnectionType &>()))
+{
+    // Connections are only called on the stream strand, this costs no coroutine frame when already there
+    if (!runsOnExecutor(co_await boost::asio::this_coro::executor))
+    {
+        co_return co_await boost::asio::co_spawn(m_executor, readWithReconnect(read), boost::asio::use_awaitable);
+    }
+    while (true)
+    {
+        try
+        {
+            auto result = co_await read(*m_connection);
+            co_return result;
+        }
+        catch (const exception::ConnectionClosed &)
+        {
+            // Without a factory the connection cannot be re-established, retrying would never end
+            if (!m_reconnectPolicy.enabled || m_closed || !m_connectionFactory)
+            {
+                throw;
+            }
+        }
+        co_await reconnect();
+    }
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::reconnect()
+{
+    boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor);
+    std::chrono::milliseconds delay = m_reconnectPolicy.initialDelay;
+    std::string lastError;
+
+    for (std::size_t attempt = 1; m_reconnectPolicy.maxAttempts == 0 || attempt <= m_reconnectPolicy.maxAttempts;
+         ++attempt)
+    {
+        if (attempt > 1)
+        {
+            timer.expires_after(jitteredDelay(delay));
+            co_await timer.async_wait(boost::asio::use_awaitable);
+            const auto next = std::chrono::duration<double, std::milli>(delay) * m_reconnectPolicy.multiplier;
+            delay = std::min(std::chrono::duration_cast<std::chrono::milliseconds>(next), m_reconnectPolicy.maxDelay);
+        }
+
+        try
+        {
+            if (m_sessionRefresher)
+            {
+                setStreamSessionId(co_await m_sessionRefresher());
+            }
+
+            // Close the dropped connection before destroying it, its tasks may still use it
+            try
+            {
+                co_await m_connection->disconnect();
+            }
+            catch (const exception::ConnectionClosed &)
+            {
+                // Already closed
+            }
+            m_connection = m_connectionFactory();
+            configureConnection();
+            co_await m_connection->connect(m_streamUrl);
+            co_await replaySubscriptions();
+            ++m_reconnectCount;
+            co_return;
+        }
+        catch (const exception::ConnectionClosed &e)
+        {
+            lastError = e.what();
+        }
+        catch (const exception::LoginFailed &e)
+        {
+            lastError = e.what();
+        }
+    }
+
+    throw exception::ConnectionClosed("Reconnect failed: " + lastError);
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::replaySubscriptions()
+{
+    // Commands go out back to back, paced only by the rate limiter, no responses are awaited.
+    // Indexed, subscribe() and unsubscribe() may change the registry while a command is sent.
+    for (std::size_t i = 0; i < m_subscriptions.subscriptions().size(); ++i)
+    {
+        const internals::Command command = subscriptionCommand(m_subscriptions.subscriptions()[i]);
+        co_await m_connection->makeRequest(command);
+    }
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::subscribe(internals::Subscription subscription)
+{
+    if (!runsOnExecutor(co_await boost::asio::this_coro::executor))
+    {
+        co_return co_await boost::asio::co_spawn(m_executor, subscribe(std::move(subscription)),
+                                                 boost::asio::use_awaitable);
+    }
+    co_await m_connection->makeRequest(subscriptionCommand(subscription));
+    m_subscriptions.add(std::move(subscription));
+}
+
+template <typename ConnectionType>
+boost::asio::awaitable<void> BasicXStationClientStream<ConnectionType>::unsubscribe(
+    std::string_view command, std::string_view subscribeCommand, const std::string &symbol)
+{
+    if (!runsOnExecutor(co_await boost::asio::this_coro::executor))
+    {
+        co_return co_await boost::asio::co_spawn(m_executor, unsubscribe(command, subscribeCommand, symbol),
+                                                 boost::asio::use_awaitable);
+    }
+    internals::Command stopCommand(command);
+    if (!symbol.empty())
+    {
+        stopCommand.add("symbol", symbol);
+    }
+    co_await m_connection->makeRequest(stopCommand);
+    m_subscriptions.remove(subscribeCommand, symbol);
+}
+
+template <typename ConnectionType>
+internals::Command BasicXStationClientStream<ConnectionType>::subscriptionCommand(
+    const internals::Subscription &subscription) const
+{
+    internals::Command command(subscription.command);
+    command.add(m_streamSessionMember);
+    if (!subscription.symbol.empty())
+    {
+        command.add("symbol", subscription.symbol);
+    }
+    if (subscription.command == "getTickPrices")
+    {
+        command.add("minArrivalTime", subscription.minArrivalTime)
+            .add("maxLevel", subscription.maxLevel);
+    }
+    return command;
+}
+
+template <typename ConnectionType>
+std::chrono::milliseconds BasicXStationClientStream<ConnectionType>::jitteredDelay(std::chrono::milliseconds delay)
+{
+    const double jitter = std::clamp(m_reconnectPolicy.jitter, 0.0, 1.0);
+    std::uniform_real_distribution<double> spread(1.0 - jitter, 1.0 + jitter);
+    return std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(delay.count() * spread(m_random)));
+}
+
+template class BasicXStationClientStream<internals::IConnection>;
+template class BasicXStationClientStream<internals::Connection>;
+
 } // namespace xapi
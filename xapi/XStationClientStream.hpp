@@ -4,11 +4,19 @@
  * @file XStationClientStream.hpp
  * @brief Defines the XStationClientStream class for managing streaming commands.
  *
- * This file contains the definition of the XStationClientStream class, which encapsulates
- * streaming operations for real-time streaming data.
+ * This file contains the definition of the BasicXStationClientStream class template, which
+ * encapsulates streaming operations for real-time streaming data, and its XStationClientStream
+ * and DirectXStationClientStream variants.
  */
 
 #include "Connection.hpp"
+#include "StreamRecordParser.hpp"
+#include "StreamRecords.hpp"
+#include "SubscriptionRegistry.hpp"
+#include <chrono>
+#include <functional>
+#include <random>
+#include <utility>
 
 #undef TEST_FRIENDS
 #ifdef ENABLE_TEST
@@ -23,29 +31,82 @@ class XStationClientStreamTest;
 namespace xapi
 {
 
+/**
+ * @brief Describes how a client stream re-establishes a dropped connection.
+ *
+ * The first attempt is made immediately, the following ones after a delay growing
+ * from initialDelay by multiplier up to maxDelay, randomized by +/- jitter.
+ */
+struct ReconnectPolicy
+{
+    // Reconnect automatically when the connection drops.
+    bool enabled = false;
+
+    std::chrono::milliseconds initialDelay{100};
+    std::chrono::milliseconds maxDelay{10000};
+    double multiplier = 2.0;
+
+    // Fraction of the delay used as random spread, from 0.0 to 1.0.
+    double jitter = 0.2;
+
+    // Number of attempts before giving up, 0 means no limit.
+    std::size_t maxAttempts = 0;
+};
+
 /**
  * @brief Encapsulates operations for streaming real-time data from xAPI.
  *
- * The XStationClientStream class provides a high-level interface for streaming real-time data
- * from xAPI.
+ * The BasicXStationClientStream class provides a high-level interface for streaming real-time data
+ * from xAPI. It reaches the transport through ConnectionType: internals::IConnection accepts any
+ * connection, internals::Connection calls the WebSocket connection without virtual dispatch.
+ * @tparam ConnectionType internals::IConnection or internals::Connection.
  */
-class XStationClientStream
+template <typename ConnectionType> class BasicXStationClientStream
 {
   public:
-    XStationClientStream() = delete;
+    BasicXStationClientStream() = delete;
 
-    XStationClientStream(const XStationClientStream &) = delete;
-    XStationClientStream &operator=(const XStationClientStream &) = delete;
+    BasicXStationClientStream(const BasicXStationClientStream &) = delete;
+    BasicXStationClientStream &operator=(const BasicXStationClientStream &) = delete;
 
-    XStationClientStream(XStationClientStream &&other) = default;
-    XStationClientStream &operator=(XStationClientStream &&other) = delete;
+    BasicXStationClientStream(BasicXStationClientStream &&other) = default;
+    BasicXStationClientStream &operator=(BasicXStationClientStream &&other) = delete;
 
     /**
-     * @brief Constructs a new XStationClientStream object.
+     * @brief Constructs a new BasicXStationClientStream object.
+     *
+     * The connections of the stream, including the ones made when it reconnects, run on one
+     * strand of the IO context, see executor().
      * @param ioContext The IO context for asynchronous operations.
+     * @param accountType The type of account, `"demo"` or `"real"`.
+     * @param streamSessionId The stream session ID received at login.
+     * @param rateLimiter Rate limiter shared with the main connection, if null the stream uses its own.
+     * @param tlsContext TLS context shared with the main connection, if null the stream uses its own.
+     */
+    explicit BasicXStationClientStream(boost::asio::io_context &ioContext, const std::string &accountType,
+                                       const std::string &streamSessionId,
+                                       std::shared_ptr<internals::RateLimiter> rateLimiter = nullptr,
+                                       std::shared_ptr<internals::TlsContext> tlsContext = nullptr);
+
+    /**
+     * @brief Constructs a stream reading from a given connection, for example a ReplayConnection.
+     *
+     * The stream is not reconnected when the connection drops.
+     * @param connection The connection to read from.
      */
-    explicit XStationClientStream(boost::asio::io_context &ioContext, const std::string &accountType, const std::string& streamSessionId);
-    ~XStationClientStream() = default;
+    explicit BasicXStationClientStream(std::unique_ptr<ConnectionType> connection);
+
+    ~BasicXStationClientStream() = default;
+
+    /**
+     * @brief Gets the strand the connections of the stream run on.
+     *
+     * The stream itself is not synchronized, it has to be used by one coroutine at a time.
+     * A coroutine spawned on this executor calls the connection directly, calls from other
+     * coroutines are moved to the strand, which costs a coroutine spawn on every read.
+     * @return The strand, or an empty executor for a stream constructed from a given connection.
+     */
+    const boost::asio::any_io_executor &executor() const noexcept;
 
     /**
      * @brief Opens a connection to the streaming server.
@@ -67,6 +128,90 @@ class XStationClientStream
      */
     boost::asio::awaitable<boost::json::object> listen();
 
+    /**
+     * @brief Waits for the next streaming record, parsed straight into a typed record.
+     *
+     * Messages that are not streaming records are skipped.
+     * @return An awaitable StreamRecord holding the record matching the message command.
+     * @throw xapi::exception::ConnectionClosed if the connection fails or the message is not valid JSON.
+     */
+    boost::asio::awaitable<StreamRecord> listenTyped();
+
+    /**
+     * @brief Waits for the next streaming record, parsed into the given record.
+     *
+     * Reusing the same record keeps the capacity of its strings, so that steady-state reads
+     * do not allocate. Messages that are not streaming records are skipped.
+     * @param record The record to parse into.
+     * @return An awaitable void.
+     * @throw xapi::exception::ConnectionClosed if the connection fails or the message is not valid JSON.
+     */
+    boost::asio::awaitable<void> listenTyped(StreamRecord &record);
+
+    /**
+     * @brief Waits for the next streaming message without parsing it.
+     * @return An awaitable view of the raw message, valid until the next message is read.
+     * @throw xapi::exception::ConnectionClosed if the connection fails.
+     */
+    boost::asio::awaitable<std::string_view> listenRaw();
+
+    /**
+     * @brief Sets the server to connect to, used by the next open() or reconnect.
+     * @param serverUrl The server URL without path, by default `wss://ws.xtb.com`.
+     */
+    void setServerUrl(const std::string &serverUrl);
+
+    /**
+     * @brief Sets the stream session ID used by the subscription commands.
+     * @param streamSessionId The stream session ID received at login.
+     */
+    void setStreamSessionId(const std::string &streamSessionId);
+
+    /**
+     * @brief Sets the reconnect policy.
+     *
+     * With reconnect enabled, listen(), listenTyped() and listenRaw() do not fail when the
+     * connection drops. They reconnect, refresh the stream session, replay all active
+     * subscriptions and continue reading from the new connection. A stream constructed from a
+     * given connection cannot re-establish it, its reads fail when the connection drops.
+     * @param policy The reconnect policy.
+     */
+    void setReconnectPolicy(const ReconnectPolicy &policy);
+
+    /**
+     * @brief Sets the function used to obtain a valid stream session ID when reconnecting.
+     *
+     * XStationClient::getClientStream() sets it to re-validate the session of the client.
+     * @param refresher The function returning the stream session ID to use.
+     */
+    void setSessionRefresher(std::function<boost::asio::awaitable<std::string>()> refresher);
+
+    /**
+     * @brief Gets the number of successful reconnects.
+     * @return The number of reconnects since the stream was created.
+     */
+    std::size_t reconnectCount() const noexcept;
+
+    /**
+     * @brief Records every message received by the stream, also after reconnects.
+     *
+     * The connection reads on the stream strand, so call it before open() or from a coroutine
+     * running on executor().
+     * @param recorder The journal recorder, null to stop recording.
+     */
+    void setRecorder(std::shared_ptr<SessionRecorder> recorder);
+
+    /**
+     * @brief Enables or disables parsing of listen() messages into a per-connection arena.
+     *
+     * When enabled, the objects returned by listen() are only valid until the next message is read.
+     * Keep one longer by copying it with an explicit storage, a plain copy shares the arena:
+     * boost::json::object(object, boost::json::storage_ptr()). Kept across reconnects. Call it
+     * before open() or from a coroutine running on executor(), like setRecorder().
+     * @param enabled true/false to enable/disable arena parsing.
+     */
+    void setArenaParsing(bool enabled);
+
     // Other methods omitted for brevity.
     // Description of the omitted methods: http://developers.xstore.pro/documentation/2.5.0#retrieving-trading-data
 
@@ -105,13 +250,126 @@ class XStationClientStream
     boost::asio::awaitable<void> ping();
 
   private:
-    std::unique_ptr<internals::IConnection> m_connection;
+    std::unique_ptr<ConnectionType> m_connection;
+
+    // Strand shared by the connections made by the factory.
+    boost::asio::any_io_executor m_executor;
 
-    // The stream session ID.
-    const boost::url m_streamUrl;
-    const std::string m_streamSessionId;
+    // Creates the connection used after the current one drops, empty for a stream made from a given connection.
+    std::function<std::unique_ptr<ConnectionType>()> m_connectionFactory;
+
+    // Parser of streaming messages into typed records.
+    internals::StreamRecordParser m_recordParser;
+
+    // The stream account type, `"demo"` or `"real"`.
+    std::string m_accountType;
+
+    // The stream URL.
+    boost::url m_streamUrl;
+
+    // The stream session ID, rendered once and copied into every subscription command.
+    internals::PrerenderedMember m_streamSessionMember;
+
+    // Subscriptions replayed after reconnect.
+    internals::SubscriptionRegistry m_subscriptions;
+
+    ReconnectPolicy m_reconnectPolicy;
+
+    std::function<boost::asio::awaitable<std::string>()> m_sessionRefresher;
+
+    // Random engine for the reconnect delay jitter.
+    std::minstd_rand m_random;
+
+    std::size_t m_reconnectCount;
+
+    // Set by close(), so that the closed connection is not reopened.
+    bool m_closed;
+
+    // Journal of received messages, set on every new connection.
+    std::shared_ptr<SessionRecorder> m_recorder;
+
+    // Whether listen() parses into the connection arena, set on every new connection.
+    bool m_arenaParsing;
+
+    /**
+     * @brief Checks whether a coroutine can call the connection directly.
+     * @param executor The executor of the coroutine.
+     * @return True if the coroutine runs on the stream strand, or the stream has none.
+     */
+    bool runsOnExecutor(const boost::asio::any_io_executor &executor) const noexcept;
+
+    // Passes the recorder and the arena setting to the current connection, if it is a server connection.
+    void configureConnection();
+
+    /**
+     * @brief Parses a message into a record.
+     * @param frame The raw message.
+     * @param record The record to parse into.
+     * @return True if the message is a streaming record.
+     * @throw xapi::exception::ConnectionClosed if the message is not valid JSON.
+     */
+    bool parseRecord(std::string_view frame, StreamRecord &record);
+
+    /**
+     * @brief Reads from the connection, reconnecting if it drops and reconnect is enabled.
+     * @param read Called with the connection, returns the awaitable read.
+     * @return An awaitable with the read result.
+     * @throw xapi::exception::ConnectionClosed if the connection fails and cannot be re-established.
+     */
+    template <typename Read> auto readWithReconnect(Read read) -> decltype(read(std::declval<ConnectionType &>()));
+
+    /**
+     * @brief Re-establishes the connection according to the reconnect policy and replays subscriptions.
+     * @return An awaitable void.
+     * @throw xapi::exception::ConnectionClosed if all reconnect attempts fail.
+     */
+    boost::asio::awaitable<void> reconnect();
+
+    /**
+     * @brief Sends the subscription commands of all active subscriptions.
+     * @return An awaitable void.
+     */
+    boost::asio::awaitable<void> replaySubscriptions();
+
+    /**
+     * @brief Sends a subscription command and records the subscription.
+     * @param subscription The subscription to start.
+     * @return An awaitable void.
+     */
+    boost::asio::awaitable<void> subscribe(internals::Subscription subscription);
+
+    /**
+     * @brief Sends a stop command and forgets the subscription.
+     * @param command The stop command.
+     * @param subscribeCommand The command that started the subscription.
+     * @param symbol The symbol, empty for subscriptions without symbol.
+     * @return An awaitable void.
+     */
+    boost::asio::awaitable<void> unsubscribe(std::string_view command, std::string_view subscribeCommand,
+                                             const std::string &symbol = {});
+
+    // Builds the subscription command of an active subscription.
+    internals::Command subscriptionCommand(const internals::Subscription &subscription) const;
+
+    // Computes the delay before the next reconnect attempt.
+    std::chrono::milliseconds jitteredDelay(std::chrono::milliseconds delay);
 
     TEST_FRIENDS
 };
 
+/**
+ * @brief Stream reaching the connection through internals::IConnection.
+ *
+ * Accepts any connection, for example a ReplayConnection or a mock in tests.
+ */
+using XStationClientStream = BasicXStationClientStream<internals::IConnection>;
+
+/**
+ * @brief Stream calling the WebSocket connection directly, without virtual dispatch.
+ */
+using DirectXStationClientStream = BasicXStationClientStream<internals::Connection>;
+
+extern template class BasicXStationClientStream<internals::IConnection>;
+extern template class BasicXStationClientStream<internals::Connection>;
+
 } // namespace xapi
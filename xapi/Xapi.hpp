@@ -2,7 +2,20 @@
 
 // General xapi header
 
+#include "CandleAggregator.hpp"
+#include "CandleStore.hpp"
 #include "Enums.hpp"
 #include "Exceptions.hpp"
+#include "HistoryDownloader.hpp"
+#include "MarketDataPump.hpp"
+#include "Metrics.hpp"
+#include "QuoteCache.hpp"
+#include "ReplayConnection.hpp"
+#include "RingBuffer.hpp"
+#include "SessionRecorder.hpp"
+#include "StreamDispatcher.hpp"
+#include "StreamRecords.hpp"
+#include "SymbolCatalog.hpp"
+#include "TickConflator.hpp"
 #include "XStationClient.hpp"
 #include "XStationClientStream.hpp"